@@ -6,10 +6,37 @@
 //  - Jump: Spacebar
 //  - Camera: 1=Follow (semi top-down), 2=Top view, 3=Side view, 4=Front view, V=cycle
 //  - Camera free move: I/K (forward/back), J/L (left/right), U/O (down/up)
+//  - Multi-view (follow, top, side and front quadrants): M
 //  - Pause/unpause animations (animations auto-start when collectibles are collected):
 //      R = Red platform (rotation), B = Blue platform (scaling),
 //      G = Green platform (translation), Y = Yellow platform (color change)
 //  - Reset game: ESC
+//  - Rewind (hold): Z
+//  - Bot autopilot (walks to the nearest collectible): P
+//  - Low-power redraw mode: F
+//  - Input latency overlay: H (summaries are also logged to stdout)
+// Command line:
+//  --env-bench [instances] [steps]  headless batched-environment throughput and pickup/timeout/reset check
+//  --nav-bench [queries]            navigation graph build and path query throughput
+//  --alloc-check                    verify ticks and restarts perform no heap allocations
+//                                   (needs a build with -DALLOC_CHECK=1)
+//  --particle-bench [count] [ticks] particle kernel throughput
+//  --bvh-bench [queries]            world BVH casts and support-map queries vs. a linear scan
+//  --rewind-check                   verify snapshot rewind, replay and restart are exact
+//  --stream-bench [distance]        streamed-world loading, eviction and origin rebasing
+//  --timer-bench [timers]           timer wheel scheduling/firing vs. per-tick polling
+//  --raster-bench [frames] [out.ppm] tiled software rasterizer vs. GL at 1280x720
+//  --occlusion-bench [frames]       occlusion culling rate and cost; checks images are unchanged
+//  --math-check [points]           SIMD vector math vs. scalar reference; point transform timing
+//  --fps N                          target frame rate (0 = uncapped, default 60)
+//  --low-power                      start in low-power redraw mode
+//  --stream-budget MB               memory budget for streamed world chunks (default 8)
+//  --telemetry [/name]              publish tick/frame metrics to POSIX shared memory
+//                                   (default /p01_telemetry; read with tools/telemetry_reader)
+//  --gl33                           OpenGL 3.3 core profile renderer (static buffers, instancing)
+//  --quality N                      pin the quality level (0 = full detail .. 4) instead of
+//                                   adapting it to hold the target frame rate
+//  --occlusion                      cull features, oracles and collectibles behind large occluders
 // Notes:
 //  - Everything is built from OpenGL primitives (quads/triangles). No imported models.
 //  - Uses GLUT for windowing/input and GLU for camera.
@@ -17,11 +44,32 @@
 #ifdef _WIN32
 #include <windows.h>
 #endif
+
+// Optional OpenGL 3.3 core backend (--gl33): needs the GL library to export the 3.3 entry
+// points (Mesa and the vendor drivers on Linux) and freeglut to create the context
+#ifndef USE_GL33
+#  if defined(__linux__) && defined(__has_include)
+#    if __has_include(<GL/freeglut_ext.h>)
+#      define USE_GL33 1
+#    else
+#      define USE_GL33 0
+#    endif
+#  else
+#    define USE_GL33 0
+#  endif
+#endif
+#if USE_GL33
+#define GL_GLEXT_PROTOTYPES 1
+#endif
+
 #ifdef __APPLE__
 #include <GLUT/glut.h>
 #else
 #include <GL/glut.h>
 #endif
+#if USE_GL33
+#include <GL/freeglut_ext.h>
+#endif
 // GLU for camera
 
 #include <cmath>
@@ -31,6 +79,14 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <new>
 
 // Optional audio: compile-time/header-availability guard for single-file submission
 #ifndef USE_MINIAUDIO
@@ -45,11 +101,36 @@
 #  endif
 #endif
 
+// Allocation-counting operator new for --alloc-check; off so the game keeps the stock allocator
+#ifndef ALLOC_CHECK
+#  define ALLOC_CHECK 0
+#endif
+
 #if USE_MINIAUDIO
 #define MINIAUDIO_IMPLEMENTATION
 #include "third_party/miniaudio.h"
 #endif
 
+// SIMD lanes for the batch kernels: SSE2 on x86-64, NEON on ARM, scalar otherwise
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define SIMD_NEON 1
+#endif
+
+// Shared-memory telemetry needs POSIX shm_open/mmap
+#if defined(__unix__) || defined(__APPLE__)
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  define TELEMETRY_SHM 1
+#else
+#  define TELEMETRY_SHM 0
+#endif
+
 static constexpr float PI_F = 3.14159265358979323846f;
 
 // --------------------------- Math helpers ---------------------------
@@ -76,6 +157,395 @@ static inline float dist2XZ(const Vec3&a, const Vec3&b){
     float dx=a.x-b.x, dz=a.z-b.z; return dx*dx+dz*dz;
 } //. calculates the distance for in xy plane ignoring height y
 
+// --------------------------- SIMD lanes ---------------------------
+// Four-wide float operations used by the batch kernels. Pointers passed to f4Load/f4Store
+// must be 16-byte aligned. Comparisons return all-ones/all-zeros lane masks for f4Select.
+// u8x16 holds four packed RGBA8 pixels (unaligned loads/stores) for the rasterizer.
+#if SIMD_SSE2
+typedef __m128 f4;
+static inline f4 f4Load(const float* p){ return _mm_load_ps(p); }
+static inline void f4Store(float* p, f4 v){ _mm_store_ps(p, v); }
+static inline f4 f4Set1(float v){ return _mm_set1_ps(v); }
+static inline f4 f4Set4(float a, float b, float c, float d){ return _mm_setr_ps(a, b, c, d); }
+static inline void f4Transpose(f4& a, f4& b, f4& c, f4& d){ _MM_TRANSPOSE4_PS(a, b, c, d); }
+static inline f4 f4Add(f4 a, f4 b){ return _mm_add_ps(a, b); }
+static inline f4 f4Sub(f4 a, f4 b){ return _mm_sub_ps(a, b); }
+static inline f4 f4Mul(f4 a, f4 b){ return _mm_mul_ps(a, b); }
+static inline f4 f4Max(f4 a, f4 b){ return _mm_max_ps(a, b); }
+static inline f4 f4Less(f4 a, f4 b){ return _mm_cmplt_ps(a, b); }
+static inline f4 f4Select(f4 mask, f4 a, f4 b){ return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline f4 f4Min(f4 a, f4 b){ return _mm_min_ps(a, b); }
+static inline f4 f4And(f4 a, f4 b){ return _mm_and_ps(a, b); }
+static inline bool f4Any(f4 mask){ return _mm_movemask_ps(mask) != 0; }
+typedef __m128i u8x16;
+static inline u8x16 u8Load(const void* p){ return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+static inline void u8Store(void* p, u8x16 v){ _mm_storeu_si128(static_cast<__m128i*>(p), v); }
+static inline u8x16 u8Set4(uint32_t pixel){ return _mm_set1_epi32((int)pixel); }
+static inline u8x16 u8AddSat(u8x16 a, u8x16 b){ return _mm_adds_epu8(a, b); }
+static inline u8x16 u8Select(f4 mask, u8x16 a, u8x16 b){ __m128i m = _mm_castps_si128(mask); return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+#elif SIMD_NEON
+typedef float32x4_t f4;
+static inline f4 f4Load(const float* p){ return vld1q_f32(p); }
+static inline void f4Store(float* p, f4 v){ vst1q_f32(p, v); }
+static inline f4 f4Set1(float v){ return vdupq_n_f32(v); }
+static inline f4 f4Set4(float a, float b, float c, float d){ const float t[4] = {a, b, c, d}; return vld1q_f32(t); }
+static inline void f4Transpose(f4& a, f4& b, f4& c, f4& d){
+    float32x4x2_t ab = vtrnq_f32(a, b), cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+static inline f4 f4Add(f4 a, f4 b){ return vaddq_f32(a, b); }
+static inline f4 f4Sub(f4 a, f4 b){ return vsubq_f32(a, b); }
+static inline f4 f4Mul(f4 a, f4 b){ return vmulq_f32(a, b); }
+static inline f4 f4Max(f4 a, f4 b){ return vmaxq_f32(a, b); }
+static inline f4 f4Less(f4 a, f4 b){ return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+static inline f4 f4Select(f4 mask, f4 a, f4 b){ return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+static inline f4 f4Min(f4 a, f4 b){ return vminq_f32(a, b); }
+static inline f4 f4And(f4 a, f4 b){ return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+static inline bool f4Any(f4 mask){ uint32x4_t m = vreinterpretq_u32_f32(mask); return (vgetq_lane_u32(m,0) | vgetq_lane_u32(m,1) | vgetq_lane_u32(m,2) | vgetq_lane_u32(m,3)) != 0; }
+typedef uint8x16_t u8x16;
+static inline u8x16 u8Load(const void* p){ return vld1q_u8(static_cast<const uint8_t*>(p)); }
+static inline void u8Store(void* p, u8x16 v){ vst1q_u8(static_cast<uint8_t*>(p), v); }
+static inline u8x16 u8Set4(uint32_t pixel){ return vreinterpretq_u8_u32(vdupq_n_u32(pixel)); }
+static inline u8x16 u8AddSat(u8x16 a, u8x16 b){ return vqaddq_u8(a, b); }
+static inline u8x16 u8Select(f4 mask, u8x16 a, u8x16 b){ return vbslq_u8(vreinterpretq_u8_f32(mask), a, b); }
+#else
+struct f4 { float v[4]; };
+static inline f4 f4Load(const float* p){ f4 r; for(int i=0;i<4;i++) r.v[i]=p[i]; return r; }
+static inline void f4Store(float* p, f4 v){ for(int i=0;i<4;i++) p[i]=v.v[i]; }
+static inline f4 f4Set1(float x){ f4 r; for(int i=0;i<4;i++) r.v[i]=x; return r; }
+static inline f4 f4Set4(float a, float b, float c, float d){ f4 r = {{a, b, c, d}}; return r; }
+static inline void f4Transpose(f4& a, f4& b, f4& c, f4& d){
+    f4* rows[4] = {&a, &b, &c, &d};
+    for(int i=0;i<4;i++) for(int j=i+1;j<4;j++) std::swap(rows[i]->v[j], rows[j]->v[i]);
+}
+static inline f4 f4Add(f4 a, f4 b){ for(int i=0;i<4;i++) a.v[i]+=b.v[i]; return a; }
+static inline f4 f4Sub(f4 a, f4 b){ for(int i=0;i<4;i++) a.v[i]-=b.v[i]; return a; }
+static inline f4 f4Mul(f4 a, f4 b){ for(int i=0;i<4;i++) a.v[i]*=b.v[i]; return a; }
+static inline f4 f4Max(f4 a, f4 b){ for(int i=0;i<4;i++) a.v[i]=std::max(a.v[i], b.v[i]); return a; }
+static inline f4 f4Less(f4 a, f4 b){ f4 r; for(int i=0;i<4;i++){ uint32_t m = a.v[i]<b.v[i] ? 0xFFFFFFFFu : 0u; std::memcpy(&r.v[i], &m, 4); } return r; }
+static inline f4 f4Select(f4 mask, f4 a, f4 b){
+    for(int i=0;i<4;i++){ uint32_t m; std::memcpy(&m, &mask.v[i], 4); if(!m) a.v[i]=b.v[i]; }
+    return a;
+}
+static inline f4 f4Min(f4 a, f4 b){ for(int i=0;i<4;i++) a.v[i]=std::min(a.v[i], b.v[i]); return a; }
+static inline f4 f4And(f4 a, f4 b){
+    for(int i=0;i<4;i++){ uint32_t x, y; std::memcpy(&x, &a.v[i], 4); std::memcpy(&y, &b.v[i], 4); x &= y; std::memcpy(&a.v[i], &x, 4); }
+    return a;
+}
+static inline bool f4Any(f4 mask){ uint32_t m[4]; std::memcpy(m, mask.v, 16); return (m[0] | m[1] | m[2] | m[3]) != 0; }
+struct u8x16 { uint8_t v[16]; };
+static inline u8x16 u8Load(const void* p){ u8x16 r; std::memcpy(r.v, p, 16); return r; }
+static inline void u8Store(void* p, u8x16 v){ std::memcpy(p, v.v, 16); }
+static inline u8x16 u8Set4(uint32_t pixel){ u8x16 r; for(int i=0;i<4;i++) std::memcpy(r.v + 4*i, &pixel, 4); return r; }
+static inline u8x16 u8AddSat(u8x16 a, u8x16 b){ for(int i=0;i<16;i++) a.v[i] = (uint8_t)std::min(255, a.v[i] + b.v[i]); return a; }
+static inline u8x16 u8Select(f4 mask, u8x16 a, u8x16 b){
+    for(int i=0;i<4;i++){ uint32_t m; std::memcpy(&m, &mask.v[i], 4); if(!m) std::memcpy(a.v + 4*i, b.v + 4*i, 4); }
+    return a;
+}
+#endif
+
+// floor() for |x| < 2^22: round to nearest with the 1.5*2^23 trick, then step down where that rounded up
+static inline f4 f4Floor(f4 x){
+    const f4 magic = f4Set1(12582912.0f);
+    f4 r = f4Sub(f4Add(x, magic), magic);
+    return f4Select(f4Less(x, r), f4Sub(r, f4Set1(1.0f)), r);
+}
+
+// sin() for |x| < 2^22: reduce to [-pi, pi], fold into [-pi/2, pi/2], odd series to x^11 (error < 1e-6)
+static inline f4 f4Sin(f4 x){
+    const f4 zero = f4Set1(0.0f), pi = f4Set1(PI_F), halfPi = f4Set1(0.5f*PI_F);
+    f4 k = f4Floor(f4Add(f4Mul(x, f4Set1(0.5f/PI_F)), f4Set1(0.5f)));
+    x = f4Sub(f4Sub(x, f4Mul(k, f4Set1(6.28125f))), f4Mul(k, f4Set1(1.9353071795864769e-3f))); // 2*pi split in two
+    x = f4Select(f4Less(halfPi, x), f4Sub(pi, x), x);
+    x = f4Select(f4Less(x, f4Sub(zero, halfPi)), f4Sub(f4Sub(zero, pi), x), x);
+    f4 x2 = f4Mul(x, x);
+    f4 p = f4Set1(-2.5052108e-8f);
+    p = f4Add(f4Mul(p, x2), f4Set1(2.7557319e-6f));
+    p = f4Add(f4Mul(p, x2), f4Set1(-1.9841270e-4f));
+    p = f4Add(f4Mul(p, x2), f4Set1(8.3333333e-3f));
+    p = f4Add(f4Mul(p, x2), f4Set1(-1.6666667e-1f));
+    p = f4Add(f4Mul(p, x2), f4Set1(1.0f));
+    return f4Mul(p, x);
+}
+
+// --------------------------- Vector math ---------------------------
+// Aligned Vec4 and Mat4 (column-major like GL: m[c*4+r]) for CPU-side transforms; the
+// software and core profile matrix stacks, frustum extraction, the occlusion buffer and
+// the CPU vertex transforms all go through them. Each f4 kernel has a *Scalar reference
+// that evaluates the same products and sums in the same order, so the two agree to the
+// bit as long as the compiler does not fuse multiply-adds (x86-64 builds never do by
+// default; ARM builds need -ffp-contract=off). --math-check verifies that.
+struct alignas(16) Vec4 { float x, y, z, w; };
+struct alignas(16) Mat4 { float m[16]; };
+
+static inline Vec4 makeVec4(const Vec3& v, float w){ return {v.x, v.y, v.z, w}; }
+static inline Vec4 add(const Vec4& a, const Vec4& b){ Vec4 r; f4Store(&r.x, f4Add(f4Load(&a.x), f4Load(&b.x))); return r; }
+static inline Vec4 sub(const Vec4& a, const Vec4& b){ Vec4 r; f4Store(&r.x, f4Sub(f4Load(&a.x), f4Load(&b.x))); return r; }
+static inline Vec4 mul(const Vec4& a, float s){ Vec4 r; f4Store(&r.x, f4Mul(f4Load(&a.x), f4Set1(s))); return r; }
+
+static inline Mat4 mat4Identity(){
+    Mat4 r;
+    for(int i=0;i<16;i++) r.m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+    return r;
+}
+static inline Mat4 mat4Translation(float x, float y, float z){ Mat4 r = mat4Identity(); r.m[12] = x; r.m[13] = y; r.m[14] = z; return r; }
+static inline Mat4 mat4Scaling(float x, float y, float z){ Mat4 r = mat4Identity(); r.m[0] = x; r.m[5] = y; r.m[10] = z; return r; }
+
+// glRotate: deg degrees about (x, y, z), which need not be unit length; a zero axis gives the identity
+static inline Mat4 mat4Rotation(float deg, float x, float y, float z){
+    Mat4 r = mat4Identity();
+    float len = std::sqrt(x*x + y*y + z*z);
+    if(len <= 0.0f) return r;
+    x /= len; y /= len; z /= len;
+    float a = deg * PI_F / 180.0f, c = cosf(a), s = sinf(a), k = 1.0f - c;
+    float* m = r.m;
+    m[0] = x*x*k + c;   m[4] = x*y*k - z*s; m[8]  = x*z*k + y*s;
+    m[1] = y*x*k + z*s; m[5] = y*y*k + c;   m[9]  = y*z*k - x*s;
+    m[2] = x*z*k - y*s; m[6] = y*z*k + x*s; m[10] = z*z*k + c;
+    return r;
+}
+
+// a*b; each element is summed from zero over k in order
+static inline Mat4 mat4MulScalar(const Mat4& a, const Mat4& b){
+    Mat4 out;
+    for(int c=0;c<4;c++) for(int r=0;r<4;r++){
+        float sum = 0.0f;
+        for(int k=0;k<4;k++) sum += a.m[k*4+r] * b.m[c*4+k];
+        out.m[c*4+r] = sum;
+    }
+    return out;
+}
+
+static inline Mat4 mat4Mul(const Mat4& a, const Mat4& b){
+    const f4 a0 = f4Load(a.m), a1 = f4Load(a.m + 4), a2 = f4Load(a.m + 8), a3 = f4Load(a.m + 12), zero = f4Set1(0.0f);
+    Mat4 out;
+    for(int c=0;c<4;c++){
+        const float* bc = b.m + c*4;
+        f4 sum = f4Add(zero, f4Mul(a0, f4Set1(bc[0])));
+        sum = f4Add(sum, f4Mul(a1, f4Set1(bc[1])));
+        sum = f4Add(sum, f4Mul(a2, f4Set1(bc[2])));
+        sum = f4Add(sum, f4Mul(a3, f4Set1(bc[3])));
+        f4Store(out.m + c*4, sum);
+    }
+    return out;
+}
+
+// m*(p, 1), the columns summed left to right
+static inline Vec4 mat4TransformScalar(const Mat4& m, const Vec3& p){
+    const float* a = m.m;
+    return { a[0]*p.x + a[4]*p.y + a[8]*p.z  + a[12],
+             a[1]*p.x + a[5]*p.y + a[9]*p.z  + a[13],
+             a[2]*p.x + a[6]*p.y + a[10]*p.z + a[14],
+             a[3]*p.x + a[7]*p.y + a[11]*p.z + a[15] };
+}
+
+static inline f4 mat4TransformLanes(f4 c0, f4 c1, f4 c2, f4 c3, float x, float y, float z){
+    return f4Add(f4Add(f4Add(f4Mul(c0, f4Set1(x)), f4Mul(c1, f4Set1(y))), f4Mul(c2, f4Set1(z))), c3);
+}
+
+static inline Vec4 mat4Transform(const Mat4& m, const Vec3& p){
+    Vec4 r;
+    f4Store(&r.x, mat4TransformLanes(f4Load(m.m), f4Load(m.m + 4), f4Load(m.m + 8), f4Load(m.m + 12), p.x, p.y, p.z));
+    return r;
+}
+
+// n points (three floats each) read stride bytes apart, transformed as (p, 1). A plain
+// loop: the compiler vectorizes it on its own, and hand-written f4 versions that gathered
+// four points into lanes were slower
+static inline void transformPoints(const Mat4& m, const float* xyz, size_t stride, int n, Vec4* out){
+    for(int i=0;i<n;i++){
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(xyz) + (size_t)i * stride);
+        out[i] = mat4TransformScalar(m, {p[0], p[1], p[2]});
+    }
+}
+
+// --------------------------- Worker pool ---------------------------
+// Small fork-join pool: parallelFor() splits [0,count) into grain-sized chunks that the
+// calling thread and the workers pull from a shared counter. The job is passed as a raw
+// function pointer + context so dispatching never allocates.
+class JobPool {
+public:
+    explicit JobPool(int workerCount){
+        for(int i=0;i<workerCount;i++) workers.emplace_back(&JobPool::workerLoop, this);
+    }
+    ~JobPool(){
+        { std::lock_guard<std::mutex> lock(m); stopping = true; }
+        cvWork.notify_all();
+        for(auto&t : workers) t.join();
+    }
+    int threadCount() const { return (int)workers.size() + 1; }
+
+    template<class Fn>
+    void parallelFor(int count, int grain, Fn& fn){
+        run(count, grain, &invokeRange<Fn>, &fn);
+    }
+
+private:
+    typedef void (*RangeFn)(void*, int, int);
+    template<class Fn> static void invokeRange(void* ctx, int begin, int end){ (*static_cast<Fn*>(ctx))(begin, end); }
+
+    void run(int count, int grain, RangeFn fn, void* ctx){
+        if(count<=0) return;
+        grain = std::max(1, grain);
+        if(workers.empty() || count<=grain){ fn(ctx, 0, count); return; }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            jobFn = fn; jobCtx = ctx; jobCount = count; jobGrain = grain;
+            nextIndex.store(0);
+            busyWorkers = (int)workers.size();
+            generation++;
+        }
+        cvWork.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lock(m);
+        cvDone.wait(lock, [&]{ return busyWorkers==0; });
+    }
+
+    void drain(){
+        for(;;){
+            int begin = nextIndex.fetch_add(jobGrain);
+            if(begin>=jobCount) break;
+            jobFn(jobCtx, begin, std::min(jobCount, begin+jobGrain));
+        }
+    }
+
+    void workerLoop(){
+        unsigned seen = 0;
+        for(;;){
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cvWork.wait(lock, [&]{ return stopping || generation!=seen; });
+                if(stopping) return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(m);
+            if(--busyWorkers==0) cvDone.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable cvWork, cvDone;
+    RangeFn jobFn = nullptr;
+    void* jobCtx = nullptr;
+    int jobCount = 0, jobGrain = 1, busyWorkers = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+    std::atomic<int> nextIndex{0};
+};
+
+// Shared pool sized to the machine (calling thread counts as one of the lanes)
+static JobPool& workerPool(){
+    static JobPool pool((int)std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+// --------------------------- Memory ---------------------------
+// Allocation-counting hook (ALLOC_CHECK builds only): every global operator new bumps
+// these, so diagnostics can assert that a code path stays off the heap.
+#if ALLOC_CHECK
+static std::atomic<size_t> heapAllocCount{0};
+static std::atomic<size_t> heapAllocBytes{0};
+
+void* operator new(std::size_t n){
+    heapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    heapAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    if(void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+// Kept out of line so GCC does not pair the inlined free() with the caller's new
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+#endif
+
+// Bump allocator over a list of blocks. reset() rewinds to the first block without
+// freeing anything, so once the high-water mark is reached it never touches the heap.
+class Arena {
+public:
+    explicit Arena(size_t blockSize) : blockSize(blockSize) {}
+    ~Arena(){ for(auto&b : blocks) std::free(b.mem); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* alloc(size_t bytes, size_t align = alignof(std::max_align_t)){
+        for(;;){
+            if(current < blocks.size()){
+                Block& b = blocks[current];
+                size_t start = (offset + align - 1) & ~(align - 1);
+                if(start + bytes <= b.size){
+                    offset = start + bytes;
+                    usedBytes += bytes;
+                    highWater = std::max(highWater, usedBytes);
+                    return b.mem + start;
+                }
+                if(current + 1 < blocks.size()){ current++; offset = 0; continue; }
+            }
+            size_t size = std::max(blockSize, bytes + align);
+            blocks.push_back({ static_cast<char*>(std::malloc(size)), size });
+            current = blocks.size() - 1;
+            offset = 0;
+        }
+    }
+
+    template<class T> T* allocArray(size_t n){ return static_cast<T*>(alloc(sizeof(T) * n, alignof(T))); }
+
+    void reset(){ current = 0; offset = 0; usedBytes = 0; }
+    size_t used() const { return usedBytes; }
+    size_t peak() const { return highWater; }
+    size_t blockCount() const { return blocks.size(); }
+    const void* base() const { return blocks.empty() ? nullptr : blocks[0].mem; }
+
+private:
+    struct Block { char* mem; size_t size; };
+    std::vector<Block> blocks;
+    size_t blockSize, current = 0, offset = 0, usedBytes = 0, highWater = 0;
+};
+
+// Growable array whose storage lives in an Arena. Elements must be trivially copyable;
+// growing copies into a fresh arena range and abandons the old one until the next reset.
+template<class T>
+class ArenaVector {
+public:
+    void attach(Arena& a, size_t capacity){
+        arena = &a;
+        items = a.allocArray<T>(capacity);
+        cap = capacity;
+        count = 0;
+    }
+    void clear(){ count = 0; }
+    void push_back(const T& v){
+        if(count == cap){
+            T* grown = arena->allocArray<T>(cap ? cap*2 : 8);
+            if(count) std::memcpy(static_cast<void*>(grown), items, sizeof(T)*count);
+            items = grown; cap = cap ? cap*2 : 8;
+        }
+        items[count++] = v;
+    }
+    size_t size() const { return count; }
+    bool empty() const { return count==0; }
+    T& operator[](size_t i){ return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+    T* begin(){ return items; }
+    T* end(){ return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+
+private:
+    Arena* arena = nullptr;
+    T* items = nullptr;
+    size_t cap = 0, count = 0;
+};
+
+// Level data (rewound by every resetGame) and per-tick scratch (rewound every idle tick)
+static Arena levelArena(64 * 1024);
+static Arena frameArena(256 * 1024);
+
 // --------------------------- Global state ---------------------------
 static int winW=1200, winH=800; // this is for window dimensions and size
 
@@ -100,6 +570,7 @@ static Vec3 camUp = {0.0f, 1.0f, 0.0f};
 
 enum CameraPreset { CAM_FOLLOW=0, CAM_TOP, CAM_SIDE, CAM_FRONT, CAM_FREE };
 static CameraPreset camMode = CAM_FOLLOW; // Fixed-angle semi top-down camera (isometric style)
+static bool multiView = false; // all four presets as quadrants
 
 // Game state
 enum GameState { PLAYING, WON, LOST };
@@ -111,6 +582,7 @@ struct FlyingOracle {
     Vec3 pos;
     Vec3 vel;
     float rotation;
+    float spin;     // degrees per second; 0 once the oracle has come to rest
     float color[3];
 };
 static FlyingOracle flyingOracles[4];
@@ -130,12 +602,16 @@ struct Obstacle {
     float moveSpeed;
     float moveRange;
     Vec3 basePos; // for moving obstacles
-    float moveTime; // accumulated time for movement
+    float moveTime; // movement time box was last placed at: movePhase + obstacleClock then
+    float movePhase;
 };
-static std::vector<Obstacle> obstacles;
+static ArenaVector<Obstacle> obstacles;
+static float obstacleClock = 0.0f; // seconds of obstacle movement since the round started
 
 // Platform featured objects + animation states
 enum AnimType { ANIM_ROTATE=0, ANIM_SCALE, ANIM_TRANSLATE, ANIM_COLOR };
+// Animation channels a feature may drive; which ones exist depends on its AnimType
+enum FeatureTrack { FT_GLOW=0, FT_SPIN, FT_SPIN2, FT_RISE, FT_SCALE_XZ, FT_SCALE_Y, FT_BOB, FT_SWING_L, FT_SWING_R, FT_COLOR, FT_COUNT };
 struct FeatureObj {
     AABB box; // base AABB for collision (not animated extents)
     float baseColor[3];
@@ -143,17 +619,22 @@ struct FeatureObj {
     bool allCollected = false; // becomes true after collectibles on its platform are done
     bool animEnabled = false;  // can toggle only after collected
     float t = 0.0f; // time accumulator
+    int track[FT_COUNT]; // indices into animTracks
+    int animBlock;       // their four-lane block (see Update LOD)
 };
 static FeatureObj features[4];
 
 // Simplified sky oracles
+enum OracleTrack { OT_BOB=0, OT_PULSE, OT_SPIN, OT_COUNT };
 struct SkyOracle {
     Vec3 pos;
     float radius;
-    float rotation;
+    float rotation; // starting spin angle, also offsets the bob phase
     float color[3];
+    int track[OT_COUNT]; // indices into animTracks
+    int animBlock;
 };
-static std::vector<SkyOracle> skyOracles;
+static ArenaVector<SkyOracle> skyOracles;
 
 // Collectibles
 struct Collectible {
@@ -162,13 +643,13 @@ struct Collectible {
     bool collected=false;
     int platformIndex=0; // which platform
 };
-static std::vector<Collectible> collectibles;
+static ArenaVector<Collectible> collectibles;
 static int collectedPerPlatform[4] = {0,0,0,0};
 static int totalCollectiblesPerPlatform = 3; // configurable
 
 // Walls and ground
 static AABB groundBox; // thin box as ground
-static std::vector<AABB> walls; // 3 bounding walls
+static ArenaVector<AABB> walls; // 3 bounding walls
 
 // Input state
 static bool keyDown[256];
@@ -177,6 +658,9 @@ static bool specialDown[512];
 // Time step
 static int prevTicks = 0;
 
+// Draw calls issued by the frame being drawn; display() resets it, telemetry reads it
+static uint32_t drawCallCount = 0;
+
 // --------------------------- Audio ---------------------------
 #if USE_MINIAUDIO
 static ma_engine audioEngine;
@@ -185,7 +669,6 @@ static bool audioReady = false;
 struct AudioClip {
     ma_sound sound;
     bool loaded = false;
-    bool played = false; // Track if one-time sounds have played
 };
 
 static AudioClip audioBgm, audioCollect, audioWin, audioLose;
@@ -213,12 +696,6 @@ static void playAudio(AudioClip& clip, bool restart = true){
     ma_sound_start(&clip.sound);
 }
 
-static void playOnce(AudioClip& clip){
-    if(clip.played) return;
-    playAudio(clip);
-    clip.played = true;
-}
-
 static void initAudioSystem(){
     if(ma_engine_init(nullptr, &audioEngine) != MA_SUCCESS){
         std::fprintf(stderr, "[audio] Failed to initialize audio engine\n");
@@ -245,937 +722,5969 @@ static void shutdownAudioSystem(){
 }
 #else
 // No-audio stubs for single-file submission or when header is unavailable
-struct AudioClip { bool loaded=false; bool played=false; };
+struct AudioClip { bool loaded=false; };
 static bool audioReady = false;
 static AudioClip audioBgm, audioCollect, audioWin, audioLose;
 static bool loadAudio(AudioClip&, const char*, bool){ return false; }
 static void playAudio(AudioClip&, bool=true){}
-static void playOnce(AudioClip&){}
 static void initAudioSystem(){}
 static void shutdownAudioSystem(){}
 #endif
 
-// ------------------------ Drawing primitives ------------------------
-static void setColor3f(float r,float g,float b){ glColor3f(r,g,b); }
-
-static void drawQuad(const Vec3&a,const Vec3&b,const Vec3&c,const Vec3&d){
-    glBegin(GL_QUADS);
-    glVertex3f(a.x,a.y,a.z);
-    glVertex3f(b.x,b.y,b.z);
-    glVertex3f(c.x,c.y,c.z);
-    glVertex3f(d.x,d.y,d.z);
-    glEnd();
-}
+// --------------------------- Animation tracks ---------------------------
+// Each animated channel (spin, scale, bob, swing, colour shift, glow) is one track, either a
+// sine base + amp*sin(freq*t + phase) or a ramp base + fmod(freq*t + phase, period), read
+// from one of the shared clocks. Gated tracks hold an idle value while their clock is paused.
+// evaluate() runs once per tick over every track four lanes at a time; drawing only reads.
+// Each entity's tracks start a fresh block of four lanes, so a block that is not due this
+// tick (see Update LOD) is skipped and keeps its last values; as every track is closed-form
+// in its clock, the next evaluation is exact whatever was skipped.
+enum AnimTrackKind { TRACK_SINE=0, TRACK_RAMP };
+enum AnimClock { CLOCK_WORLD=0, CLOCK_FEATURE0 }; // feature i runs on CLOCK_FEATURE0+i
+
+class AnimTrackSet {
+public:
+    static const int MAX_TRACKS = 128;
+    static const int MAX_CLOCKS = 8;
+    static const int NO_TRACK = MAX_TRACKS; // reads as 0
+
+    static const int MAX_BLOCKS = MAX_TRACKS / 4;
+
+    AnimTrackSet(){ setAllDue(); }
+
+    void clear(){ count = 0; setAllDue(); }
+    int size() const { return count; }
+
+    // Pads to the next block; returns the block the following add()s land in
+    int beginBlock(){ count = std::min(MAX_TRACKS, (count + 3) & ~3); return count / 4; }
+    void setDue(int block, bool due){ if(block < MAX_BLOCKS) blockDue[block] = due; }
+    void setAllDue(){ for(int b=0;b<MAX_BLOCKS;b++) blockDue[b] = true; }
+
+    // For TRACK_RAMP, amp is the wrap period
+    int add(AnimTrackKind kind, int clock, float base, float amp, float freq, float phase=0.0f, bool gated=false, float idleValue=0.0f){
+        if(count >= MAX_TRACKS) return NO_TRACK;
+        int i = count++;
+        clockOf[i] = clock; gatedBy[i] = gated;
+        this->base[i] = base; this->freq[i] = freq; this->phase[i] = phase; idle[i] = idleValue;
+        ramp[i] = kind==TRACK_RAMP ? 1.0f : 0.0f;
+        this->amp[i] = kind==TRACK_RAMP ? 0.0f : amp;
+        period[i] = kind==TRACK_RAMP ? amp : 1.0f;
+        return i;
+    }
 
-static void drawBox(const AABB& box){
-    const float x=box.center.x, y=box.center.y, z=box.center.z;
-    const float hx=box.half.x, hy=box.half.y, hz=box.half.z;
-    // 6 faces
-    // +Y top
-    setColor3f(0.85f,0.85f,0.85f);
-    drawQuad({x-hx,y+hy,z-hz},{x+hx,y+hy,z-hz},{x+hx,y+hy,z+hz},{x-hx,y+hy,z+hz});
-    // -Y bottom
-    setColor3f(0.5f,0.5f,0.5f);
-    drawQuad({x-hx,y-hy,z+hz},{x+hx,y-hy,z+hz},{x+hx,y-hy,z-hz},{x-hx,y-hy,z-hz});
-    // +X
-    setColor3f(0.75f,0.75f,0.8f);
-    drawQuad({x+hx,y-hy,z-hz},{x+hx,y+hy,z-hz},{x+hx,y+hy,z+hz},{x+hx,y-hy,z+hz});
-    // -X
-    setColor3f(0.7f,0.7f,0.75f);
-    drawQuad({x-hx,y-hy,z+hz},{x-hx,y+hy,z+hz},{x-hx,y+hy,z-hz},{x-hx,y-hy,z-hz});
-    // +Z
-    setColor3f(0.8f,0.7f,0.7f);
-    drawQuad({x-hx,y-hy,z+hz},{x-hx,y+hy,z+hz},{x+hx,y+hy,z+hz},{x+hx,y-hy,z+hz});
-    // -Z
-    setColor3f(0.7f,0.8f,0.7f);
-    drawQuad({x+hx,y-hy,z-hz},{x+hx,y+hy,z-hz},{x-hx,y+hy,z-hz},{x-hx,y-hy,z-hz});
-}
+    void setClock(int clock, float t, bool running){ clockTime[clock] = t; clockRunning[clock] = running; }
+    void advanceClock(int clock, float dt){ clockTime[clock] += dt; }
+    float clock(int clock) const { return clockTime[clock]; }
+    float value(int track) const { return out[track]; }
 
-// A simple colored box with a single color
-static void drawSolidBox(const AABB&box, float r, float g, float b){
-    glColor3f(r,g,b);
-    const float x=box.center.x, y=box.center.y, z=box.center.z;
-    const float hx=box.half.x, hy=box.half.y, hz=box.half.z;
-    glBegin(GL_QUADS);
-    // top
-    glVertex3f(x-hx,y+hy,z-hz); glVertex3f(x+hx,y+hy,z-hz); glVertex3f(x+hx,y+hy,z+hz); glVertex3f(x-hx,y+hy,z+hz);
-    // bottom
-    glVertex3f(x-hx,y-hy,z+hz); glVertex3f(x+hx,y-hy,z+hz); glVertex3f(x+hx,y-hy,z-hz); glVertex3f(x-hx,y-hy,z-hz);
-    // +X
-    glVertex3f(x+hx,y-hy,z-hz); glVertex3f(x+hx,y+hy,z-hz); glVertex3f(x+hx,y+hy,z+hz); glVertex3f(x+hx,y-hy,z+hz);
-    // -X
-    glVertex3f(x-hx,y-hy,z+hz); glVertex3f(x-hx,y+hy,z+hz); glVertex3f(x-hx,y+hy,z-hz); glVertex3f(x-hx,y-hy,z-hz);
-    // +Z
-    glVertex3f(x-hx,y-hy,z+hz); glVertex3f(x-hx,y+hy,z+hz); glVertex3f(x+hx,y+hy,z+hz); glVertex3f(x+hx,y-hy,z+hz);
-    // -Z
-    glVertex3f(x+hx,y-hy,z-hz); glVertex3f(x+hx,y+hy,z-hz); glVertex3f(x-hx,y+hy,z-hz); glVertex3f(x-hx,y-hy,z-hz);
-    glEnd();
-}
+    void evaluate(){
+        int lanes = (count + 3) & ~3;
+        for(int i=0;i<lanes;i++){
+            t[i] = clockTime[clockOf[i]];
+            live[i] = (!gatedBy[i] || clockRunning[clockOf[i]]) ? 1.0f : 0.0f;
+        }
+        const f4 half = f4Set1(0.5f);
+        for(int i=0;i<lanes;i+=4){
+            if(!blockDue[i/4]) continue;
+            f4 x = f4Add(f4Mul(f4Load(freq+i), f4Load(t+i)), f4Load(phase+i));
+            f4 p = f4Load(period+i);
+            f4 wrapped = f4Sub(x, f4Mul(f4Floor(f4Mul(x, recip(p))), p));
+            f4 v = f4Add(f4Load(base+i), f4Select(f4Less(half, f4Load(ramp+i)), wrapped, f4Mul(f4Load(amp+i), f4Sin(x))));
+            f4Store(out+i, f4Select(f4Less(half, f4Load(live+i)), v, f4Load(idle+i)));
+        }
+    }
 
-// Pyramid (square base) for some East Asian aesthetic (roof-like)
-static void drawPyramid(const Vec3&center, float base, float height, float r, float g, float b){
-    glColor3f(r,g,b);
-    float x=center.x, y=center.y, z=center.z;
-    float h=height; float b2=base*0.5f;
-    // Base quad
-    glBegin(GL_QUADS);
-    glVertex3f(x-b2,y,z-b2); glVertex3f(x+b2,y,z-b2); glVertex3f(x+b2,y,z+b2); glVertex3f(x-b2,y,z+b2);
-    glEnd();
-    // 4 side triangles
-    glBegin(GL_TRIANGLES);
-    // +Z face
-    glVertex3f(x-b2,y,z+b2); glVertex3f(x+b2,y,z+b2); glVertex3f(x, y+h, z);
-    // -Z face
-    glVertex3f(x+b2,y,z-b2); glVertex3f(x-b2,y,z-b2); glVertex3f(x, y+h, z);
-    // +X face
-    glVertex3f(x+b2,y,z-b2); glVertex3f(x+b2,y,z+b2); glVertex3f(x, y+h, z);
-    // -X face
-    glVertex3f(x-b2,y,z+b2); glVertex3f(x-b2,y,z-b2); glVertex3f(x, y+h, z);
-    glEnd();
-}
+private:
+    static f4 recip(f4 p){
+        alignas(16) float v[4];
+        f4Store(v, p);
+        for(int k=0;k<4;k++) v[k] = 1.0f / v[k];
+        return f4Load(v);
+    }
 
-// A small torii-like gateway made from boxes (Japanese aesthetic)
-static void drawTorii(const Vec3&center, float scale, const float col[3]){
-    float r=col[0], g=col[1], b=col[2];
-    // pillars
-    drawSolidBox({{center.x-1.0f*scale, center.y+2.0f*scale, center.z}, {0.3f*scale, 2.0f*scale, 0.3f*scale}}, r,g,b);
-    drawSolidBox({{center.x+1.0f*scale, center.y+2.0f*scale, center.z}, {0.3f*scale, 2.0f*scale, 0.3f*scale}}, r,g,b);
-    // cross beam
-    drawSolidBox({{center.x, center.y+4.2f*scale, center.z}, {1.8f*scale, 0.25f*scale, 0.4f*scale}}, r*0.9f,g*0.9f,b*0.9f);
-    // top cap
-    drawSolidBox({{center.x, center.y+4.7f*scale, center.z}, {2.1f*scale, 0.15f*scale, 0.5f*scale}}, r*0.8f,g*0.8f,b*0.8f);
-}
+    int count = 0;
+    int clockOf[MAX_TRACKS] = {};
+    bool gatedBy[MAX_TRACKS] = {};
+    alignas(16) float base[MAX_TRACKS] = {}, amp[MAX_TRACKS] = {}, freq[MAX_TRACKS] = {}, phase[MAX_TRACKS] = {};
+    alignas(16) float period[MAX_TRACKS] = {}, ramp[MAX_TRACKS] = {}, idle[MAX_TRACKS] = {};
+    alignas(16) float t[MAX_TRACKS] = {}, live[MAX_TRACKS] = {};
+    alignas(16) float out[MAX_TRACKS + 4] = {};
+    float clockTime[MAX_CLOCKS] = {};
+    bool clockRunning[MAX_CLOCKS] = {};
+    bool blockDue[MAX_BLOCKS];
+};
+const int AnimTrackSet::MAX_TRACKS; // std::min takes it by reference, so it needs a definition
 
-// A simple pagoda-like stack: boxes + pyramids
-static void drawPagoda(const Vec3&center, float scale, const float col[3]){
-    float r=col[0], g=col[1], b=col[2];
-    float y=center.y;
-    // base box
-    drawSolidBox({{center.x, y+0.5f*scale, center.z}, {1.8f*scale, 0.5f*scale, 1.8f*scale}}, r*0.6f,g*0.6f,b*0.6f);
-    // roof 1
-    drawPyramid({center.x, y+1.0f*scale, center.z}, 4.0f*scale, 0.8f*scale, r,g,b);
-    // middle box
-    drawSolidBox({{center.x, y+1.8f*scale, center.z}, {1.2f*scale, 0.4f*scale, 1.2f*scale}}, r*0.6f,g*0.6f,b*0.6f);
-    // roof 2
-    drawPyramid({center.x, y+2.2f*scale, center.z}, 3.2f*scale, 0.7f*scale, r*0.95f,g*0.95f,b*0.95f);
-}
+static AnimTrackSet animTracks;
 
-static void drawDiamond(const Vec3&center, float radius, float height, const float col[3]){
-    glColor3f(col[0], col[1], col[2]);
-    float halfH = height * 0.5f;
-    glBegin(GL_TRIANGLES);
-    for(int i=0;i<6;i++){
-        float a0 = (float)i/6.0f * 2.0f * PI_F;
-        float a1 = (float)(i+1)/6.0f * 2.0f * PI_F;
-        float x0 = cosf(a0) * radius;
-        float z0 = sinf(a0) * radius;
-        float x1 = cosf(a1) * radius;
-        float z1 = sinf(a1) * radius;
-        // Top half
-        glVertex3f(center.x, center.y + halfH, center.z);
-        glVertex3f(center.x + x0, center.y, center.z + z0);
-        glVertex3f(center.x + x1, center.y, center.z + z1);
-        // Bottom half
-        glVertex3f(center.x, center.y - halfH, center.z);
-        glVertex3f(center.x + x1, center.y, center.z + z1);
-        glVertex3f(center.x + x0, center.y, center.z + z0);
+// Curves match the original inline animation: gated channels rest at their idle pose until
+// the feature's animation is switched on, ungated ones freeze wherever the feature clock stopped.
+static void addFeatureTracks(FeatureObj& f, int clock){
+    AnimTrackSet& a = animTracks;
+    f.animBlock = a.beginBlock();
+    for(int k=0;k<FT_COUNT;k++) f.track[k] = AnimTrackSet::NO_TRACK;
+    f.track[FT_GLOW] = a.add(TRACK_SINE, clock, 0.5f, 0.5f, 3.0f, 0.0f, true, 0.3f);
+    switch(f.type){
+        case ANIM_ROTATE:
+            f.track[FT_SPIN]  = a.add(TRACK_RAMP, clock, 0.0f, 360.0f, 90.0f, 0.0f, true, 0.0f);
+            f.track[FT_SPIN2] = a.add(TRACK_RAMP, clock, 0.0f, 360.0f, 140.0f, 0.0f, true, 0.0f);
+            f.track[FT_RISE]  = a.add(TRACK_SINE, clock, 0.4f, 0.3f, 2.2f, 0.0f, true, 0.2f);
+            break;
+        case ANIM_SCALE:
+            f.track[FT_SCALE_XZ] = a.add(TRACK_SINE, clock, 1.0f, 0.18f, 1.8f, 0.0f, true, 1.0f);
+            f.track[FT_SCALE_Y]  = a.add(TRACK_SINE, clock, 1.0f, 0.25f, 2.1f);
+            f.track[FT_SPIN]     = a.add(TRACK_RAMP, clock, 0.0f, 360.0f, 60.0f, 0.0f, true, 0.0f);
+            break;
+        case ANIM_TRANSLATE:
+            f.track[FT_BOB]     = a.add(TRACK_SINE, clock, 0.0f, 0.7f, 1.6f, 0.0f, true, 0.0f);
+            f.track[FT_SWING_L] = a.add(TRACK_SINE, clock, 0.0f, 20.0f, 2.4f, -1.0f, true, 4.0f);
+            f.track[FT_SWING_R] = a.add(TRACK_SINE, clock, 0.0f, 20.0f, 2.4f, 1.0f, true, 4.0f);
+            break;
+        case ANIM_COLOR:
+            f.track[FT_COLOR]   = a.add(TRACK_SINE, clock, 0.65f, 0.35f, 2.4f, 0.0f, true, 0.4f);
+            f.track[FT_SCALE_Y] = a.add(TRACK_SINE, clock, 1.0f, 0.15f, 3.0f);
+            break;
     }
-    glEnd();
 }
 
-static void drawHaloRing(const Vec3&center, float innerR, float outerR, const float col[3], float alpha){
-    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    glBegin(GL_TRIANGLE_STRIP);
-    for(int i=0;i<=64;i++){
-        float ang = (float)i/64.0f * 2.0f * PI_F;
-        float c = cosf(ang);
-        float s = sinf(ang);
-        glColor4f(col[0], col[1], col[2], alpha);
-        glVertex3f(center.x + c*outerR, center.y, center.z + s*outerR);
-        glColor4f(col[0], col[1], col[2], 0.0f);
-        glVertex3f(center.x + c*innerR, center.y, center.z + s*innerR);
-    }
-    glEnd();
-    glDisable(GL_BLEND);
-    glPopAttrib();
-}
-
-static void drawOrbPlane(const Vec3&center, const Vec3&axisU, const Vec3&axisV, float radius, const float col[3], float alpha){
-    glBegin(GL_TRIANGLE_FAN);
-    glColor4f(col[0], col[1], col[2], alpha);
-    glVertex3f(center.x, center.y, center.z);
-    glColor4f(col[0], col[1], col[2], 0.0f);
-    for(int i=0;i<=32;i++){
-        float ang = (float)i/32.0f * 2.0f * PI_F;
-        float c = cosf(ang);
-        float s = sinf(ang);
-        Vec3 offset = add(mul(axisU, radius*c), mul(axisV, radius*s));
-        glVertex3f(center.x + offset.x, center.y + offset.y, center.z + offset.z);
-    }
-    glEnd();
+static void addSkyOracleTracks(SkyOracle& o){
+    AnimTrackSet& a = animTracks;
+    o.animBlock = a.beginBlock();
+    // The bob used to read the spin angle as a phase, so its rate carries the 30 deg/s spin
+    o.track[OT_BOB]   = a.add(TRACK_SINE, CLOCK_WORLD, 0.0f, 0.6f, 1.0f + 30.0f*0.01f, o.rotation*0.01f);
+    o.track[OT_PULSE] = a.add(TRACK_SINE, CLOCK_WORLD, 0.5f, 0.5f, 2.0f);
+    o.track[OT_SPIN]  = a.add(TRACK_RAMP, CLOCK_WORLD, 0.0f, 360.0f, 30.0f, o.rotation);
 }
 
-static void drawGlowingOrb(const Vec3&center, float radius, const float col[3], float alpha){
-    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
-    glDisable(GL_LIGHTING);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-    drawOrbPlane(center, {1,0,0}, {0,1,0}, radius, col, alpha);
-    drawOrbPlane(center, {0,1,0}, {0,0,1}, radius, col, alpha);
-    drawOrbPlane(center, {1,0,0}, {0,0,1}, radius, col, alpha);
-    glDisable(GL_BLEND);
-    glPopAttrib();
-}
-
-static void drawTaikoDrum(float radius, float height, const float bodyCol[3], const float frameCol[3], const float ropeCol[3]){
-    drawSolidBox({{0.0f, height*0.7f, 0.0f}, {radius, height*0.7f, radius}}, bodyCol[0], bodyCol[1], bodyCol[2]);
-    drawSolidBox({{0.0f, height*1.35f, 0.0f}, {radius*0.95f, 0.15f, radius*0.95f}}, ropeCol[0], ropeCol[1], ropeCol[2]);
-    drawSolidBox({{0.0f, height*0.05f, 0.0f}, {radius*0.95f, 0.15f, radius*0.95f}}, ropeCol[0]*0.9f, ropeCol[1]*0.9f, ropeCol[2]*0.9f);
-    drawSolidBox({{ radius*0.95f, height*0.7f, 0.0f}, {0.15f, height*0.6f, radius*0.35f}}, ropeCol[0], ropeCol[1], ropeCol[2]);
-    drawSolidBox({{-radius*0.95f, height*0.7f, 0.0f}, {0.15f, height*0.6f, radius*0.35f}}, ropeCol[0], ropeCol[1], ropeCol[2]);
-    drawSolidBox({{0.0f, height*0.7f,  radius*0.95f}, {radius*0.35f, height*0.6f, 0.15f}}, ropeCol[0], ropeCol[1], ropeCol[2]);
-    drawSolidBox({{0.0f, height*0.7f, -radius*0.95f}, {radius*0.35f, height*0.6f, 0.15f}}, ropeCol[0], ropeCol[1], ropeCol[2]);
-    drawSolidBox({{-radius*1.25f, height*0.4f, 0.0f}, {0.25f, height*0.4f, 0.35f}}, frameCol[0], frameCol[1], frameCol[2]);
-    drawSolidBox({{ radius*1.25f, height*0.4f, 0.0f}, {0.25f, height*0.4f, 0.35f}}, frameCol[0], frameCol[1], frameCol[2]);
-    drawSolidBox({{0.0f, height*0.35f, 0.0f}, {radius*1.45f, 0.12f, radius*0.45f}}, frameCol[0]*0.9f, frameCol[1]*0.9f, frameCol[2]*0.9f);
-    drawSolidBox({{0.0f, height*0.15f, 0.0f}, {radius*1.45f, 0.12f, radius*0.55f}}, frameCol[0]*0.75f, frameCol[1]*0.75f, frameCol[2]*0.75f);
+// Copies the feature clocks in and evaluates every track; dt advances the world clock
+static void updateAnimation(float dt){
+    animTracks.advanceClock(CLOCK_WORLD, dt);
+    for(int i=0;i<4;i++) animTracks.setClock(CLOCK_FEATURE0 + i, features[i].t, features[i].animEnabled);
+    animTracks.evaluate();
 }
 
-static void drawStoneLantern(float scale, const float stoneCol[3], const float glowCol[3]){
-    drawSolidBox({{0.0f, 0.15f*scale, 0.0f}, {0.7f*scale, 0.15f*scale, 0.7f*scale}}, stoneCol[0]*0.9f, stoneCol[1]*0.9f, stoneCol[2]*0.9f);
-    drawSolidBox({{0.0f, 0.55f*scale, 0.0f}, {0.22f*scale, 0.4f*scale, 0.22f*scale}}, stoneCol[0], stoneCol[1], stoneCol[2]);
-    drawSolidBox({{0.0f, 1.05f*scale, 0.0f}, {0.45f*scale, 0.2f*scale, 0.45f*scale}}, stoneCol[0]*1.05f, stoneCol[1]*1.05f, stoneCol[2]*1.05f);
-    drawGlowingOrb({0.0f, 1.15f*scale, 0.0f}, 0.25f*scale, glowCol, 0.75f);
-    drawPyramid({0.0f, 1.55f*scale, 0.0f}, 1.5f*scale, 0.5f*scale, stoneCol[0]*0.85f, stoneCol[1]*0.85f, stoneCol[2]*0.85f);
-    drawSolidBox({{0.0f, 1.85f*scale, 0.0f}, {0.35f*scale, 0.08f*scale, 0.35f*scale}}, stoneCol[0]*1.1f, stoneCol[1]*1.1f, stoneCol[2]*1.1f);
-}
+// --------------------------- Timers & events ---------------------------
+// Gameplay changes (a pickup, a platform completing, the round being won or running out)
+// are published once on a bus and handled by whoever subscribed to that type. Anything due
+// later is scheduled on a hierarchical timer wheel rather than polled every tick: four
+// levels of 64 slots at 1 ms resolution, so schedule and cancel are O(1) and advancing
+// visits one slot per elapsed tick, plus a cascade of the next coarser slot into the finer
+// levels every 64 ticks. Timer nodes come from a fixed pool; nothing is allocated after
+// construction. The wheel runs on simulation time, so rewinds restore its clock and
+// re-arm the timers implied by the restored state (armGameTimers).
+enum GameEventType { EVT_COLLECTED=0, EVT_PLATFORM_COMPLETE, EVT_GAME_WON, EVT_TIME_UP, GAME_EVENT_TYPES };
+
+struct GameEvent {
+    GameEventType type;
+    int arg; // collectible index for EVT_COLLECTED, platform index for EVT_PLATFORM_COMPLETE
+};
 
-static void drawLotusOracleModel(float radius, float height, const float col[3]){
-    glPushMatrix();
-    for(int i=0;i<6;i++){
-        glPushMatrix();
-        glRotatef(i * 60.0f, 0, 1, 0);
-        glTranslatef(radius*0.6f, 0.0f, 0.0f);
-        drawPyramid({0,0,0}, radius*0.8f, height, col[0], col[1], col[2]);
-        glPopMatrix();
+class EventBus {
+public:
+    typedef void (*Handler)(const GameEvent&);
+    static const int MAX_HANDLERS = 4;
+
+    void subscribe(GameEventType type, Handler h){
+        Subscribers& s = subscribers[type];
+        if(s.count < MAX_HANDLERS) s.handlers[s.count++] = h;
+    }
+    // Handlers run immediately, in subscription order, and may publish further events
+    void publish(const GameEvent& e) const {
+        const Subscribers& s = subscribers[e.type];
+        for(int i=0;i<s.count;i++) s.handlers[i](e);
     }
-    float coreCol[3]={std::min(1.0f,col[0]+0.2f), std::min(1.0f,col[1]+0.2f), std::min(1.0f,col[2]+0.2f)};
-    drawDiamond({0,height*0.6f,0}, radius*0.4f, height*1.2f, coreCol);
-    glPopMatrix();
-}
 
-static void drawCrystalColumn(float radius, float height, const float col[3]){
-    float accent[3]={col[0]*0.8f+0.2f, col[1]*0.8f+0.2f, col[2]*0.8f+0.2f};
-    drawDiamond({0,height*0.4f,0}, radius*0.5f, height*1.1f, col);
-    drawDiamond({0,height*1.2f,0}, radius*0.35f, height*0.8f, accent);
-    drawDiamond({0,height*0.0f,0}, radius*0.35f, height*0.8f, accent);
-}
+private:
+    struct Subscribers { Handler handlers[MAX_HANDLERS]; int count = 0; };
+    Subscribers subscribers[GAME_EVENT_TYPES];
+};
 
-static void drawWindBell(float radius, float height, const float col[3]){
-    float capCol[3]={col[0]*0.6f, col[1]*0.9f, col[2]*0.6f};
-    drawDiamond({0,height*0.6f,0}, radius*0.5f, height, col);
-    drawDiamond({0,height*1.2f,0}, radius*0.25f, height*0.5f, capCol);
-    // Hanging chimes
-    glColor3f(capCol[0], capCol[1], capCol[2]);
-    glBegin(GL_TRIANGLE_STRIP);
-    glVertex3f(-0.2f, 0.0f, 0.0f); glVertex3f(-0.05f, -height*1.2f, 0.0f);
-    glVertex3f(0.2f, 0.0f, 0.0f);  glVertex3f(0.05f, -height*1.2f, 0.0f);
-    glEnd();
-    glBegin(GL_TRIANGLE_STRIP);
-    glVertex3f(0.0f, 0.0f, -0.2f); glVertex3f(0.0f, -height*1.3f, -0.05f);
-    glVertex3f(0.0f, 0.0f, 0.2f);  glVertex3f(0.0f, -height*1.3f, 0.05f);
-    glEnd();
-}
+static EventBus gameEvents;
 
-static void drawLanternOracle(float radius, float height, const float col[3]){
-    float bodyCol[3]={col[0]*0.9f+0.1f, col[1]*0.9f+0.1f, col[2]*0.6f+0.4f};
-    drawGlowingOrb({0,height*0.8f,0}, radius*0.8f, bodyCol, 0.8f);
-    drawDiamond({0,height*0.8f,0}, radius*0.45f, height, col);
-    drawDiamond({0,height*0.1f,0}, radius*0.3f, height*0.5f, bodyCol);
-}
+static const double TIMER_TICK_SECONDS = 0.001;
+typedef uint32_t TimerHandle; // generation << 16 | (node + 1); 0 is never live
 
-// Collectible: a small shrine-like piece (3+ primitives): base box + roof pyramid + ornament box
-static void drawCollectibleGeom(const Collectible&c){
-    float r=c.color[0], g=c.color[1], b=c.color[2];
-    // base
-    drawSolidBox({{c.box.center.x, c.box.center.y-0.1f, c.box.center.z}, {c.box.half.x, 0.1f, c.box.half.z}}, r*0.6f,g*0.6f,b*0.6f);
-    // roof
-    drawPyramid({c.box.center.x, c.box.center.y+0.0f, c.box.center.z}, c.box.half.x*3.0f, c.box.half.y*1.8f, r,g,b);
-    // ornament
-    drawSolidBox({{c.box.center.x, c.box.center.y+0.45f, c.box.center.z}, {0.08f,0.2f,0.08f}}, r*0.9f,g*0.9f,b*0.2f);
-}
+class TimerWheel {
+public:
+    static const int LEVELS = 4, SLOT_BITS = 6, SLOTS = 1 << SLOT_BITS;
+    static const uint64_t MAX_DELAY = (1ull << (LEVELS * SLOT_BITS)) - 1; // about 4.6 hours
 
-// Player model (ninja warrior): head with mask, torso (dark gi), legs (hakama pants), arms, katana sword, ninja hood
-static void drawPlayer(){
-    glPushMatrix();
-    glTranslatef(playerPos.x, playerPos.y, playerPos.z);
-    glRotatef(playerYawDeg, 0,1,0);
+    explicit TimerWheel(int capacity) : nodes(std::min(capacity, 0xFFFF)) { reset(0, 0.0); }
 
-    // Torso - dark ninja gi/outfit
-    drawSolidBox({{0, 1.0f, 0}, {0.6f, 0.8f, 0.35f}}, 0.1f, 0.1f, 0.15f);
+    // Drops every timer and sets the clock; outstanding handles become stale
+    void reset(uint64_t now, double fraction){
+        current = now; frac = fraction;
+        for(int l=0;l<LEVELS;l++) for(int s=0;s<SLOTS;s++) wheel[l][s] = NIL;
+        freeHead = NIL;
+        for(int i=(int)nodes.size()-1;i>=0;i--){
+            if(nodes[i].live) nodes[i].gen++;
+            nodes[i].live = false;
+            nodes[i].next = freeHead;
+            freeHead = i;
+        }
+        live = 0;
+    }
 
-    // Head - skin tone (face visible)
-    drawSolidBox({{0, 2.0f, 0}, {0.35f, 0.35f, 0.35f}}, 0.85f, 0.75f, 0.65f);
+    uint64_t now() const { return current; }
+    double fraction() const { return frac; } // ticks elapsed past now()
+    int pending() const { return live; }
+
+    // Fires on the first advance() that reaches tick (at the earliest the next tick); 0 if the pool is full
+    TimerHandle scheduleAt(uint64_t tick, const GameEvent& e){
+        if(freeHead == NIL) return 0;
+        int i = freeHead;
+        Node& n = nodes[i];
+        freeHead = n.next;
+        n.expires = std::min(std::max(tick, current + 1), current + MAX_DELAY);
+        n.event = e;
+        n.live = true;
+        live++;
+        insert(i);
+        return ((uint32_t)n.gen << 16) | (uint32_t)(i + 1);
+    }
+    TimerHandle schedule(double delaySeconds, const GameEvent& e){
+        return scheduleAt(current + (uint64_t)std::ceil(std::max(0.0, frac + delaySeconds / TIMER_TICK_SECONDS)), e);
+    }
 
-    // Ninja mask/hood - dark cloth covering lower face and head
-    drawSolidBox({{0, 1.85f, 0}, {0.38f, 0.25f, 0.36f}}, 0.08f, 0.08f, 0.12f);
+    bool cancel(TimerHandle h){
+        int i = (int)(h & 0xFFFFu) - 1;
+        if(i < 0 || i >= (int)nodes.size() || !nodes[i].live || nodes[i].gen != (uint16_t)(h >> 16)) return false;
+        unlink(i);
+        release(i);
+        return true;
+    }
 
-    // Headband - red cloth band (traditional ninja/samurai)
-    drawSolidBox({{0, 2.25f, 0}, {0.4f, 0.08f, 0.38f}}, 0.7f, 0.1f, 0.1f);
+    // Moves the clock on by dt seconds and publishes each event as its tick is reached
+    void advance(float dt, const EventBus& bus){
+        frac += std::max(0.0f, dt) / TIMER_TICK_SECONDS;
+        uint64_t ticks = (uint64_t)frac;
+        frac -= (double)ticks;
+        uint64_t target = current + ticks;
+        while(current < target){
+            if(live == 0){ current = target; break; } // nothing to cascade or fire
+            current++;
+            int slot = (int)(current & (SLOTS - 1));
+            if(slot == 0) cascade(1);
+            fire(slot, bus);
+        }
+    }
 
-    // Legs - dark hakama pants (traditional Japanese)
-    drawSolidBox({{-0.25f, 0.2f, 0}, {0.22f, 0.6f, 0.22f}}, 0.12f, 0.1f, 0.15f);
-    drawSolidBox({{ 0.25f, 0.2f, 0}, {0.22f, 0.6f, 0.22f}}, 0.12f, 0.1f, 0.15f);
+private:
+    static const int NIL = -1;
 
-    // Arms - wrapped in dark cloth
-    drawSolidBox({{-0.7f, 1.1f, 0}, {0.18f, 0.6f, 0.15f}}, 0.1f, 0.1f, 0.15f);
-    drawSolidBox({{ 0.7f, 1.1f, 0}, {0.18f, 0.6f, 0.15f}}, 0.1f, 0.1f, 0.15f);
+    struct Node {
+        uint64_t expires = 0;
+        GameEvent event = { EVT_COLLECTED, 0 };
+        int next = NIL, prev = NIL;
+        int level = 0, slot = 0;
+        uint16_t gen = 1;
+        bool live = false;
+    };
 
-    // Hands - gloved/wrapped hands
-    drawSolidBox({{-0.9f, 0.6f, 0}, {0.1f, 0.12f, 0.1f}}, 0.15f, 0.1f, 0.1f);
-    drawSolidBox({{ 0.9f, 0.6f, 0}, {0.1f, 0.12f, 0.1f}}, 0.15f, 0.1f, 0.1f);
+    // The level is picked by distance to the deadline; a slot holds every timer whose
+    // deadline shares that level's bits, so level 0 slots hold exactly one deadline each
+    void insert(int i){
+        Node& n = nodes[i];
+        uint64_t delta = n.expires - current;
+        int level = 0;
+        while(level < LEVELS - 1 && delta >= (1ull << ((level + 1) * SLOT_BITS))) level++;
+        n.level = level;
+        n.slot = (int)((n.expires >> (level * SLOT_BITS)) & (SLOTS - 1));
+        int& head = wheel[level][n.slot];
+        n.prev = NIL;
+        n.next = head;
+        if(head != NIL) nodes[head].prev = i;
+        head = i;
+    }
 
-    // Katana sword - silver blade with dark handle held on back
-    // Blade
-    drawSolidBox({{-0.3f, 1.8f, -0.45f}, {0.05f, 0.8f, 0.08f}}, 0.7f, 0.75f, 0.8f);
-    // Handle (tsuka)
-    drawSolidBox({{-0.3f, 0.85f, -0.45f}, {0.08f, 0.25f, 0.1f}}, 0.15f, 0.1f, 0.08f);
-    // Guard (tsuba)
-    drawSolidBox({{-0.3f, 1.15f, -0.45f}, {0.15f, 0.02f, 0.15f}}, 0.6f, 0.5f, 0.2f);
+    void unlink(int i){
+        Node& n = nodes[i];
+        if(n.prev != NIL) nodes[n.prev].next = n.next;
+        else wheel[n.level][n.slot] = n.next;
+        if(n.next != NIL) nodes[n.next].prev = n.prev;
+    }
 
-    // Tabi boots - traditional split-toe footwear
-    drawSolidBox({{-0.25f, -0.5f, 0.1f}, {0.2f, 0.1f, 0.28f}}, 0.95f, 0.95f, 0.95f);
-    drawSolidBox({{ 0.25f, -0.5f, 0.1f}, {0.2f, 0.1f, 0.28f}}, 0.95f, 0.95f, 0.95f);
+    void release(int i){
+        Node& n = nodes[i];
+        n.live = false;
+        n.gen++;
+        n.next = freeHead;
+        freeHead = i;
+        live--;
+    }
 
-    glPopMatrix();
-}
+    // Redistributes the slot of this level that the clock just entered
+    void cascade(int level){
+        if(level >= LEVELS) return;
+        int slot = (int)((current >> (level * SLOT_BITS)) & (SLOTS - 1));
+        int head = wheel[level][slot];
+        wheel[level][slot] = NIL;
+        while(head != NIL){
+            int next = nodes[head].next;
+            insert(head);
+            head = next;
+        }
+        if(slot == 0) cascade(level + 1);
+    }
 
-// Feature object draw variants
-static void drawFeatureObj(const FeatureObj&f){
-    glPushMatrix();
-    glTranslatef(f.box.center.x, f.box.center.y, f.box.center.z);
+    void fire(int slot, const EventBus& bus){
+        int& head = wheel[0][slot];
+        while(head != NIL){ // handlers may schedule or cancel, so unlink before publishing
+            int i = head;
+            GameEvent e = nodes[i].event;
+            unlink(i);
+            release(i);
+            bus.publish(e);
+        }
+    }
 
-    float r=f.baseColor[0], g=f.baseColor[1], b=f.baseColor[2];
-    float glowPulse = f.animEnabled ? (0.5f + 0.5f*sinf(f.t*3.0f)) : 0.3f;
+    std::vector<Node> nodes;
+    int wheel[LEVELS][SLOTS];
+    int freeHead = NIL, live = 0;
+    uint64_t current = 0;
+    double frac = 0.0;
+};
 
-    switch(f.type){
-        case ANIM_ROTATE: {
-            float spin = f.animEnabled ? fmodf(f.t*90.0f, 360.0f) : 0.0f;
-            glPushMatrix();
-            glRotatef(spin, 0, 1, 0);
-            float toriiCol[3]={r,g,b};
-            drawTorii({0,0,0}, 1.6f, toriiCol);
-            glPopMatrix();
+static TimerWheel gameTimers(256);
+static uint64_t timeUpTick = 0;     // wheel tick at which the countdown runs out
+static TimerHandle timeUpTimer = 0;
 
-            glPushMatrix();
-            float rise = f.animEnabled ? (0.4f + 0.3f*sinf(f.t*2.2f)) : 0.2f;
-            glTranslatef(0.0f, 4.8f + rise, 0.0f);
-            drawGlowingOrb({0,0,0}, 0.7f + glowPulse*0.25f, toriiCol, 0.55f + glowPulse*0.35f);
-            glPopMatrix();
+// Schedules the timers the current game state implies; call after the wheel is reset
+static void armGameTimers(){
+    timeUpTimer = gameState == PLAYING ? gameTimers.scheduleAt(timeUpTick, {EVT_TIME_UP, 0}) : 0;
+}
 
-            glPushMatrix();
-            float petalSpin = f.animEnabled ? fmodf(f.t*140.0f, 360.0f) : 0.0f;
-            glRotatef(petalSpin, 0, 1, 0);
-            drawHaloRing({0, 3.0f, 0}, 1.0f, 3.5f, toriiCol, 0.25f + glowPulse*0.3f);
-            glPopMatrix();
+static float countdownRemaining(){
+    return (float)(((double)timeUpTick - (double)gameTimers.now() - gameTimers.fraction()) * TIMER_TICK_SECONDS);
+}
 
-            drawHaloRing({0, 0.6f, 0}, 0.5f, 2.5f, toriiCol, 0.3f + glowPulse*0.3f);
-        } break;
-        case ANIM_SCALE: {
-            float scalePulse = f.animEnabled ? (1.0f + 0.18f*sinf(f.t*1.8f)) : 1.0f;
-            glPushMatrix();
-            glScalef(scalePulse, 1.0f + 0.25f*sinf(f.t*2.1f), scalePulse);
-            float pagodaCol[3]={r,g,b};
-            drawPagoda({0,0,0}, 1.0f, pagodaCol);
-            glPopMatrix();
+// --------------------------- Render backend ---------------------------
+// The scene's draw functions go through gfx instead of calling GL: immediate-mode
+// primitives, coloured vertex arrays, the modelview stack, the camera and the one blend
+// state the game uses besides opaque. GlBackend forwards each call to the fixed-function
+// pipeline, so the windowed game draws exactly as before; SoftwareRasterizer renders the
+// same calls into memory without a GL context, and CoreProfileBackend (--gl33) draws them
+// with shaders. A few hooks let a backend keep geometry on the GPU or draw it cheaper:
+// compile-time meshes, glow effects, glow sprites and retained blocks of static geometry;
+// their defaults fall back to the plain calls. The software rasterizer has no textures,
+// so it keeps drawing glows as triangles. The static layer cache stays fixed-function only.
+enum DrawMode { DRAW_TRIANGLES=0, DRAW_QUADS, DRAW_LINES, DRAW_LINE_LOOP, DRAW_POINTS };
+enum BlendMode { BLEND_OPAQUE=0, BLEND_ADDITIVE }; // additive: dst + src*alpha, depth tested but not written
+enum GlowShape { GLOW_HALO_RING=0, GLOW_ORB };
+
+// Compile-time mesh vertices and colour tints (see Compile-time meshes)
+struct MeshTint {
+    int slot;   // palette entry, -1 for a fixed colour
+    Vec3 mul, add;
+};
 
-            glPushMatrix();
-            glRotatef(f.animEnabled ? fmodf(f.t*60.0f, 360.0f) : 0.0f, 0, 1, 0);
-            drawHaloRing({0, 3.1f, 0}, 0.8f, 2.6f, pagodaCol, 0.35f + glowPulse*0.35f);
-            glPopMatrix();
-            drawGlowingOrb({0, 4.2f, 0}, 0.55f + glowPulse*0.2f, pagodaCol, 0.4f + glowPulse*0.4f);
-        } break;
-        case ANIM_TRANSLATE: {
-            float bob = f.animEnabled ? 0.7f*sinf(f.t*1.6f) : 0.0f;
-            glPushMatrix();
-            glTranslatef(0, bob, 0);
-            float bodyCol[3]={std::min(1.0f, r*1.1f), std::min(1.0f, g*0.6f + 0.2f), std::min(1.0f, b*0.5f + 0.15f)};
-            float frameCol[3]={0.45f, 0.2f, 0.12f};
-            float ropeCol[3]={0.95f, 0.9f, 0.8f};
-            drawTaikoDrum(1.2f, 0.9f, bodyCol, frameCol, ropeCol);
-            glPopMatrix();
-
-            auto drawMallet = [&](float side){
-                glPushMatrix();
-                glTranslatef(side * 2.1f, 1.5f, 0.0f);
-                float swing = f.animEnabled ? 20.0f*sinf(f.t*2.4f + side) : 4.0f;
-                glRotatef(swing, 0, 0, 1);
-                drawSolidBox({{0.0f, 0.45f, 0.0f}, {0.08f, 0.45f, 0.08f}}, 0.75f, 0.7f, 0.65f);
-                drawSolidBox({{0.0f, 1.0f, 0.0f}, {0.28f, 0.18f, 0.28f}}, 0.3f, 0.3f, 0.3f);
-                glPopMatrix();
-            };
-            drawMallet(-1.0f);
-            drawMallet(1.0f);
+struct MeshVertex {
+    float x, y, z;
+    int prim;
+};
 
-            drawHaloRing({0, 0.2f, 0}, 0.5f, 1.9f, bodyCol, 0.3f + glowPulse*0.45f);
-        } break;
-        case ANIM_COLOR: {
-            float colorShift = f.animEnabled ? (0.3f + 0.7f*(0.5f+0.5f*sinf(f.t*2.4f))) : 0.4f;
-            float stoneCol[3]={0.65f + 0.2f*r, 0.6f + 0.2f*g, 0.55f + 0.2f*b};
-            float glowCol[3]={0.9f, 0.8f + 0.15f*colorShift, 0.4f + 0.25f*colorShift};
-            glPushMatrix();
-            glScalef(1.0f, 1.0f + 0.15f*sinf(f.t*3.0f), 1.0f);
-            drawStoneLantern(1.0f, stoneCol, glowCol);
-            glPopMatrix();
+struct MeshPalette { float col[3][3]; };
 
-            drawHaloRing({0, 0.4f, 0}, 0.4f, 2.0f, glowCol, 0.35f + glowPulse*0.5f);
-        } break;
-    }
+// A static triangle mesh whose vertex colours are tints of a per-draw palette
+struct MeshGeometry {
+    const MeshVertex* verts;
+    int count;
+    const MeshTint* tints;  // indexed by MeshVertex::prim, tintStride bytes apart
+    size_t tintStride;
+    const uint32_t* (*tinted)(const MeshPalette& pal); // per-vertex colours for a palette (cached)
+};
+
+// Retained block ids
+static const uint64_t RETAIN_COURTYARD = 1;      // + quality level (its background differs)
+static const uint64_t RETAIN_CHUNK = 1ull << 63; // | packed chunk coordinates
 
-    glPopMatrix();
+// Glow sprites: a halo ring or glow orb as one textured quad over a pre-generated falloff
+// atlas. Orbs face the camera; rings lie in their XZ plane. The atlas has one cell for
+// orbs and one per halo inner/outer radius ratio.
+struct GlowSpriteVertex {
+    float x, y, z, u, v;
+    uint32_t rgba; // bytes r,g,b,a in memory order
+};
+
+static const int GLOW_CELL = 64, GLOW_CELLS = 4; // atlas is GLOW_CELLS*GLOW_CELL x GLOW_CELL
+static const float GLOW_RING_RATIOS[GLOW_CELLS-1] = { 0.2f, 0.3f, 0.4f };
+
+// Atlas cell of a glow: 0 for orbs, else the ring cell whose ratio is closest to r0/r1
+static int glowCell(GlowShape shape, float r0, float r1){
+    if(shape == GLOW_ORB || r1 <= 0.0f) return 0;
+    float ratio = r0 / r1;
+    int best = 0;
+    for(int i=1;i<GLOW_CELLS-1;i++)
+        if(std::fabs(GLOW_RING_RATIOS[i] - ratio) < std::fabs(GLOW_RING_RATIOS[best] - ratio)) best = i;
+    return 1 + best;
 }
 
-// --------------------------- Scene setup ---------------------------
-static void resetGame(){
-    playerPos = {0.0f, 1.0f, 0.0f};
-    playerDir = {0.0f, 0.0f, -1.0f};
-    playerYawDeg = 0.0f;
-    playerVelY = 0.0f;
-    playerOnGround = true;
-    camPos = {0.0f, 18.0f, 28.0f};
-    camTarget = {0.0f, 0.0f, 0.0f};
-    camUp = {0.0f, 1.0f, 0.0f};
-    camMode = CAM_FOLLOW;
-    gameTime = 120.0f;
-    gameState = PLAYING;
-    
-    // Reset audio
-    audioWin.played = false;
-    audioLose.played = false;
-    if(audioBgm.loaded) playAudio(audioBgm);
-
-    // Ground
-    groundBox = {{0.0f, 0.0f, 0.0f}, {WORLD_HALF, 0.2f, WORLD_HALF}};
+// Alpha of the atlas, row-major. Like the vertex alphas of the triangle versions, orbs
+// fade from the centre to the rim and rings ramp up from the inner radius to the outer
+// one, where they end over a texel. The outermost texels of each cell stay zero, so
+// linear filtering never bleeds between cells.
+static std::vector<unsigned char> glowAtlasPixels(){
+    const int w = GLOW_CELLS * GLOW_CELL;
+    const float radius = GLOW_CELL * 0.5f - 1.0f;
+    std::vector<unsigned char> alpha((size_t)w * GLOW_CELL, 0);
+    for(int cell=0; cell<GLOW_CELLS; cell++){
+        for(int y=0;y<GLOW_CELL;y++){
+            for(int x=0;x<GLOW_CELL;x++){
+                float dx = x + 0.5f - GLOW_CELL*0.5f, dy = y + 0.5f - GLOW_CELL*0.5f;
+                float d = std::sqrt(dx*dx + dy*dy) / radius;
+                float a;
+                if(cell == 0) a = 1.0f - d;
+                else {
+                    float inner = GLOW_RING_RATIOS[cell-1];
+                    a = (d - inner) / (1.0f - inner) * std::min(1.0f, (1.0f - d) * radius);
+                }
+                a = std::min(1.0f, std::max(0.0f, a));
+                alpha[(size_t)y*w + cell*GLOW_CELL + x] = (unsigned char)(a * 255.0f + 0.5f);
+            }
+        }
+    }
+    return alpha;
+}
 
-    // Walls: make U-shape (3 walls)
-    walls.clear();
-    walls.push_back({{0.0f, 2.0f, -WORLD_HALF+1.0f}, {WORLD_HALF, 2.0f, 1.0f}}); // back
-    walls.push_back({{-WORLD_HALF+1.0f, 2.0f, 0.0f}, {1.0f, 2.0f, WORLD_HALF}}); // left
-    walls.push_back({{ WORLD_HALF-1.0f, 2.0f, 0.0f}, {1.0f, 2.0f, WORLD_HALF}}); // right
+class RenderBackend {
+public:
+    virtual ~RenderBackend(){}
+
+    // Replaces the projection and resets the modelview; lookAt() then multiplies the view in
+    virtual void perspective(double fovyDeg, double aspect, double zNear, double zFar) = 0;
+    virtual void lookAt(const Vec3& eye, const Vec3& target, const Vec3& up) = 0;
+
+    virtual void pushMatrix() = 0;
+    virtual void popMatrix() = 0;
+    virtual void loadIdentity() = 0;
+    virtual void translate(float x, float y, float z) = 0;
+    virtual void rotate(float deg, float x, float y, float z) = 0;
+    virtual void scale(float x, float y, float z) = 0;
+    virtual void modelview(float out[16]) = 0; // column-major
+    virtual void projection(float out[16]) = 0;
+
+    virtual void color(float r, float g, float b) = 0;
+    virtual void begin(DrawMode mode) = 0;
+    virtual void vertex(float x, float y, float z) = 0;
+    virtual void end() = 0;
+    // Positions and colours (bytes r,g,b,a) are read at the given byte strides
+    virtual void drawArrays(DrawMode mode, int count, const float* xyz, size_t xyzStride, const uint32_t* rgba, size_t rgbaStride) = 0;
+
+    // Additive must be switched back to opaque before the frame ends
+    virtual void setBlend(BlendMode mode) = 0;
+    virtual void pointSize(float px) = 0;
+
+    // A compile-time mesh under the current modelview
+    virtual void drawMesh(const MeshGeometry& mesh, const MeshPalette& pal){
+        drawArrays(DRAW_TRIANGLES, mesh.count, &mesh.verts[0].x, sizeof(MeshVertex), mesh.tinted(pal), sizeof(uint32_t));
+    }
+    // An additive halo ring (radii r0..r1) or glow orb (radius r0) at the current modelview.
+    // Returns false if the caller should queue it instead.
+    virtual bool glow(GlowShape shape, const Vec3& center, float r0, float r1, const float col[3], float alpha){
+        (void)shape; (void)center; (void)r0; (void)r1; (void)col; (void)alpha;
+        return false;
+    }
+    // Geometry drawn between beginRetained(id) and endRetained() must be the same every
+    // time for that id (in the space of the modelview current at beginRetained). Returns
+    // false when the backend drew its retained copy, in which case the caller skips the
+    // block and does not call endRetained(). Opaque triangles and lines only.
+    virtual bool beginRetained(uint64_t id){ (void)id; return true; }
+    virtual void endRetained(){}
+    // Window-space text quads (x, y, u, v floats then r, g, b, a bytes per vertex) over an
+    // alpha atlas; returns false if the caller should draw them itself
+    virtual bool drawTextQuads(const void* verts, size_t stride, int count, unsigned atlas, int w, int h){
+        (void)verts; (void)stride; (void)count; (void)atlas; (void)w; (void)h;
+        return false;
+    }
+    // Eye-space glow sprite quads (4 vertices each) under the additive blend; returns false
+    // if the caller should draw the glows as triangles instead
+    virtual bool drawGlowSprites(const GlowSpriteVertex* verts, int count){
+        (void)verts; (void)count;
+        return false;
+    }
+    // Issues anything the backend deferred; called once everything for a view is submitted
+    virtual void flush(){}
+};
 
-    // Platforms in four quadrants with different colors, sizes, AND heights for visual distinction
-    platforms[0] = {{ {-20, 0.3f, -20}, {8, 0.3f, 6} }, {0.8f,0.2f,0.2f}}; // red - lowest
-    platforms[1] = {{ { 20, 0.4f, -15}, {6, 0.4f, 8} }, {0.2f,0.6f,0.9f}}; // blue - medium-low
-    platforms[2] = {{ {-18, 0.5f,  20}, {7, 0.5f, 7} }, {0.2f,0.8f,0.3f}}; // green - highest
-    platforms[3] = {{ { 18, 0.35f, 18}, {9, 0.35f, 5} }, {0.9f,0.8f,0.2f}}; // yellow - medium
+// Column-major projection and modelview stack with the fixed-function/GLU conventions, for
+// backends that have no pipeline matrices of their own
+class MatrixStack {
+public:
+    static const int MAX_DEPTH = 32;
+
+    MatrixStack(){ reset(); }
+
+    void reset(){ proj = mat4Identity(); stack[0] = mat4Identity(); depth = 0; }
+    void perspective(double fovyDeg, double aspect, double zNear, double zFar){
+        double f = 1.0 / std::tan(fovyDeg * 0.5 * PI_F / 180.0);
+        proj = mat4Identity();
+        proj.m[0] = (float)(f / aspect); proj.m[5] = (float)f;
+        proj.m[10] = (float)((zFar + zNear) / (zNear - zFar)); proj.m[11] = -1.0f;
+        proj.m[14] = (float)(2.0 * zFar * zNear / (zNear - zFar)); proj.m[15] = 0.0f;
+        stack[depth] = mat4Identity();
+    }
+    void lookAt(const Vec3& eye, const Vec3& target, const Vec3& up){
+        Vec3 f = normalized(sub(target, eye));
+        Vec3 s = normalized(cross(f, up));
+        Vec3 u = cross(s, f);
+        Mat4 v = mat4Identity();
+        float* m = v.m;
+        m[0] = s.x; m[4] = s.y; m[8]  = s.z;
+        m[1] = u.x; m[5] = u.y; m[9]  = u.z;
+        m[2] = -f.x; m[6] = -f.y; m[10] = -f.z;
+        multiply(v);
+        translate(-eye.x, -eye.y, -eye.z);
+    }
 
-    // Setup obstacles for each platform to create platformer challenges
-    obstacles.clear();
+    void push(){ if(depth + 1 < MAX_DEPTH){ stack[depth+1] = stack[depth]; depth++; } }
+    void pop(){ if(depth > 0) depth--; }
+    void loadIdentity(){ stack[depth] = mat4Identity(); }
+    void load(const Mat4& m){ stack[depth] = m; }
+    void translate(float x, float y, float z){ multiply(mat4Translation(x, y, z)); }
+    void rotate(float deg, float x, float y, float z){
+        if(x*x + y*y + z*z <= 0.0f) return;
+        multiply(mat4Rotation(deg, x, y, z));
+    }
+    void scale(float x, float y, float z){ multiply(mat4Scaling(x, y, z)); }
 
-    // Platform 0 (Red/Torii): Small walls as barriers
-    obstacles.push_back({{{-23.0f, 1.5f, -20.0f}, {0.5f, 1.2f, 2.0f}}, {0.6f, 0.15f, 0.15f}, false, 0, 0, {0,0,0}, 0});
-    obstacles.push_back({{{-17.0f, 1.5f, -20.0f}, {0.5f, 1.2f, 2.0f}}, {0.6f, 0.15f, 0.15f}, false, 0, 0, {0,0,0}, 0});
-    obstacles.push_back({{{-20.0f, 1.0f, -17.0f}, {3.0f, 0.7f, 0.5f}}, {0.6f, 0.15f, 0.15f}, false, 0, 0, {0,0,0}, 0});
+    const Mat4& modelview() const { return stack[depth]; }
+    const Mat4& projection() const { return proj; }
+    Mat4 modelviewProjection() const { return mat4Mul(proj, stack[depth]); }
 
-    // Platform 1 (Blue/Pagoda): Multi-level elevated sections (stairs-like)
-    obstacles.push_back({{{ 17.5f, 1.5f, -15.0f}, {2.0f, 1.2f, 2.5f}}, {0.15f, 0.4f, 0.7f}, false, 0, 0, {0,0,0}, 0});
-    obstacles.push_back({{{ 21.0f, 2.5f, -15.0f}, {2.0f, 2.2f, 2.5f}}, {0.15f, 0.4f, 0.7f}, false, 0, 0, {0,0,0}, 0});
-    obstacles.push_back({{{ 24.0f, 3.5f, -15.0f}, {2.0f, 3.2f, 2.5f}}, {0.15f, 0.4f, 0.7f}, false, 0, 0, {0,0,0}, 0});
+private:
+    static Vec3 cross(const Vec3& a, const Vec3& b){ return { a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x }; }
+    static Vec3 normalized(const Vec3& v){ float l = std::sqrt(v.x*v.x + v.y*v.y + v.z*v.z); return l > 0.0f ? mul(v, 1.0f/l) : v; }
+    void multiply(const Mat4& m){ stack[depth] = mat4Mul(stack[depth], m); }
 
-    // Platform 2 (Green/Taiko): Moving horizontal obstacles
-    Vec3 moveBase1 = {-18.0f, 1.5f, 18.0f};
-    obstacles.push_back({{moveBase1, {1.5f, 1.2f, 0.5f}}, {0.15f, 0.6f, 0.2f}, true, 3.0f, 4.0f, moveBase1, 0});
-    Vec3 moveBase2 = {-18.0f, 1.5f, 22.0f};
-    obstacles.push_back({{moveBase2, {1.5f, 1.2f, 0.5f}}, {0.15f, 0.6f, 0.2f}, true, 2.5f, 3.5f, moveBase2, 1.5f});
+    Mat4 proj;
+    Mat4 stack[MAX_DEPTH];
+    int depth;
+};
 
-    // Platform 3 (Yellow/Lantern): Mix - elevated sections and static barriers
-    obstacles.push_back({{{ 15.0f, 2.0f, 18.0f}, {2.5f, 1.7f, 2.0f}}, {0.7f, 0.6f, 0.15f}, false, 0, 0, {0,0,0}, 0});
-    obstacles.push_back({{{ 21.0f, 1.2f, 16.0f}, {1.0f, 0.9f, 1.0f}}, {0.7f, 0.6f, 0.15f}, false, 0, 0, {0,0,0}, 0});
-    obstacles.push_back({{{ 18.0f, 1.0f, 21.0f}, {2.0f, 0.7f, 0.5f}}, {0.7f, 0.6f, 0.15f}, false, 0, 0, {0,0,0}, 0});
+class GlBackend : public RenderBackend {
+public:
+    void perspective(double fovyDeg, double aspect, double zNear, double zFar) override {
+        glMatrixMode(GL_PROJECTION); glLoadIdentity();
+        gluPerspective(fovyDeg, aspect, zNear, zFar);
+        glMatrixMode(GL_MODELVIEW); glLoadIdentity();
+    }
+    void lookAt(const Vec3& eye, const Vec3& target, const Vec3& up) override {
+        gluLookAt(eye.x,eye.y,eye.z, target.x,target.y,target.z, up.x,up.y,up.z);
+    }
 
-    // Feature objects centered on each platform
-    // Red oracle - on ground
-    features[0].box.center = {platforms[0].box.center.x, 0.0f, platforms[0].box.center.z};
-    features[0].box.half = {1.6f,2.6f,1.0f};
-    features[0].baseColor[0] = 0.8f; features[0].baseColor[1] = 0.15f; features[0].baseColor[2] = 0.15f;
-    features[0].type = ANIM_ROTATE;
-    features[0].allCollected = false;
-    features[0].animEnabled = false;
-    features[0].t = 0.0f;
+    void pushMatrix() override { glPushMatrix(); }
+    void popMatrix() override { glPopMatrix(); }
+    void loadIdentity() override { glLoadIdentity(); }
+    void translate(float x, float y, float z) override { glTranslatef(x, y, z); }
+    void rotate(float deg, float x, float y, float z) override { glRotatef(deg, x, y, z); }
+    void scale(float x, float y, float z) override { glScalef(x, y, z); }
+    void modelview(float out[16]) override { glGetFloatv(GL_MODELVIEW_MATRIX, out); }
+    void projection(float out[16]) override { glGetFloatv(GL_PROJECTION_MATRIX, out); }
+
+    void color(float r, float g, float b) override { glColor3f(r, g, b); }
+    void begin(DrawMode mode) override { drawCallCount++; glBegin(glMode(mode)); }
+    void vertex(float x, float y, float z) override { glVertex3f(x, y, z); }
+    void end() override { glEnd(); }
+    void drawArrays(DrawMode mode, int count, const float* xyz, size_t xyzStride, const uint32_t* rgba, size_t rgbaStride) override {
+        glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, (GLsizei)xyzStride, xyz);
+        glColorPointer(4, GL_UNSIGNED_BYTE, (GLsizei)rgbaStride, rgba);
+        drawCallCount++;
+        glDrawArrays(glMode(mode), 0, count);
+        glPopClientAttrib();
+    }
 
-    // Blue oracle - floating 3 units above ground
-    features[1].box.center = {platforms[1].box.center.x, 3.0f, platforms[1].box.center.z};
-    features[1].box.half = {1.6f,2.6f,1.6f};
-    features[1].baseColor[0] = 0.7f; features[1].baseColor[1] = 0.4f; features[1].baseColor[2] = 0.9f;
-    features[1].type = ANIM_SCALE;
-    features[1].allCollected = false;
-    features[1].animEnabled = false;
-    features[1].t = 0.0f;
+    void setBlend(BlendMode mode) override {
+        if(mode == BLEND_ADDITIVE && !additive){
+            glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_POINT_BIT);
+            glDisable(GL_LIGHTING);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            glDepthMask(GL_FALSE);
+        } else if(mode == BLEND_OPAQUE && additive){
+            glPopAttrib();
+        }
+        additive = mode == BLEND_ADDITIVE;
+    }
+    void pointSize(float px) override { glPointSize(px); }
+
+    bool drawGlowSprites(const GlowSpriteVertex* verts, int count) override {
+        if(!glowAtlas){
+            std::vector<unsigned char> alpha = glowAtlasPixels();
+            glGenTextures(1, &glowAtlas);
+            glBindTexture(GL_TEXTURE_2D, glowAtlas);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, GLOW_CELLS*GLOW_CELL, GLOW_CELL, 0, GL_ALPHA, GL_UNSIGNED_BYTE, alpha.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, glowAtlas);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(GlowSpriteVertex), &verts[0].x);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(GlowSpriteVertex), &verts[0].u);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(GlowSpriteVertex), &verts[0].rgba);
+        drawCallCount++;
+        glDrawArrays(GL_QUADS, 0, count);
+        glPopClientAttrib();
+        glPopAttrib();
+        return true;
+    }
 
-    // Green oracle - floating 2.5 units above ground
-    features[2].box.center = {platforms[2].box.center.x, 2.5f, platforms[2].box.center.z};
-    features[2].box.half = {1.6f,2.0f,1.6f};
-    features[2].baseColor[0] = 0.9f; features[2].baseColor[1] = 0.3f; features[2].baseColor[2] = 0.3f;
-    features[2].type = ANIM_TRANSLATE;
-    features[2].allCollected = false;
-    features[2].animEnabled = false;
-    features[2].t = 0.0f;
+private:
+    static GLenum glMode(DrawMode mode){
+        static const GLenum modes[] = { GL_TRIANGLES, GL_QUADS, GL_LINES, GL_LINE_LOOP, GL_POINTS };
+        return modes[mode];
+    }
+    bool additive = false;
+    GLuint glowAtlas = 0;
+};
 
-    // Yellow oracle - floating 3.5 units above ground
-    features[3].box.center = {platforms[3].box.center.x, 3.5f, platforms[3].box.center.z};
-    features[3].box.half = {1.6f,2.2f,1.6f};
-    features[3].baseColor[0] = 0.6f; features[3].baseColor[1] = 0.6f; features[3].baseColor[2] = 0.7f;
-    features[3].type = ANIM_COLOR;
-    features[3].allCollected = false;
-    features[3].animEnabled = false;
-    features[3].t = 0.0f;
+static GlBackend glBackend;
+static RenderBackend* gfx = &glBackend;
+static bool coreProfile = false; // --gl33: gfx draws through a 3.3 core context, which has no fixed-function state
+
+// --------------------------- Software rasterizer ---------------------------
+// A RenderBackend that draws into its own colour (RGBA8) and depth (float) buffers. Every
+// primitive is transformed, clipped against the near plane and set up as a flat-coloured
+// screen triangle when it is submitted (lines become one-pixel quads, points squares),
+// and binned into 64x64 tiles in submission order. finishFrame() then clears and
+// rasterizes the tiles in parallel on the worker pool, four pixels at a time: edge
+// functions and the depth test in f4 lanes, colour as packed bytes with a masked select
+// (opaque) or a saturating add (additive). Colours follow GL flat shading: each triangle
+// takes its last vertex's colour. Coverage uses a top-left rule so shared edges are
+// drawn once. Rows are stored bottom-up, like glReadPixels.
+class SoftwareRasterizer : public RenderBackend {
+public:
+    static const int TILE = 64;
+
+    // Sizes the buffers (reused across frames) and starts a frame that will be cleared to rgb
+    void beginFrame(int w, int h, float r, float g, float b){
+        if(w != W || h != H){
+            W = w; H = h;
+            rowStride = (W + 3) & ~3;
+            colorBuf.assign((size_t)rowStride * H, 0);
+            depthStore.assign((size_t)rowStride * H + 4, 1.0f);
+            size_t misalign = (reinterpret_cast<uintptr_t>(depthStore.data()) / sizeof(float)) & 3;
+            depthBuf = depthStore.data() + (misalign ? 4 - misalign : 0);
+            tilesX = (W + TILE - 1) / TILE; tilesY = (H + TILE - 1) / TILE;
+            bins.assign((size_t)tilesX * tilesY, std::vector<uint32_t>());
+        }
+        clearColor = packRGBA(r, g, b, 1.0f);
+        tris.clear();
+        for(auto& b : bins) b.clear();
+        blend = BLEND_OPAQUE;
+        mats.reset();
+        current = packRGBA(1, 1, 1, 1);
+    }
 
-    // Collectibles: 3 per platform arranged in small triangle pattern
-    collectibles.clear();
-    for(int i=0;i<4;i++){ collectedPerPlatform[i]=0; }
+    void finishFrame(){
+        auto rasterTiles = [&](int begin, int end){ for(int t=begin;t<end;t++) rasterTile(t); };
+        workerPool().parallelFor(tilesX * tilesY, 1, rasterTiles);
+    }
 
-    auto platformSurfaceY = [&](int pi){
-        const Platform& p = platforms[pi];
-        return p.box.center.y + p.box.half.y;
-    };
+    int width() const { return W; }
+    int height() const { return H; }
+    int stride() const { return rowStride; }             // pixels per row
+    const uint32_t* pixels() const { return colorBuf.data(); } // bytes r,g,b,a; bottom row first
+    size_t triangleCount() const { return tris.size(); }
+
+    // RenderBackend
+    void perspective(double fovyDeg, double aspect, double zNear, double zFar) override { mats.perspective(fovyDeg, aspect, zNear, zFar); }
+    void lookAt(const Vec3& eye, const Vec3& target, const Vec3& up) override { mats.lookAt(eye, target, up); }
+
+    void pushMatrix() override { mats.push(); }
+    void popMatrix() override { mats.pop(); }
+    void loadIdentity() override { mats.loadIdentity(); }
+    void translate(float x, float y, float z) override { mats.translate(x, y, z); }
+    void rotate(float deg, float x, float y, float z) override { mats.rotate(deg, x, y, z); }
+    void scale(float x, float y, float z) override { mats.scale(x, y, z); }
+    void modelview(float out[16]) override { std::memcpy(out, mats.modelview().m, 16*sizeof(float)); }
+    void projection(float out[16]) override { std::memcpy(out, mats.projection().m, 16*sizeof(float)); }
+
+    void color(float r, float g, float b) override { current = packRGBA(r, g, b, 1.0f); }
+    void begin(DrawMode m) override { mode = m; immediate.clear(); }
+    void vertex(float x, float y, float z) override { immediate.push_back({x, y, z, current}); }
+    void end() override {
+        const ImmVertex* v = immediate.data();
+        submit(mode, (int)immediate.size(), &v->x, sizeof(ImmVertex), &v->rgba, sizeof(ImmVertex));
+    }
+    void drawArrays(DrawMode m, int count, const float* xyz, size_t xyzStride, const uint32_t* rgba, size_t rgbaStride) override {
+        submit(m, count, xyz, xyzStride, rgba, rgbaStride);
+    }
 
-    auto addCollectible = [&](int pi, float offx, float offz, float heightAboveSurface, float r, float g, float b){
-        const Platform& p = platforms[pi];
-        Vec3 c = {p.box.center.x + offx, platformSurfaceY(pi) + heightAboveSurface, p.box.center.z + offz};
-        Collectible col;
-        col.box = { c, {0.18f, 0.35f, 0.18f} };
-        col.color[0]=r; col.color[1]=g; col.color[2]=b;
-        col.collected=false; col.platformIndex=pi;
-        collectibles.push_back(col);
+    void setBlend(BlendMode mode) override { blend = mode; }
+    void pointSize(float px) override { pointPx = std::max(1.0f, px); }
+
+private:
+    struct ImmVertex { float x, y, z; uint32_t rgba; };
+    struct ClipVertex { float x, y, z, w; };
+    struct ScreenVertex { double x, y, z; };
+
+    // Edge and depth planes are stored relative to (refX, refY), the triangle's first
+    // covered pixel centre, so they stay precise for vertices far off screen
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3], edgeMin[3];
+        float zA, zB, zC;
+        int minX, minY, maxX, maxY;
+        float refX, refY;
+        uint32_t color;   // opaque: the colour; additive: rgb*alpha, added with saturation
+        uint8_t blend;
     };
 
-    // Red platform - keep as is (accessible)
-    addCollectible(0, -2.0f, -1.5f, 0.25f, 0.9f,0.3f,0.3f);
-    addCollectible(0,  2.2f, -1.2f, 0.65f, 0.9f,0.5f,0.3f);
-    addCollectible(0,  0.0f,  2.0f, 1.2f, 0.9f,0.3f,0.5f);
-
-    // Blue platform - repositioned to avoid stair obstacles
-    addCollectible(1, -4.0f, -5.0f, 0.35f, 0.3f,0.7f,0.9f); // Front left, clear of obstacles
-    addCollectible(1,  4.0f, -5.0f, 1.0f, 0.3f,0.9f,0.7f); // Front right, higher ledge
-    addCollectible(1,  0.0f,  5.0f, 1.6f, 0.5f,0.8f,0.9f); // Back center, atop stairs
+    static uint32_t packRGBA(float r, float g, float b, float a){
+        auto byte = [](float v){ return (uint32_t)(std::min(1.0f, std::max(0.0f, v)) * 255.0f + 0.5f); };
+        return byte(r) | (byte(g)<<8) | (byte(b)<<16) | (byte(a)<<24);
+    }
 
-    // Green platform - keep as is (accessible)
-    addCollectible(2, -2.0f,  1.4f, 0.35f, 0.2f,0.9f,0.3f);
-    addCollectible(2,  2.0f,  0.0f, 0.7f, 0.2f,0.7f,0.4f);
-    addCollectible(2,  0.0f, -1.8f, 1.2f, 0.2f,0.9f,0.6f);
+    void submit(DrawMode m, int count, const float* xyz, size_t xyzStride, const uint32_t* rgba, size_t rgbaStride){
+        // All vertices to clip space up front; primitives then index them
+        if(clipStore.size() < (size_t)count * 4 + 3) clipStore.resize((size_t)count * 4 + 3);
+        size_t misalign = (reinterpret_cast<uintptr_t>(clipStore.data()) / sizeof(float)) & 3;
+        Vec4* clip = reinterpret_cast<Vec4*>(clipStore.data() + (misalign ? 4 - misalign : 0));
+        transformPoints(mats.modelviewProjection(), xyz, xyzStride, count, clip);
+        auto at = [&](int i){ const Vec4& c = clip[i]; return ClipVertex{ c.x, c.y, c.z, c.w }; };
+        auto colorAt = [&](int i){ return *reinterpret_cast<const uint32_t*>(reinterpret_cast<const char*>(rgba) + i * rgbaStride); };
+
+        switch(m){
+            case DRAW_TRIANGLES:
+                for(int i=0;i+2<count;i+=3) clipTriangle(at(i), at(i+1), at(i+2), colorAt(i+2));
+                break;
+            case DRAW_QUADS:
+                for(int i=0;i+3<count;i+=4){
+                    ClipVertex v0 = at(i), v2 = at(i+2);
+                    uint32_t c = colorAt(i+3);
+                    clipTriangle(v0, at(i+1), v2, c);
+                    clipTriangle(v0, v2, at(i+3), c);
+                }
+                break;
+            case DRAW_LINES:
+                for(int i=0;i+1<count;i+=2) line(at(i), at(i+1), colorAt(i+1));
+                break;
+            case DRAW_LINE_LOOP:
+                for(int i=0;i<count && count>1;i++) line(at(i), at((i+1) % count), colorAt(i+1 < count ? i+1 : 0));
+                break;
+            case DRAW_POINTS:
+                for(int i=0;i<count;i++) point(at(i), colorAt(i));
+                break;
+        }
+    }
 
-    // Yellow platform - repositioned to avoid large obstacles
-    addCollectible(3, -7.0f,  0.0f, 0.4f, 0.9f,0.9f,0.3f); // Left edge, clear
-    addCollectible(3,  6.0f,  0.0f, 1.1f, 0.9f,0.8f,0.2f); // Right edge, elevated
-    addCollectible(3,  0.0f, -4.0f, 0.8f, 0.9f,0.7f,0.2f); // Front, mid-height
+    ScreenVertex toScreen(const ClipVertex& v) const {
+        double iw = 1.0 / v.w;
+        return { (v.x*iw*0.5 + 0.5) * W, (v.y*iw*0.5 + 0.5) * H, v.z*iw*0.5 + 0.5 };
+    }
 
-    // Reset feature gates
-    for(int i=0;i<4;i++){
-        features[i].allCollected=false;
-        features[i].animEnabled=false;
-        features[i].t=0.0f;
+    // Near-plane clip (z >= -w), then a fan of screen triangles
+    void clipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, uint32_t rgba){
+        const ClipVertex in[3] = { a, b, c };
+        ClipVertex out[4];
+        int n = 0;
+        for(int i=0;i<3;i++){
+            const ClipVertex& p = in[i]; const ClipVertex& q = in[(i+1)%3];
+            float dp = p.z + p.w, dq = q.z + q.w;
+            if(dp >= 0.0f) out[n++] = p;
+            if((dp >= 0.0f) != (dq >= 0.0f)){
+                float t = dp / (dp - dq);
+                out[n++] = { p.x + (q.x-p.x)*t, p.y + (q.y-p.y)*t, p.z + (q.z-p.z)*t, p.w + (q.w-p.w)*t };
+            }
+        }
+        if(n < 3) return;
+        ScreenVertex s0 = toScreen(out[0]), s1 = toScreen(out[1]);
+        for(int i=2;i<n;i++){
+            ScreenVertex s2 = toScreen(out[i]);
+            addTriangle(s0, s1, s2, rgba);
+            s1 = s2;
+        }
     }
 
-    skyOracles.clear();
-    for(int i=0; i<4; i++){
-        const Platform& p = platforms[i];
-        for(int j=0; j<2; j++){
-            SkyOracle o;
-            float offx = (j==0) ? -3.0f : 3.5f;
-            float offz = (j==0) ? -2.0f : 1.5f;
-            float height = 5.0f + j * 2.0f;
-            o.pos = {p.box.center.x + offx, p.box.center.y + p.box.half.y + height, p.box.center.z + offz};
-            o.radius = 1.5f + j * 0.5f;
-            o.rotation = (float)(rand()%360);
-            o.color[0] = features[i].baseColor[0];
-            o.color[1] = features[i].baseColor[1];
-            o.color[2] = features[i].baseColor[2];
-            skyOracles.push_back(o);
+    void line(const ClipVertex& a, const ClipVertex& b, uint32_t rgba){
+        float da = a.z + a.w, db = b.z + b.w;
+        if(da < 0.0f && db < 0.0f) return;
+        ClipVertex p = a, q = b;
+        if(da < 0.0f || db < 0.0f){
+            float t = da / (da - db);
+            ClipVertex cut = { a.x + (b.x-a.x)*t, a.y + (b.y-a.y)*t, a.z + (b.z-a.z)*t, a.w + (b.w-a.w)*t };
+            if(da < 0.0f) p = cut; else q = cut;
         }
+        ScreenVertex s = toScreen(p), e = toScreen(q);
+        double dx = e.x - s.x, dy = e.y - s.y, len = std::sqrt(dx*dx + dy*dy);
+        if(len < 1e-6) return;
+        double nx = -dy / len * 0.5, ny = dx / len * 0.5;
+        ScreenVertex c0 = {s.x+nx, s.y+ny, s.z}, c1 = {s.x-nx, s.y-ny, s.z}, c2 = {e.x-nx, e.y-ny, e.z}, c3 = {e.x+nx, e.y+ny, e.z};
+        addTriangle(c0, c1, c2, rgba);
+        addTriangle(c0, c2, c3, rgba);
     }
-}
 
-// --------------------------- Collision ---------------------------
-static bool collidesWithWorld(const AABB&box){
-    // Against walls
-    for(const auto&w : walls){ if(aabbIntersects(box,w)) return true; }
-    // Against platforms - special handling to allow walking on top
-    for(const auto&p : platforms){
-        // Check if player is standing on top of platform (player's bottom is above or at platform's surface)
-        float playerBottom = box.center.y - box.half.y;
-        float platformTop = p.box.center.y + p.box.half.y;
-        float platformBottom = p.box.center.y - p.box.half.y;
+    void point(const ClipVertex& v, uint32_t rgba){
+        if(v.z + v.w < 0.0f || v.w <= 0.0f) return;
+        ScreenVertex c = toScreen(v);
+        double r = pointPx * 0.5;
+        ScreenVertex c0 = {c.x-r, c.y-r, c.z}, c1 = {c.x+r, c.y-r, c.z}, c2 = {c.x+r, c.y+r, c.z}, c3 = {c.x-r, c.y+r, c.z};
+        addTriangle(c0, c1, c2, rgba);
+        addTriangle(c0, c2, c3, rgba);
+    }
 
-        // If player's bottom is above the platform surface (with small tolerance),
-        // they're standing on top - don't block horizontal movement
-        const float tolerance = 0.5f; // Allow some overlap for standing on top
-        if(playerBottom >= platformTop - tolerance){
-            continue; // Skip collision check, player is on top
+    void addTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, uint32_t rgba){
+        double area = (v1.x - v0.x)*(v2.y - v0.y) - (v2.x - v0.x)*(v1.y - v0.y);
+        if(!(std::fabs(area) > 1e-12)) return;
+        // Covered pixel centres (px+0.5) lie inside the vertex bounds
+        double lox = std::min(v0.x, std::min(v1.x, v2.x)), hix = std::max(v0.x, std::max(v1.x, v2.x));
+        double loy = std::min(v0.y, std::min(v1.y, v2.y)), hiy = std::max(v0.y, std::max(v1.y, v2.y));
+        Triangle t;
+        t.minX = (int)std::max(0.0, std::ceil(lox - 0.5));  t.maxX = (int)std::min((double)W - 1, std::floor(hix - 0.5));
+        t.minY = (int)std::max(0.0, std::ceil(loy - 0.5));  t.maxY = (int)std::min((double)H - 1, std::floor(hiy - 0.5));
+        if(t.minX > t.maxX || t.minY > t.maxY) return;
+
+        double refX = t.minX + 0.5, refY = t.minY + 0.5;
+        double sign = area > 0.0 ? 1.0 : -1.0;
+        const ScreenVertex* v[3] = { &v0, &v1, &v2 };
+        for(int i=0;i<3;i++){
+            const ScreenVertex& p = *v[i]; const ScreenVertex& q = *v[(i+1)%3];
+            double a = (p.y - q.y) * sign, b = (q.x - p.x) * sign;
+            double c = (p.x*q.y - q.x*p.y) * sign + a*refX + b*refY;
+            t.edgeA[i] = (float)a; t.edgeB[i] = (float)b; t.edgeC[i] = (float)c;
+            // Top-left rule: a pixel centre exactly on an edge belongs to one of the two triangles
+            bool inclusive = a > 0.0 || (a == 0.0 && b < 0.0);
+            t.edgeMin[i] = inclusive ? -1e-30f : 0.0f;
+        }
+        // Depth plane z = zA*(x-refX) + zB*(y-refY) + zC
+        double e1x = v1.x - v0.x, e1y = v1.y - v0.y, e1z = v1.z - v0.z;
+        double e2x = v2.x - v0.x, e2y = v2.y - v0.y, e2z = v2.z - v0.z;
+        double zA = (e1z*e2y - e2z*e1y) / (e1x*e2y - e2x*e1y);
+        double zB = (e2z*e1x - e1z*e2x) / (e1x*e2y - e2x*e1y);
+        t.zA = (float)zA; t.zB = (float)zB;
+        t.zC = (float)(v0.z + zA*(refX - v0.x) + zB*(refY - v0.y));
+        t.refX = (float)refX; t.refY = (float)refY;
+        t.blend = (uint8_t)blend;
+        if(blend == BLEND_ADDITIVE){
+            uint32_t a = rgba >> 24;
+            auto scaled = [&](int shift){ return ((((rgba >> shift) & 0xFFu) * a + 127u) / 255u) << shift; };
+            t.color = scaled(0) | scaled(8) | scaled(16) | scaled(24);
+            if((t.color & 0x00FFFFFFu) == 0) return; // adds nothing
+        } else {
+            t.color = rgba;
         }
 
-        // If player is significantly below platform top, check for collision
-        // This handles side collisions and prevents clipping through platforms
-        if(aabbIntersects(box, p.box)) return true;
+        uint32_t index = (uint32_t)tris.size();
+        tris.push_back(t);
+        for(int ty = t.minY / TILE; ty <= t.maxY / TILE; ty++)
+            for(int tx = t.minX / TILE; tx <= t.maxX / TILE; tx++)
+                bins[(size_t)ty * tilesX + tx].push_back(index);
     }
-    // Against obstacles - same handling as platforms to allow standing on elevated obstacles
-    for(const auto&o : obstacles){
-        float playerBottom = box.center.y - box.half.y;
-        float obstacleTop = o.box.center.y + o.box.half.y;
 
-        const float tolerance = 0.5f;
-        if(playerBottom >= obstacleTop - tolerance){
-            continue; // Player is on top of obstacle
+    void rasterTile(int tile){
+        int tx = tile % tilesX, ty = tile / tilesX;
+        int x0 = tx * TILE, y0 = ty * TILE;
+        int x1 = std::min(W, x0 + TILE), y1 = std::min(H, y0 + TILE);
+        for(int y=y0;y<y1;y++){
+            std::fill(colorBuf.begin() + (size_t)y*rowStride + x0, colorBuf.begin() + (size_t)y*rowStride + x1, clearColor);
+            std::fill(depthBuf + (size_t)y*rowStride + x0, depthBuf + (size_t)y*rowStride + x1, 1.0f);
         }
 
-        if(aabbIntersects(box, o.box)) return true;
-    }
-    // Against feature objects (platform oracles) - treat as solid; allow standing on top
-    for(const auto& f : features){
-        float playerBottom = box.center.y - box.half.y;
-        float featureTop = f.box.center.y + f.box.half.y;
-        const float tolerance = 0.5f;
-        if(playerBottom >= featureTop - tolerance){
-            continue; // Player is on top of the feature
+        alignas(16) static const float laneOffset[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        const f4 lanes = f4Load(laneOffset), columnEnd = f4Set1((float)x1);
+        for(uint32_t index : bins[tile]){
+            const Triangle& t = tris[index];
+            int xs = std::max(x0, t.minX) & ~3, xe = std::min(x1 - 1, t.maxX);
+            int ys = std::max(y0, t.minY), ye = std::min(y1 - 1, t.maxY);
+            const f4 step4[3] = { f4Set1(t.edgeA[0]*4.0f), f4Set1(t.edgeA[1]*4.0f), f4Set1(t.edgeA[2]*4.0f) };
+            const f4 zStep4 = f4Set1(t.zA*4.0f);
+            const f4 edgeMin[3] = { f4Set1(t.edgeMin[0]), f4Set1(t.edgeMin[1]), f4Set1(t.edgeMin[2]) };
+            const u8x16 src = u8Set4(t.color);
+            const f4 dx = f4Add(f4Set1((float)xs - (t.refX - 0.5f)), lanes);
+            for(int y=ys;y<=ye;y++){
+                float dy = (float)y - (t.refY - 0.5f);
+                f4 e[3];
+                for(int k=0;k<3;k++) e[k] = f4Add(f4Mul(f4Set1(t.edgeA[k]), dx), f4Set1(t.edgeB[k]*dy + t.edgeC[k]));
+                f4 z = f4Add(f4Mul(f4Set1(t.zA), dx), f4Set1(t.zB*dy + t.zC));
+                f4 column = f4Add(f4Set1((float)xs), lanes);
+                uint32_t* colorRow = colorBuf.data() + (size_t)y*rowStride;
+                float* depthRow = depthBuf + (size_t)y*rowStride;
+                for(int x=xs;x<=xe;x+=4){
+                    f4 inside = f4And(f4And(f4Less(edgeMin[0], e[0]), f4Less(edgeMin[1], e[1])), f4Less(edgeMin[2], e[2]));
+                    inside = f4And(inside, f4Less(column, columnEnd));
+                    if(f4Any(inside)){
+                        f4 stored = f4Load(depthRow + x);
+                        f4 pass = f4And(inside, f4Less(z, stored));
+                        if(f4Any(pass)){
+                            u8x16 dst = u8Load(colorRow + x);
+                            if(t.blend == BLEND_OPAQUE){
+                                f4Store(depthRow + x, f4Select(pass, z, stored));
+                                u8Store(colorRow + x, u8Select(pass, src, dst));
+                            } else {
+                                u8Store(colorRow + x, u8Select(pass, u8AddSat(dst, src), dst));
+                            }
+                        }
+                    }
+                    for(int k=0;k<3;k++) e[k] = f4Add(e[k], step4[k]);
+                    z = f4Add(z, zStep4);
+                    column = f4Add(column, f4Set1(4.0f));
+                }
+            }
         }
-        if(aabbIntersects(box, f.box)) return true;
     }
-    return false;
-}
 
-static void tryMovePlayer(const Vec3&delta){
-    // Separate axis resolution to avoid sticking too much
-    AABB pb = { playerPos, playerHalf };
+    int W = 0, H = 0, rowStride = 0, tilesX = 0, tilesY = 0;
+    std::vector<uint32_t> colorBuf;
+    std::vector<float> depthStore;
+    float* depthBuf = nullptr; // 16-byte aligned start of the depth rows within depthStore
+    std::vector<Triangle> tris;
+    std::vector<std::vector<uint32_t>> bins;
+    std::vector<ImmVertex> immediate;
+    std::vector<float> clipStore; // submit()'s clip-space vertices, from its first 16-byte boundary
+    MatrixStack mats;
+    DrawMode mode = DRAW_TRIANGLES;
+    BlendMode blend = BLEND_OPAQUE;
+    uint32_t current = 0xFFFFFFFFu, clearColor = 0;
+    float pointPx = 1.0f;
+};
 
-    // X
-    Vec3 attempt = playerPos; attempt.x += delta.x;
-    pb.center = attempt; if(!collidesWithWorld(pb)) playerPos.x = attempt.x;
+// --------------------------- Render queue ---------------------------
+// The additive halo rings and glow orbs are not drawn where they are made: submit()
+// records the primitive with the current modelview and a sort key; flush() sorts the
+// frame's items and draws them all as one batch of sprites under a single additive blend
+// switch (see Render backend). A backend without sprite support gets each run of equal
+// primitive as one pre-transformed triangle batch. Opaque geometry is drawn immediately
+// (and mostly from retained blocks), so only the additive pass is queued. Key bits, high
+// to low: primitive, view depth (back-to-front).
+enum RenderPrim { PRIM_HALO_RING=GLOW_HALO_RING, PRIM_GLOW_ORB=GLOW_ORB };
+
+struct RenderItem {
+    uint64_t key;
+    float mv[16];   // modelview at submit time (column-major)
+    Vec3 center;
+    float r0, r1;   // halo: inner/outer radius; orb: radius, unused
+    float col[3];
+    float alpha;
+};
 
-    // Z
-    attempt = playerPos; attempt.z += delta.z;
-    pb.center = attempt; if(!collidesWithWorld(pb)) playerPos.z = attempt.z;
-}
+struct ColorVertex {
+    float x, y, z;
+    uint32_t rgba; // bytes r,g,b,a in memory order
+};
 
-// Check if player is standing on ground or a platform
-static bool isPlayerOnSurface(){
-    AABB pb = { playerPos, playerHalf };
-    // Check a small distance below player
-    pb.center.y -= 0.1f;
+class RenderQueue {
+public:
+    static const int HALO_SEGMENTS = 64;
+    static const int ORB_SEGMENTS = 32;
+    static const int DEPTH_BITS = 32;
 
-    // Check against ground
-    if(aabbIntersects(pb, groundBox)) return true;
+    int segmentStep = 1; // stride through the segments of triangle halos and orbs; divides both counts
 
-    // Check against platforms
-    for(const auto& p : platforms){
-        if(aabbIntersects(pb, p.box)) return true;
+    RenderQueue(){
+        for(int i=0;i<=HALO_SEGMENTS;i++){ float a = (float)i/HALO_SEGMENTS * 2.0f * PI_F; haloCos[i] = cosf(a); haloSin[i] = sinf(a); }
+        for(int i=0;i<=ORB_SEGMENTS;i++){ float a = (float)i/ORB_SEGMENTS * 2.0f * PI_F; orbCos[i] = cosf(a); orbSin[i] = sinf(a); }
     }
 
-    // Check against obstacles (for elevated platforms)
-    for(const auto& o : obstacles){
-        if(aabbIntersects(pb, o.box)) return true;
+    void submit(RenderPrim prim, const Vec3& center, float r0, float r1, const float col[3], float alpha){
+        if(gfx->glow((GlowShape)prim, center, r0, r1, col, alpha)) return; // the backend instances it
+        if(!open){ items.attach(frameArena, 64); open = true; } // first item since the last flush
+        RenderItem it;
+        gfx->modelview(it.mv);
+        it.center = center; it.r0 = r0; it.r1 = r1;
+        it.col[0] = col[0]; it.col[1] = col[1]; it.col[2] = col[2];
+        it.alpha = alpha;
+
+        float viewDepth = std::max(0.0f, -(it.mv[2]*center.x + it.mv[6]*center.y + it.mv[10]*center.z + it.mv[14]));
+        uint32_t depthBits;
+        std::memcpy(&depthBits, &viewDepth, 4); // non-negative floats order like their bit patterns
+        it.key = ((uint64_t)prim << 48) | (uint32_t)~depthBits; // far first
+        items.push_back(it);
     }
 
-    return false;
-}
+    void flush(){
+        if(!open) return;
+        open = false;
+        size_t n = items.size();
+        if(!n) return;
+        std::sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b){ return a.key < b.key; });
 
-// --------------------------- Game logic ---------------------------
-static void updateCollectibles(){
-    AABB pb = { playerPos, playerHalf };
-    int completedCount=0;
-    bool collectedSomething=false;
-    for(auto &c : collectibles){
-        if(!c.collected && aabbIntersects(pb, c.box)){
-            c.collected = true;
-            collectedPerPlatform[c.platformIndex]++;
-            collectedSomething = true;
+        gfx->pushMatrix();
+        gfx->loadIdentity(); // vertices are already in eye space
+
+        gfx->setBlend(BLEND_ADDITIVE);
+        GlowSpriteVertex* quads = frameArena.allocArray<GlowSpriteVertex>(4 * n);
+        for(size_t k=0;k<n;k++) emitSprite(items[k], quads + 4*k);
+        if(!gfx->drawGlowSprites(quads, (int)(4 * n))) drawTriangles(n);
+
+        gfx->setBlend(BLEND_OPAQUE);
+        gfx->popMatrix();
+    }
+
+private:
+    static uint32_t packColor(const float c[3], float a){
+        auto byte = [](float v){ return (uint32_t)(std::min(1.0f, std::max(0.0f, v)) * 255.0f + 0.5f); };
+        return byte(c[0]) | (byte(c[1])<<8) | (byte(c[2])<<16) | (byte(a)<<24);
+    }
+
+    static ColorVertex eyeVertex(const float* m, float x, float y, float z, uint32_t rgba){
+        return { m[0]*x + m[4]*y + m[8]*z + m[12],
+                 m[1]*x + m[5]*y + m[9]*z + m[13],
+                 m[2]*x + m[6]*y + m[10]*z + m[14], rgba };
+    }
+
+    static RenderPrim primOf(const RenderItem& it){ return (RenderPrim)((it.key >> 48) & 0x7FFF); }
+
+    // The first n items as triangle batches, one per run of equal primitive
+    void drawTriangles(size_t n){
+        for(size_t i=0; i<n; ){
+            uint64_t bucket = items[i].key >> DEPTH_BITS;
+            size_t j = i;
+            while(j<n && (items[j].key >> DEPTH_BITS)==bucket) j++;
+
+            RenderPrim prim = primOf(items[i]);
+            size_t per = prim==PRIM_HALO_RING ? HALO_SEGMENTS/segmentStep*6 : ORB_SEGMENTS/segmentStep*9;
+            ColorVertex* verts = frameArena.allocArray<ColorVertex>(per * (j - i));
+            ColorVertex* out = verts;
+            for(size_t k=i;k<j;k++) out = prim==PRIM_HALO_RING ? emitHalo(items[k], out) : emitOrb(items[k], out);
+
+            gfx->drawArrays(DRAW_TRIANGLES, (int)(out - verts), &verts[0].x, sizeof(ColorVertex), &verts[0].rgba, sizeof(ColorVertex));
+            i = j;
         }
     }
-    // Check platform completions, auto-start animations
-    for(int i=0;i<4;i++){
-        if(!features[i].allCollected && collectedPerPlatform[i] >= totalCollectiblesPerPlatform){
-            features[i].allCollected = true; // Animation unlocked
-            features[i].animEnabled = true;  // Auto-start animation!
+
+    // Four eye-space corners: orbs as a camera-facing square (sized by the modelview's
+    // scale), rings as a square in their own XZ plane
+    static void emitSprite(const RenderItem& it, GlowSpriteVertex* out){
+        RenderPrim prim = primOf(it);
+        int cell = glowCell((GlowShape)prim, it.r0, it.r1);
+        float u0 = (float)cell / GLOW_CELLS, u1 = (float)(cell + 1) / GLOW_CELLS;
+        uint32_t rgba = packColor(it.col, it.alpha);
+        const Vec3& c = it.center;
+        ColorVertex e[4];
+        if(prim == PRIM_GLOW_ORB){
+            const float* m = it.mv;
+            float r = it.r0 * std::sqrt(m[0]*m[0] + m[1]*m[1] + m[2]*m[2]);
+            ColorVertex mid = eyeVertex(m, c.x, c.y, c.z, rgba);
+            e[0] = {mid.x - r, mid.y - r, mid.z, rgba}; e[1] = {mid.x + r, mid.y - r, mid.z, rgba};
+            e[2] = {mid.x + r, mid.y + r, mid.z, rgba}; e[3] = {mid.x - r, mid.y + r, mid.z, rgba};
+        } else {
+            float r = it.r1;
+            e[0] = eyeVertex(it.mv, c.x - r, c.y, c.z - r, rgba); e[1] = eyeVertex(it.mv, c.x + r, c.y, c.z - r, rgba);
+            e[2] = eyeVertex(it.mv, c.x + r, c.y, c.z + r, rgba); e[3] = eyeVertex(it.mv, c.x - r, c.y, c.z + r, rgba);
         }
-        if(collectedPerPlatform[i] >= totalCollectiblesPerPlatform) completedCount++;
+        static const float v[4] = { 0, 0, 1, 1 };
+        for(int k=0;k<4;k++) out[k] = { e[k].x, e[k].y, e[k].z, (k==1 || k==2) ? u1 : u0, v[k], rgba };
     }
-    if(collectedSomething) playAudio(audioCollect);
-    if(completedCount==4){
-        if(gameState == PLAYING){
-            gameState = WON;
-            playOnce(audioWin);
+
+    // Same vertex order as the old GL_TRIANGLE_STRIP, so flat shading picks the same colours
+    ColorVertex* emitHalo(const RenderItem& it, ColorVertex* out) const {
+        uint32_t lit = packColor(it.col, it.alpha), clear = packColor(it.col, 0.0f);
+        const Vec3& c = it.center;
+        for(int i=0;i<HALO_SEGMENTS;i+=segmentStep){
+            int n = i + segmentStep;
+            ColorVertex o0 = eyeVertex(it.mv, c.x + haloCos[i]*it.r1, c.y, c.z + haloSin[i]*it.r1, lit);
+            ColorVertex i0 = eyeVertex(it.mv, c.x + haloCos[i]*it.r0, c.y, c.z + haloSin[i]*it.r0, clear);
+            ColorVertex o1 = eyeVertex(it.mv, c.x + haloCos[n]*it.r1, c.y, c.z + haloSin[n]*it.r1, lit);
+            ColorVertex i1 = eyeVertex(it.mv, c.x + haloCos[n]*it.r0, c.y, c.z + haloSin[n]*it.r0, clear);
+            *out++ = o0; *out++ = i0; *out++ = o1;
+            *out++ = i0; *out++ = o1; *out++ = i1;
         }
+        return out;
     }
-}
 
-static void updateFeatures(float dt){
-    for(int i=0;i<4;i++){
-        if(features[i].animEnabled) features[i].t += dt;
+    // Three crossed discs, each a fan from a lit centre to a transparent rim
+    ColorVertex* emitOrb(const RenderItem& it, ColorVertex* out) const {
+        static const Vec3 axes[3][2] = { {{1,0,0},{0,1,0}}, {{0,1,0},{0,0,1}}, {{1,0,0},{0,0,1}} };
+        uint32_t lit = packColor(it.col, it.alpha), clear = packColor(it.col, 0.0f);
+        const Vec3& c = it.center;
+        ColorVertex centre = eyeVertex(it.mv, c.x, c.y, c.z, lit);
+        for(int p=0;p<3;p++){
+            const Vec3& u = axes[p][0]; const Vec3& v = axes[p][1];
+            auto rim = [&](int i){
+                Vec3 o = add(mul(u, it.r0*orbCos[i]), mul(v, it.r0*orbSin[i]));
+                return eyeVertex(it.mv, c.x + o.x, c.y + o.y, c.z + o.z, clear);
+            };
+            ColorVertex prev = rim(0);
+            for(int i=segmentStep;i<=ORB_SEGMENTS;i+=segmentStep){
+                ColorVertex next = rim(i);
+                *out++ = centre; *out++ = prev; *out++ = next;
+                prev = next;
+            }
+        }
+        return out;
     }
+
+    ArenaVector<RenderItem> items;
+    bool open = false;
+    float haloCos[HALO_SEGMENTS+1], haloSin[HALO_SEGMENTS+1];
+    float orbCos[ORB_SEGMENTS+1], orbSin[ORB_SEGMENTS+1];
+};
+
+static RenderQueue renderQueue;
+
+// --------------------------- Core profile renderer ---------------------------
+// RenderBackend for an OpenGL 3.3 core context (--gl33). Geometry that does not change
+// lives in static VBOs and per-frame variation is shader input:
+// - each compile-time mesh is one VBO of positions and colour tints, drawn instanced with
+//   a per-instance modelview and palette, so spins, bobs, scale pulses and colour shifts
+//   only change instance attributes and the tint is applied in the vertex shader
+// - halo rings and glow orbs are one unit quad instanced with centre, radii, colour and
+//   alpha and textured with the glow falloff atlas, so glow pulses are attributes too
+// - retained blocks (the courtyard, each streamed chunk) are recorded into a VBO the first
+//   time they are drawn and replayed with a matrix uniform
+// What is left, a few small immediate-mode pieces and the particles, is appended to
+// stream buffers in eye space. flush() uploads the frame's instance and stream buffers
+// and draws everything: opaque first, then additive. Colours are flat with the last
+// vertex of each primitive as the provoking vertex, matching glShadeModel(GL_FLAT).
+#if USE_GL33
+static const char* const CORE_FLAT_FS = R"(#version 330 core
+flat in vec4 color;
+out vec4 fragColor;
+void main(){ fragColor = color; }
+)";
+
+static const char* const CORE_COLOR_VS = R"(#version 330 core
+layout(location=0) in vec3 position;
+layout(location=1) in vec4 rgba;
+uniform mat4 mvp;
+uniform float pointSize;
+flat out vec4 color;
+void main(){
+    color = rgba;
+    gl_PointSize = pointSize;
+    gl_Position = mvp * vec4(position, 1.0);
+}
+)";
+
+static const char* const CORE_MESH_VS = R"(#version 330 core
+layout(location=0) in vec3 position;
+layout(location=1) in vec4 tintMul;   // palette slot (-1: none), multiplier
+layout(location=2) in vec3 tintAdd;
+layout(location=3) in mat4 modelview; // per instance, locations 3-6
+layout(location=7) in vec3 palette0;  // per instance
+layout(location=8) in vec3 palette1;
+layout(location=9) in vec3 palette2;
+uniform mat4 projection;
+flat out vec4 color;
+void main(){
+    int slot = int(tintMul.x);
+    vec3 base = slot == 0 ? palette0 : slot == 1 ? palette1 : slot == 2 ? palette2 : vec3(0.0);
+    color = vec4(clamp(base * tintMul.yzw + tintAdd, 0.0, 1.0), 1.0);
+    gl_Position = projection * modelview * vec4(position, 1.0);
 }
+)";
+
+static const char* const CORE_GLOW_VS = R"(#version 330 core
+layout(location=0) in vec2 corner;     // unit quad, -1..1
+layout(location=3) in mat4 modelview;  // per instance, locations 3-6
+layout(location=7) in vec4 centreInner;
+layout(location=8) in vec4 colorAlpha;
+layout(location=9) in vec2 outerCell;  // outer radius (rings), falloff atlas cell
+uniform mat4 projection;
+uniform float atlasCells;
+out vec2 texCoord;
+flat out vec4 tint;
+void main(){
+    tint = clamp(colorAlpha, 0.0, 1.0);
+    texCoord = vec2((outerCell.y + corner.x * 0.5 + 0.5) / atlasCells, corner.y * 0.5 + 0.5);
+    vec4 eye;
+    if(outerCell.y == 0.0) // orb: faces the camera
+        eye = modelview * vec4(centreInner.xyz, 1.0) + vec4(corner * centreInner.w * length(modelview[0].xyz), 0.0, 0.0);
+    else
+        eye = modelview * vec4(centreInner.xyz + vec3(corner.x, 0.0, corner.y) * outerCell.x, 1.0);
+    gl_Position = projection * eye;
+}
+)";
+
+static const char* const CORE_TEXT_VS = R"(#version 330 core
+layout(location=0) in vec2 position;
+layout(location=1) in vec2 uv;
+layout(location=2) in vec4 rgba;
+uniform vec2 viewport;
+out vec2 texCoord;
+flat out vec4 tint;
+void main(){
+    texCoord = uv;
+    tint = rgba;
+    gl_Position = vec4(position / viewport * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static const char* const CORE_ATLAS_FS = R"(#version 330 core
+in vec2 texCoord;
+flat in vec4 tint;
+uniform sampler2D atlas;
+out vec4 fragColor;
+void main(){ fragColor = vec4(tint.rgb, tint.a * texture(atlas, texCoord).r); }
+)";
+
+class CoreProfileBackend : public RenderBackend {
+public:
+    static const int RETAIN_KEEP_FLUSHES = 600; // retained blocks unused this long are freed
+
+    // Compiles the programs and builds the glow quad and atlas; needs a current 3.3 core context
+    bool init(){
+        colorProgram = linkProgram(CORE_COLOR_VS, CORE_FLAT_FS);
+        meshProgram = linkProgram(CORE_MESH_VS, CORE_FLAT_FS);
+        glowProgram = linkProgram(CORE_GLOW_VS, CORE_ATLAS_FS);
+        textProgram = linkProgram(CORE_TEXT_VS, CORE_ATLAS_FS);
+        if(!colorProgram || !meshProgram || !glowProgram || !textProgram) return false;
+        colorMvp = glGetUniformLocation(colorProgram, "mvp");
+        colorPointSize = glGetUniformLocation(colorProgram, "pointSize");
+        meshProjection = glGetUniformLocation(meshProgram, "projection");
+        glowProjection = glGetUniformLocation(glowProgram, "projection");
+        glUseProgram(glowProgram);
+        glUniform1f(glGetUniformLocation(glowProgram, "atlasCells"), (float)GLOW_CELLS);
+        glUseProgram(0);
+        textViewport = glGetUniformLocation(textProgram, "viewport");
+
+        glGenBuffers(1, &instanceVbo);
+        glGenBuffers(1, &glowInstanceVbo);
+        glGenVertexArrays(1, &streamVao);
+        glGenBuffers(1, &streamVbo);
+        glBindVertexArray(streamVao);
+        glBindBuffer(GL_ARRAY_BUFFER, streamVbo);
+        colorVertexLayout();
+        buildGlow();
+        glGenVertexArrays(1, &textVao);
+        glGenBuffers(1, &textVbo);
+        glGenBuffers(1, &textEbo);
+        glBindVertexArray(0);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        return true;
+    }
 
-static void updateSkyOracles(float dt){
-    for(auto& o : skyOracles){
-        o.rotation = fmodf(o.rotation + 30.0f * dt, 360.0f);
+    // RenderBackend
+    void perspective(double fovyDeg, double aspect, double zNear, double zFar) override { mats.perspective(fovyDeg, aspect, zNear, zFar); }
+    void lookAt(const Vec3& eye, const Vec3& target, const Vec3& up) override { mats.lookAt(eye, target, up); }
+
+    void pushMatrix() override { mats.push(); }
+    void popMatrix() override { mats.pop(); }
+    void loadIdentity() override { mats.loadIdentity(); }
+    void translate(float x, float y, float z) override { mats.translate(x, y, z); }
+    void rotate(float deg, float x, float y, float z) override { mats.rotate(deg, x, y, z); }
+    void scale(float x, float y, float z) override { mats.scale(x, y, z); }
+    void modelview(float out[16]) override { std::memcpy(out, eyeModelview().m, 16*sizeof(float)); }
+    void projection(float out[16]) override { std::memcpy(out, mats.projection().m, 16*sizeof(float)); }
+
+    void color(float r, float g, float b) override { current = packColor(r, g, b) | 0xFF000000u; }
+    void begin(DrawMode m) override { immMode = m; immediate.clear(); }
+    void vertex(float x, float y, float z) override { immediate.push_back({x, y, z, current}); }
+    void end() override {
+        if(immediate.empty()) return;
+        const ColorVertex* v = immediate.data();
+        append(immMode, (int)immediate.size(), &v->x, sizeof(ColorVertex), &v->rgba, sizeof(ColorVertex));
+    }
+    void drawArrays(DrawMode m, int count, const float* xyz, size_t xyzStride, const uint32_t* rgba, size_t rgbaStride) override {
+        append(m, count, xyz, xyzStride, rgba, rgbaStride);
     }
-}
 
-// --------------------------- Game Over Scene ---------------------------
-static void initFlyingOracles(){
-    for(int i=0; i<4; i++){
-        flyingOracles[i].pos = features[i].box.center;
-        float vx = (rand()%200 - 100) / 20.0f;
-        float vy = (rand()%100 + 50) / 20.0f;
-        float vz = (rand()%200 - 100) / 20.0f;
-        flyingOracles[i].vel = {vx, vy, vz};
-        flyingOracles[i].rotation = 0.0f;
-        flyingOracles[i].color[0] = features[i].baseColor[0];
+    void setBlend(BlendMode mode) override { blend = mode; }
+    void pointSize(float px) override { pointPx = px; }
+
+    void drawMesh(const MeshGeometry& mesh, const MeshPalette& pal) override {
+        if(recording){ RenderBackend::drawMesh(mesh, pal); return; } // baked into the block with CPU tints
+        MeshSlot& slot = meshSlot(mesh);
+        size_t at = slot.instances.size();
+        slot.instances.resize(at + INSTANCE_FLOATS);
+        std::memcpy(&slot.instances[at], mats.modelview().m, 16*sizeof(float));
+        std::memcpy(&slot.instances[at + 16], pal.col, 9*sizeof(float));
+    }
+
+    bool glow(GlowShape shape, const Vec3& center, float r0, float r1, const float col[3], float alpha) override {
+        size_t at = glows.size();
+        glows.resize(at + INSTANCE_FLOATS);
+        float* p = &glows[at];
+        std::memcpy(p, eyeModelview().m, 16*sizeof(float));
+        p[16] = center.x; p[17] = center.y; p[18] = center.z; p[19] = r0;
+        p[20] = col[0]; p[21] = col[1]; p[22] = col[2]; p[23] = alpha;
+        p[24] = r1; p[25] = (float)glowCell(shape, r0, r1);
+        return true;
+    }
+
+    bool beginRetained(uint64_t id) override {
+        if(recording){ nestedRetains++; return true; } // part of the enclosing block
+        RetainedDraw d;
+        d.mvp = mats.modelviewProjection();
+        for(size_t i=0;i<blocks.size();i++){
+            if(blocks[i].id != id) continue;
+            blocks[i].lastUsed = flushes;
+            d.block = (int)i;
+            retainedDraws.push_back(d);
+            return false;
+        }
+        recording = true;
+        recordId = id;
+        recordBase = mats.modelview();
+        mats.loadIdentity();
+        recordTris.clear(); recordLines.clear();
+        return true;
+    }
+
+    void endRetained() override {
+        if(nestedRetains > 0){ nestedRetains--; return; }
+        if(!recording) return;
+        recording = false;
+        mats.load(recordBase);
+
+        RetainedBlock b;
+        b.id = recordId;
+        b.lastUsed = flushes;
+        b.triVerts = (int)recordTris.size();
+        b.lineVerts = (int)recordLines.size();
+        glGenVertexArrays(1, &b.vao);
+        glGenBuffers(1, &b.vbo);
+        glBindVertexArray(b.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, b.vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((b.triVerts + b.lineVerts) * sizeof(ColorVertex)), nullptr, GL_STATIC_DRAW);
+        if(b.triVerts) glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(b.triVerts * sizeof(ColorVertex)), recordTris.data());
+        if(b.lineVerts) glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(b.triVerts * sizeof(ColorVertex)), (GLsizeiptr)(b.lineVerts * sizeof(ColorVertex)), recordLines.data());
+        colorVertexLayout();
+        glBindVertexArray(0);
+
+        RetainedDraw d;
+        d.mvp = mats.modelviewProjection();
+        d.block = (int)blocks.size();
+        blocks.push_back(b);
+        retainedDraws.push_back(d);
+    }
+
+    bool drawTextQuads(const void* verts, size_t stride, int count, unsigned atlas, int w, int h) override {
+        int quads = count / 4;
+        if(quads <= 0) return true;
+        glBindVertexArray(textVao);
+        if(quads > textQuadCapacity){
+            std::vector<uint32_t> idx((size_t)quads * 6);
+            for(int q=0;q<quads;q++){
+                uint32_t b = (uint32_t)q * 4;
+                uint32_t tri[6] = { b, b+1, b+2, b, b+2, b+3 };
+                std::memcpy(&idx[(size_t)q*6], tri, sizeof(tri));
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, textEbo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(idx.size() * sizeof(uint32_t)), idx.data(), GL_STATIC_DRAW);
+            textQuadCapacity = quads;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, textVbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(count * stride), verts, GL_STREAM_DRAW);
+        glEnableVertexAttribArray(0); glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, (GLsizei)stride, (const void*)0);
+        glEnableVertexAttribArray(1); glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, (GLsizei)stride, (const void*)(2*sizeof(float)));
+        glEnableVertexAttribArray(2); glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, (GLsizei)stride, (const void*)(4*sizeof(float)));
+
+        glUseProgram(textProgram);
+        glUniform2f(textViewport, (float)w, (float)h);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        drawCallCount++;
+        glDrawElements(GL_TRIANGLES, quads * 6, GL_UNSIGNED_INT, (const void*)0);
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindVertexArray(0);
+        glUseProgram(0);
+        return true;
+    }
+
+    void flush() override {
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+
+        glUseProgram(colorProgram);
+        glUniform1f(colorPointSize, 1.0f);
+        for(const RetainedDraw& d : retainedDraws){
+            const RetainedBlock& b = blocks[d.block];
+            glUniformMatrix4fv(colorMvp, 1, GL_FALSE, d.mvp.m);
+            glBindVertexArray(b.vao);
+            if(b.triVerts){ drawCallCount++; glDrawArrays(GL_TRIANGLES, 0, b.triVerts); }
+            if(b.lineVerts){ drawCallCount++; glDrawArrays(GL_LINES, b.triVerts, b.lineVerts); }
+        }
+
+        // Every mesh instance of the flush in one buffer
+        size_t instanceFloats = 0;
+        for(const MeshSlot& m : meshes) instanceFloats += m.instances.size();
+        if(instanceFloats){
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(instanceFloats * sizeof(float)), nullptr, GL_STREAM_DRAW);
+            size_t offset = 0;
+            for(const MeshSlot& m : meshes){
+                if(m.instances.empty()) continue;
+                glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(offset * sizeof(float)), (GLsizeiptr)(m.instances.size() * sizeof(float)), m.instances.data());
+                offset += m.instances.size();
+            }
+            glUseProgram(meshProgram);
+            glUniformMatrix4fv(meshProjection, 1, GL_FALSE, mats.projection().m);
+            offset = 0;
+            for(const MeshSlot& m : meshes){
+                if(m.instances.empty()) continue;
+                glBindVertexArray(m.vao);
+                instanceLayout(instanceVbo, offset, false);
+                drawCallCount++;
+                glDrawArraysInstanced(GL_TRIANGLES, 0, m.count, (GLsizei)(m.instances.size() / INSTANCE_FLOATS));
+                offset += m.instances.size();
+            }
+        }
+
+        glUseProgram(colorProgram);
+        glUniformMatrix4fv(colorMvp, 1, GL_FALSE, mats.projection().m); // stream vertices are in eye space
+        drawStream(BLEND_OPAQUE);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        glDepthMask(GL_FALSE);
+        if(!glows.empty()){
+            glBindBuffer(GL_ARRAY_BUFFER, glowInstanceVbo);
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(glows.size() * sizeof(float)), glows.data(), GL_STREAM_DRAW);
+            glUseProgram(glowProgram);
+            glUniformMatrix4fv(glowProjection, 1, GL_FALSE, mats.projection().m);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, glowAtlas);
+            glBindVertexArray(glowVao);
+            instanceLayout(glowInstanceVbo, 0, true);
+            drawCallCount++;
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)(glows.size() / INSTANCE_FLOATS));
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glUseProgram(colorProgram);
+        }
+        drawStream(BLEND_ADDITIVE);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+        glBindVertexArray(0);
+        glUseProgram(0);
+
+        retainedDraws.clear();
+        for(MeshSlot& m : meshes) m.instances.clear();
+        glows.clear();
+        flushes++;
+        for(size_t i=blocks.size(); i-- > 0; ){
+            if(flushes - blocks[i].lastUsed < RETAIN_KEEP_FLUSHES) continue;
+            glDeleteBuffers(1, &blocks[i].vbo);
+            glDeleteVertexArrays(1, &blocks[i].vao);
+            blocks[i] = blocks.back();
+            blocks.pop_back();
+        }
+    }
+
+    size_t retainedBlocks() const { return blocks.size(); }
+
+private:
+    // Per instance: modelview (16), then palette (9, one float unused) for meshes or
+    // centre+inner radius (4), colour+alpha (4), outer radius and atlas cell (2) for glows
+    static const int INSTANCE_FLOATS = 26;
+
+    struct MeshSlot {
+        const MeshGeometry* geometry;
+        GLuint vao, vbo;
+        int count;
+        std::vector<float> instances;
+    };
+    struct RetainedBlock {
+        uint64_t id, lastUsed;
+        GLuint vao, vbo;
+        int triVerts, lineVerts;
+    };
+    struct RetainedDraw {
+        int block;
+        Mat4 mvp;
+    };
+    struct PointBatch { int first, count; float size; };
+    struct Stream {
+        std::vector<ColorVertex> tris, lines, points;
+        std::vector<PointBatch> pointBatches;
+    };
+
+    static uint32_t packColor(float r, float g, float b){
+        auto byte = [](float v){ return (uint32_t)(std::min(1.0f, std::max(0.0f, v)) * 255.0f + 0.5f); };
+        return byte(r) | (byte(g)<<8) | (byte(b)<<16);
+    }
+
+    static GLuint compileShader(GLenum type, const char* src){
+        GLuint sh = glCreateShader(type);
+        glShaderSource(sh, 1, &src, nullptr);
+        glCompileShader(sh);
+        GLint ok = 0;
+        glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+        if(!ok){
+            char log[1024];
+            glGetShaderInfoLog(sh, sizeof(log), nullptr, log);
+            std::fprintf(stderr, "[gl33] shader compile failed: %s\n", log);
+            glDeleteShader(sh);
+            return 0;
+        }
+        return sh;
+    }
+
+    static GLuint linkProgram(const char* vs, const char* fs){
+        GLuint v = compileShader(GL_VERTEX_SHADER, vs), f = compileShader(GL_FRAGMENT_SHADER, fs);
+        if(!v || !f) return 0;
+        GLuint prog = glCreateProgram();
+        glAttachShader(prog, v);
+        glAttachShader(prog, f);
+        glLinkProgram(prog);
+        glDeleteShader(v);
+        glDeleteShader(f);
+        GLint ok = 0;
+        glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+        if(!ok){
+            char log[1024];
+            glGetProgramInfoLog(prog, sizeof(log), nullptr, log);
+            std::fprintf(stderr, "[gl33] program link failed: %s\n", log);
+            glDeleteProgram(prog);
+            return 0;
+        }
+        return prog;
+    }
+
+    // ColorVertex attributes from the bound GL_ARRAY_BUFFER into the bound VAO
+    static void colorVertexLayout(){
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ColorVertex), (const void*)offsetof(ColorVertex, x));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ColorVertex), (const void*)offsetof(ColorVertex, rgba));
+    }
+
+    // Per-instance attributes of the instances starting offset floats into vbo: modelview at
+    // locations 3-6, then three vec3 palette colours (meshes) or two vec4s and a vec2 (glows)
+    static void instanceLayout(GLuint vbo, size_t offset, bool glowInstance){
+        static const int sizes[2][3] = { {3, 3, 3}, {4, 4, 2} };
+        const GLsizei stride = INSTANCE_FLOATS * sizeof(float);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        for(int c=0;c<4;c++){
+            glEnableVertexAttribArray(3 + c);
+            glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, stride, (const void*)((offset + c*4) * sizeof(float)));
+            glVertexAttribDivisor(3 + c, 1);
+        }
+        size_t at = offset + 16;
+        for(int k=0;k<3;k++){
+            int size = sizes[glowInstance ? 1 : 0][k];
+            glEnableVertexAttribArray(7 + k);
+            glVertexAttribPointer(7 + k, size, GL_FLOAT, GL_FALSE, stride, (const void*)(at * sizeof(float)));
+            glVertexAttribDivisor(7 + k, 1);
+            at += size;
+        }
+    }
+
+    // Modelview to eye space; inside a retained block the stack holds the block-local part
+    Mat4 eyeModelview() const { return recording ? mat4Mul(recordBase, mats.modelview()) : mats.modelview(); }
+
+    // Triangles and lines go into the retained block being recorded (block space) or the
+    // stream of the current blend mode (eye space), split into separate primitives coloured
+    // by their provoking vertex
+    void append(DrawMode mode, int count, const float* xyz, size_t xyzStride, const uint32_t* rgba, size_t rgbaStride){
+        bool record = recording && mode != DRAW_POINTS;
+        Mat4 m = record ? mats.modelview() : eyeModelview();
+        auto vert = [&](int i, uint32_t c){
+            const float* p = (const float*)((const char*)xyz + (size_t)i * xyzStride);
+            Vec4 e = mat4Transform(m, {p[0], p[1], p[2]});
+            return ColorVertex{ e.x, e.y, e.z, c };
+        };
+        auto col = [&](int i){ return *(const uint32_t*)((const char*)rgba + (size_t)i * rgbaStride); };
+        Stream& s = stream[blend];
+        std::vector<ColorVertex>& tris = record ? recordTris : s.tris;
+        std::vector<ColorVertex>& lines = record ? recordLines : s.lines;
+        switch(mode){
+        case DRAW_TRIANGLES:
+            for(int i=0;i+2<count;i+=3){
+                uint32_t c = col(i+2);
+                tris.push_back(vert(i, c)); tris.push_back(vert(i+1, c)); tris.push_back(vert(i+2, c));
+            }
+            break;
+        case DRAW_QUADS:
+            for(int i=0;i+3<count;i+=4){
+                uint32_t c = col(i+3);
+                ColorVertex a = vert(i, c), b = vert(i+1, c), d = vert(i+2, c), e = vert(i+3, c);
+                tris.push_back(a); tris.push_back(b); tris.push_back(d);
+                tris.push_back(a); tris.push_back(d); tris.push_back(e);
+            }
+            break;
+        case DRAW_LINES:
+            for(int i=0;i+1<count;i+=2){
+                uint32_t c = col(i+1);
+                lines.push_back(vert(i, c)); lines.push_back(vert(i+1, c));
+            }
+            break;
+        case DRAW_LINE_LOOP:
+            for(int i=0;i<count && count>1;i++){
+                int j = (i+1) % count;
+                uint32_t c = col(j);
+                lines.push_back(vert(i, c)); lines.push_back(vert(j, c));
+            }
+            break;
+        case DRAW_POINTS: {
+            int first = (int)s.points.size();
+            for(int i=0;i<count;i++) s.points.push_back(vert(i, col(i)));
+            if(!s.pointBatches.empty() && s.pointBatches.back().size == pointPx) s.pointBatches.back().count += count;
+            else s.pointBatches.push_back({first, count, pointPx});
+            break;
+        }
+        }
+    }
+
+    MeshSlot& meshSlot(const MeshGeometry& mesh){
+        for(MeshSlot& m : meshes) if(m.geometry == &mesh) return m;
+        // Per vertex: position, palette slot, tint multiplier, tint offset
+        std::vector<float> data((size_t)mesh.count * 10);
+        for(int i=0;i<mesh.count;i++){
+            const MeshVertex& v = mesh.verts[i];
+            const MeshTint& t = *(const MeshTint*)((const char*)mesh.tints + (size_t)v.prim * mesh.tintStride);
+            float row[10] = { v.x, v.y, v.z, (float)t.slot, t.mul.x, t.mul.y, t.mul.z, t.add.x, t.add.y, t.add.z };
+            std::memcpy(&data[(size_t)i*10], row, sizeof(row));
+        }
+        MeshSlot m;
+        m.geometry = &mesh;
+        m.count = mesh.count;
+        glGenVertexArrays(1, &m.vao);
+        glGenBuffers(1, &m.vbo);
+        glBindVertexArray(m.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, m.vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(data.size() * sizeof(float)), data.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0); glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 10*sizeof(float), (const void*)0);
+        glEnableVertexAttribArray(1); glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 10*sizeof(float), (const void*)(3*sizeof(float)));
+        glEnableVertexAttribArray(2); glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 10*sizeof(float), (const void*)(7*sizeof(float)));
+        glBindVertexArray(0);
+        meshes.push_back(m);
+        return meshes.back();
+    }
+
+    // The unit quad every glow instance is drawn from, and the falloff atlas as a red texture
+    void buildGlow(){
+        static const float quad[12] = { -1,-1, 1,-1, 1,1,  -1,-1, 1,1, -1,1 };
+        glGenVertexArrays(1, &glowVao);
+        glGenBuffers(1, &glowVbo);
+        glBindVertexArray(glowVao);
+        glBindBuffer(GL_ARRAY_BUFFER, glowVbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (const void*)0);
+        glBindVertexArray(0);
+
+        std::vector<unsigned char> alpha = glowAtlasPixels();
+        glGenTextures(1, &glowAtlas);
+        glBindTexture(GL_TEXTURE_2D, glowAtlas);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, GLOW_CELLS*GLOW_CELL, GLOW_CELL, 0, GL_RED, GL_UNSIGNED_BYTE, alpha.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Uploads one blend mode's stream (triangles, lines, points back to back) and draws it
+    // with the colour program, whose mvp is the projection
+    void drawStream(BlendMode mode){
+        Stream& s = stream[mode];
+        size_t nt = s.tris.size(), nl = s.lines.size(), np = s.points.size();
+        if(nt + nl + np){
+            glBindVertexArray(streamVao);
+            glBindBuffer(GL_ARRAY_BUFFER, streamVbo);
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)((nt + nl + np) * sizeof(ColorVertex)), nullptr, GL_STREAM_DRAW);
+            if(nt) glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(nt * sizeof(ColorVertex)), s.tris.data());
+            if(nl) glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(nt * sizeof(ColorVertex)), (GLsizeiptr)(nl * sizeof(ColorVertex)), s.lines.data());
+            if(np) glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)((nt + nl) * sizeof(ColorVertex)), (GLsizeiptr)(np * sizeof(ColorVertex)), s.points.data());
+            if(nt){ drawCallCount++; glDrawArrays(GL_TRIANGLES, 0, (GLsizei)nt); }
+            if(nl){ drawCallCount++; glDrawArrays(GL_LINES, (GLint)nt, (GLsizei)nl); }
+            for(const PointBatch& b : s.pointBatches){
+                glUniform1f(colorPointSize, b.size);
+                drawCallCount++;
+                glDrawArrays(GL_POINTS, (GLint)(nt + nl) + b.first, b.count);
+            }
+            glUniform1f(colorPointSize, 1.0f);
+        }
+        s.tris.clear(); s.lines.clear(); s.points.clear(); s.pointBatches.clear();
+    }
+
+    MatrixStack mats;
+    uint32_t current = 0xFFFFFFFFu;
+    BlendMode blend = BLEND_OPAQUE;
+    float pointPx = 1.0f;
+    DrawMode immMode = DRAW_TRIANGLES;
+    std::vector<ColorVertex> immediate;
+    Stream stream[2];
+
+    GLuint colorProgram = 0, meshProgram = 0, glowProgram = 0, textProgram = 0;
+    GLint colorMvp = -1, colorPointSize = -1, meshProjection = -1, glowProjection = -1, textViewport = -1;
+    GLuint streamVao = 0, streamVbo = 0, instanceVbo = 0, glowInstanceVbo = 0;
+    GLuint glowVao = 0, glowVbo = 0, glowAtlas = 0;
+    GLuint textVao = 0, textVbo = 0, textEbo = 0;
+    int textQuadCapacity = 0;
+
+    std::vector<MeshSlot> meshes;
+    std::vector<float> glows;
+
+    std::vector<RetainedBlock> blocks;
+    std::vector<RetainedDraw> retainedDraws;
+    bool recording = false;
+    int nestedRetains = 0;
+    uint64_t recordId = 0, flushes = 0;
+    Mat4 recordBase;
+    std::vector<ColorVertex> recordTris, recordLines;
+};
+
+static CoreProfileBackend coreBackend;
+#endif
+
+// ------------------------ Drawing primitives ------------------------
+static void setColor3f(float r,float g,float b){ gfx->color(r,g,b); }
+
+static void drawQuad(const Vec3&a,const Vec3&b,const Vec3&c,const Vec3&d){
+    gfx->begin(DRAW_QUADS);
+    gfx->vertex(a.x,a.y,a.z);
+    gfx->vertex(b.x,b.y,b.z);
+    gfx->vertex(c.x,c.y,c.z);
+    gfx->vertex(d.x,d.y,d.z);
+    gfx->end();
+}
+
+static void drawBox(const AABB& box){
+    const float x=box.center.x, y=box.center.y, z=box.center.z;
+    const float hx=box.half.x, hy=box.half.y, hz=box.half.z;
+    // 6 faces
+    // +Y top
+    setColor3f(0.85f,0.85f,0.85f);
+    drawQuad({x-hx,y+hy,z-hz},{x+hx,y+hy,z-hz},{x+hx,y+hy,z+hz},{x-hx,y+hy,z+hz});
+    // -Y bottom
+    setColor3f(0.5f,0.5f,0.5f);
+    drawQuad({x-hx,y-hy,z+hz},{x+hx,y-hy,z+hz},{x+hx,y-hy,z-hz},{x-hx,y-hy,z-hz});
+    // +X
+    setColor3f(0.75f,0.75f,0.8f);
+    drawQuad({x+hx,y-hy,z-hz},{x+hx,y+hy,z-hz},{x+hx,y+hy,z+hz},{x+hx,y-hy,z+hz});
+    // -X
+    setColor3f(0.7f,0.7f,0.75f);
+    drawQuad({x-hx,y-hy,z+hz},{x-hx,y+hy,z+hz},{x-hx,y+hy,z-hz},{x-hx,y-hy,z-hz});
+    // +Z
+    setColor3f(0.8f,0.7f,0.7f);
+    drawQuad({x-hx,y-hy,z+hz},{x-hx,y+hy,z+hz},{x+hx,y+hy,z+hz},{x+hx,y-hy,z+hz});
+    // -Z
+    setColor3f(0.7f,0.8f,0.7f);
+    drawQuad({x+hx,y-hy,z-hz},{x+hx,y+hy,z-hz},{x-hx,y+hy,z-hz},{x-hx,y-hy,z-hz});
+}
+
+// A simple colored box with a single color
+static void drawSolidBox(const AABB&box, float r, float g, float b){
+    gfx->color(r,g,b);
+    const float x=box.center.x, y=box.center.y, z=box.center.z;
+    const float hx=box.half.x, hy=box.half.y, hz=box.half.z;
+    gfx->begin(DRAW_QUADS);
+    // top
+    gfx->vertex(x-hx,y+hy,z-hz); gfx->vertex(x+hx,y+hy,z-hz); gfx->vertex(x+hx,y+hy,z+hz); gfx->vertex(x-hx,y+hy,z+hz);
+    // bottom
+    gfx->vertex(x-hx,y-hy,z+hz); gfx->vertex(x+hx,y-hy,z+hz); gfx->vertex(x+hx,y-hy,z-hz); gfx->vertex(x-hx,y-hy,z-hz);
+    // +X
+    gfx->vertex(x+hx,y-hy,z-hz); gfx->vertex(x+hx,y+hy,z-hz); gfx->vertex(x+hx,y+hy,z+hz); gfx->vertex(x+hx,y-hy,z+hz);
+    // -X
+    gfx->vertex(x-hx,y-hy,z+hz); gfx->vertex(x-hx,y+hy,z+hz); gfx->vertex(x-hx,y+hy,z-hz); gfx->vertex(x-hx,y-hy,z-hz);
+    // +Z
+    gfx->vertex(x-hx,y-hy,z+hz); gfx->vertex(x-hx,y+hy,z+hz); gfx->vertex(x+hx,y+hy,z+hz); gfx->vertex(x+hx,y-hy,z+hz);
+    // -Z
+    gfx->vertex(x+hx,y-hy,z-hz); gfx->vertex(x+hx,y+hy,z-hz); gfx->vertex(x-hx,y+hy,z-hz); gfx->vertex(x-hx,y-hy,z-hz);
+    gfx->end();
+}
+
+// Pyramid (square base) for some East Asian aesthetic (roof-like)
+static void drawPyramid(const Vec3&center, float base, float height, float r, float g, float b){
+    gfx->color(r,g,b);
+    float x=center.x, y=center.y, z=center.z;
+    float h=height; float b2=base*0.5f;
+    // Base quad
+    gfx->begin(DRAW_QUADS);
+    gfx->vertex(x-b2,y,z-b2); gfx->vertex(x+b2,y,z-b2); gfx->vertex(x+b2,y,z+b2); gfx->vertex(x-b2,y,z+b2);
+    gfx->end();
+    // 4 side triangles
+    gfx->begin(DRAW_TRIANGLES);
+    // +Z face
+    gfx->vertex(x-b2,y,z+b2); gfx->vertex(x+b2,y,z+b2); gfx->vertex(x, y+h, z);
+    // -Z face
+    gfx->vertex(x+b2,y,z-b2); gfx->vertex(x-b2,y,z-b2); gfx->vertex(x, y+h, z);
+    // +X face
+    gfx->vertex(x+b2,y,z-b2); gfx->vertex(x+b2,y,z+b2); gfx->vertex(x, y+h, z);
+    // -X face
+    gfx->vertex(x-b2,y,z+b2); gfx->vertex(x-b2,y,z-b2); gfx->vertex(x, y+h, z);
+    gfx->end();
+}
+
+// --------------------------- Compile-time meshes ---------------------------
+// Composite models are described as constexpr tables of boxes, pyramids, diamonds and
+// quads, and MeshData<Model> expands each table into a flat triangle array at compile
+// time through an index sequence, so nothing is built per frame. A prim's colour is one
+// of three palette slots times mul plus add (slot -1 = constant colour). Each instance
+// supplies its own palette and a single translate/yaw/scale transform. The tinted colour
+// array for a palette is cached, so a model draw is one glDrawArrays; the core profile
+// backend instead keeps each mesh in a VBO and tints it in the shader.
+enum MeshPrimKind { MP_BOX=0, MP_PYRAMID, MP_DIAMOND, MP_QUAD };
+
+struct MeshPrim {
+    MeshPrimKind kind;
+    Vec3 a, b, c, d; // box: centre, half; pyramid: base centre, (size, height, -); diamond: centre, (radius, height, -); quad: strip corners
+    int yaw;         // rotation about Y in 60 degree steps, applied after placement
+    MeshTint tint;
+};
+
+struct MeshTransform {
+    Vec3 pos;
+    float yawDeg;
+    Vec3 scale;
+};
+
+static constexpr MeshTint meshTint(int slot, float m, float add = 0.0f){ return { slot, {m,m,m}, {add,add,add} }; }
+static constexpr MeshTint meshTintRGB(int slot, Vec3 mul, Vec3 add){ return { slot, mul, add }; }
+static constexpr MeshTint meshColor(float r, float g, float b){ return { -1, {0,0,0}, {r,g,b} }; }
+
+static constexpr MeshPrim meshBox(Vec3 c, Vec3 h, MeshTint t){ return { MP_BOX, c, h, {0,0,0}, {0,0,0}, 0, t }; }
+static constexpr MeshPrim meshPyramid(Vec3 base, float size, float height, MeshTint t, int yaw = 0){ return { MP_PYRAMID, base, {size, height, 0}, {0,0,0}, {0,0,0}, yaw, t }; }
+static constexpr MeshPrim meshDiamond(Vec3 c, float radius, float height, MeshTint t){ return { MP_DIAMOND, c, {radius, height, 0}, {0,0,0}, {0,0,0}, 0, t }; }
+static constexpr MeshPrim meshQuad(Vec3 a, Vec3 b, Vec3 c, Vec3 d, MeshTint t){ return { MP_QUAD, a, b, c, d, 0, t }; }
+
+// cos/sin at 60 degree steps (diamond rims and prim yaw)
+static constexpr float MESH_COS6[7] = { 1.0f, 0.5f, -0.5f, -1.0f, -0.5f, 0.5f, 1.0f };
+static constexpr float MESH_SIN6[7] = { 0.0f, 0.8660254f, 0.8660254f, 0.0f, -0.8660254f, -0.8660254f, 0.0f };
+
+// Box corners in drawSolidBox face order (top, bottom, +X, -X, +Z, -Z), as sign triplets
+static constexpr signed char MESH_BOX_SIGNS[6*4*3] = {
+    -1, 1,-1,   1, 1,-1,   1, 1, 1,  -1, 1, 1,
+    -1,-1, 1,   1,-1, 1,   1,-1,-1,  -1,-1,-1,
+     1,-1,-1,   1, 1,-1,   1, 1, 1,   1,-1, 1,
+    -1,-1, 1,  -1, 1, 1,  -1, 1,-1,  -1,-1,-1,
+    -1,-1, 1,  -1, 1, 1,   1, 1, 1,   1,-1, 1,
+     1,-1,-1,   1, 1,-1,  -1, 1,-1,  -1,-1,-1,
+};
+// Pyramid triangles in drawPyramid order as (x sign, apex, z sign): base quad split in two, then the four sides
+static constexpr signed char MESH_PYRAMID_VERTS[18*3] = {
+    -1,0,-1,  1,0,-1,  1,0, 1,   -1,0,-1,  1,0, 1, -1,0, 1,
+    -1,0, 1,  1,0, 1,  0,1, 0,    1,0,-1, -1,0,-1,  0,1, 0,
+     1,0,-1,  1,0, 1,  0,1, 0,   -1,0, 1, -1,0,-1,  0,1, 0,
+};
+
+static constexpr int meshPrimVertexCount(MeshPrimKind k){ return k==MP_BOX ? 36 : k==MP_PYRAMID ? 18 : k==MP_DIAMOND ? 36 : 6; }
+static constexpr int meshVertexCount(const MeshPrim* p, int n){ return n==0 ? 0 : meshPrimVertexCount(p->kind) + meshVertexCount(p+1, n-1); }
+
+static constexpr MeshVertex meshPlace(float x, float y, float z, int yaw, int prim){
+    return { x*MESH_COS6[yaw] + z*MESH_SIN6[yaw], y, -x*MESH_SIN6[yaw] + z*MESH_COS6[yaw], prim };
+}
+// Quad (a,b,c,d) is split as (a,b,c) + (a,c,d), the same way GL_QUADS is rasterized
+static constexpr int meshQuadCorner(int tri, int v){ return tri==0 ? v : (v==0 ? 0 : v+1); }
+static constexpr MeshVertex meshBoxVertex(const MeshPrim& p, int corner, int prim){
+    return meshPlace(p.a.x + MESH_BOX_SIGNS[corner*3]*p.b.x, p.a.y + MESH_BOX_SIGNS[corner*3+1]*p.b.y, p.a.z + MESH_BOX_SIGNS[corner*3+2]*p.b.z, p.yaw, prim);
+}
+static constexpr MeshVertex meshPyramidVertex(const MeshPrim& p, int i, int prim){
+    return MESH_PYRAMID_VERTS[i*3+1]
+        ? meshPlace(p.a.x, p.a.y + p.b.y, p.a.z, p.yaw, prim)
+        : meshPlace(p.a.x + MESH_PYRAMID_VERTS[i*3]*p.b.x*0.5f, p.a.y, p.a.z + MESH_PYRAMID_VERTS[i*3+2]*p.b.x*0.5f, p.yaw, prim);
+}
+static constexpr MeshVertex meshDiamondRim(const MeshPrim& p, int k, int prim){
+    return meshPlace(p.a.x + MESH_COS6[k]*p.b.x, p.a.y, p.a.z + MESH_SIN6[k]*p.b.x, p.yaw, prim);
+}
+// Per segment: top (apex, rim i, rim i+1) then bottom (apex, rim i+1, rim i), as in drawDiamond
+static constexpr MeshVertex meshDiamondVertex(const MeshPrim& p, int seg, int r, int prim){
+    return r==0 ? meshPlace(p.a.x, p.a.y + p.b.y*0.5f, p.a.z, p.yaw, prim)
+         : r==3 ? meshPlace(p.a.x, p.a.y - p.b.y*0.5f, p.a.z, p.yaw, prim)
+         : meshDiamondRim(p, (r==1 || r==5) ? seg : seg+1, prim);
+}
+// Strip (a,b,c,d) as triangles (a,b,c) and (c,b,d)
+static constexpr MeshVertex meshQuadVertex(const MeshPrim& p, int i, int prim){
+    return (i==0) ? meshPlace(p.a.x, p.a.y, p.a.z, p.yaw, prim)
+         : (i==1 || i==4) ? meshPlace(p.b.x, p.b.y, p.b.z, p.yaw, prim)
+         : (i==2 || i==3) ? meshPlace(p.c.x, p.c.y, p.c.z, p.yaw, prim)
+         : meshPlace(p.d.x, p.d.y, p.d.z, p.yaw, prim);
+}
+static constexpr MeshVertex meshPrimVertex(const MeshPrim& p, int i, int prim){
+    return p.kind==MP_BOX ? meshBoxVertex(p, (i/6)*4 + meshQuadCorner((i%6)/3, i%3), prim)
+         : p.kind==MP_PYRAMID ? meshPyramidVertex(p, i, prim)
+         : p.kind==MP_DIAMOND ? meshDiamondVertex(p, i/6, i%6, prim)
+         : meshQuadVertex(p, i, prim);
+}
+static constexpr MeshVertex meshVertex(const MeshPrim* p, int i, int prim = 0){
+    return i < meshPrimVertexCount(p->kind) ? meshPrimVertex(*p, i, prim) : meshVertex(p+1, i - meshPrimVertexCount(p->kind), prim+1);
+}
+
+// 0..N-1 as a parameter pack, built by halving so the instantiation depth stays logarithmic
+template<int... I> struct IntSeq {};
+template<class A, class B> struct ConcatIntSeq;
+template<int... A, int... B> struct ConcatIntSeq<IntSeq<A...>, IntSeq<B...>> { typedef IntSeq<A..., (int)sizeof...(A) + B...> type; };
+template<int N> struct MakeIntSeq { typedef typename ConcatIntSeq<typename MakeIntSeq<N/2>::type, typename MakeIntSeq<N - N/2>::type>::type type; };
+template<> struct MakeIntSeq<0> { typedef IntSeq<> type; };
+template<> struct MakeIntSeq<1> { typedef IntSeq<0> type; };
+
+template<class Model, class Seq = typename MakeIntSeq<meshVertexCount(Model::prims, Model::PRIM_COUNT)>::type>
+struct MeshData;
+template<class Model, int... I>
+struct MeshData<Model, IntSeq<I...>> {
+    static constexpr int COUNT = sizeof...(I);
+    static constexpr MeshVertex verts[COUNT] = { meshVertex(Model::prims, I)... };
+};
+template<class Model, int... I>
+constexpr MeshVertex MeshData<Model, IntSeq<I...>>::verts[];
+
+static uint32_t meshTintColor(const MeshTint& t, const MeshPalette& pal){
+    float c[3];
+    for(int k=0;k<3;k++){
+        float mul = k==0 ? t.mul.x : k==1 ? t.mul.y : t.mul.z;
+        float add = k==0 ? t.add.x : k==1 ? t.add.y : t.add.z;
+        c[k] = std::min(1.0f, std::max(0.0f, (t.slot >= 0 ? pal.col[t.slot][k]*mul : 0.0f) + add));
+    }
+    return (uint32_t)(c[0]*255.0f + 0.5f) | ((uint32_t)(c[1]*255.0f + 0.5f) << 8) | ((uint32_t)(c[2]*255.0f + 0.5f) << 16) | 0xFF000000u;
+}
+
+// Tinted colour arrays for the last few palettes a model was drawn with
+template<class Model>
+struct MeshColors {
+    typedef MeshData<Model> Mesh;
+    static const int SLOTS = 4;
+
+    static const uint32_t* lookup(const MeshPalette& pal){
+        for(int i=0;i<used;i++) if(std::memcmp(&palettes[i], &pal, sizeof(MeshPalette))==0) return colors[i];
+        int k = used < SLOTS ? used++ : (next++ % SLOTS);
+        palettes[k] = pal;
+        for(int v=0; v<Mesh::COUNT; v++) colors[k][v] = meshTintColor(Model::prims[Mesh::verts[v].prim].tint, pal);
+        return colors[k];
+    }
+
+    static MeshPalette palettes[SLOTS];
+    static uint32_t colors[SLOTS][Mesh::COUNT];
+    static int used, next;
+};
+template<class Model> MeshPalette MeshColors<Model>::palettes[MeshColors<Model>::SLOTS];
+template<class Model> uint32_t MeshColors<Model>::colors[MeshColors<Model>::SLOTS][MeshData<Model>::COUNT];
+template<class Model> int MeshColors<Model>::used = 0;
+template<class Model> int MeshColors<Model>::next = 0;
+
+template<class Model>
+static const MeshGeometry& meshGeometry(){
+    typedef MeshData<Model> Mesh;
+    static const MeshGeometry geometry = { Mesh::verts, Mesh::COUNT, &Model::prims[0].tint, sizeof(MeshPrim), &MeshColors<Model>::lookup };
+    return geometry;
+}
+
+template<class Model>
+static void drawModel(const MeshTransform& xf, const MeshPalette& pal){
+    gfx->pushMatrix();
+    gfx->translate(xf.pos.x, xf.pos.y, xf.pos.z);
+    if(xf.yawDeg != 0.0f) gfx->rotate(xf.yawDeg, 0, 1, 0);
+    gfx->scale(xf.scale.x, xf.scale.y, xf.scale.z);
+    gfx->drawMesh(meshGeometry<Model>(), pal);
+    gfx->popMatrix();
+}
+
+static MeshPalette meshPalette(const float a[3], const float* b = nullptr, const float* c = nullptr){
+    MeshPalette p;
+    std::memset(&p, 0, sizeof(p));
+    for(int k=0;k<3;k++){ p.col[0][k] = a[k]; p.col[1][k] = b ? b[k] : 0.0f; p.col[2][k] = c ? c[k] : 0.0f; }
+    return p;
+}
+
+// Model tables: unit size, origin at the model's base centre; scale comes from the instance transform
+struct ToriiModel {
+    static constexpr int PRIM_COUNT = 4;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshBox({-1.0f, 2.0f, 0}, {0.3f, 2.0f, 0.3f}, meshTint(0, 1.0f)),   // pillars
+        meshBox({ 1.0f, 2.0f, 0}, {0.3f, 2.0f, 0.3f}, meshTint(0, 1.0f)),
+        meshBox({0, 4.2f, 0}, {1.8f, 0.25f, 0.4f}, meshTint(0, 0.9f)),      // cross beam
+        meshBox({0, 4.7f, 0}, {2.1f, 0.15f, 0.5f}, meshTint(0, 0.8f)),      // top cap
+    };
+};
+constexpr MeshPrim ToriiModel::prims[];
+
+struct PagodaModel {
+    static constexpr int PRIM_COUNT = 4;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshBox({0, 0.5f, 0}, {1.8f, 0.5f, 1.8f}, meshTint(0, 0.6f)),       // base
+        meshPyramid({0, 1.0f, 0}, 4.0f, 0.8f, meshTint(0, 1.0f)),           // roof 1
+        meshBox({0, 1.8f, 0}, {1.2f, 0.4f, 1.2f}, meshTint(0, 0.6f)),       // middle
+        meshPyramid({0, 2.2f, 0}, 3.2f, 0.7f, meshTint(0, 0.95f)),          // roof 2
+    };
+};
+constexpr MeshPrim PagodaModel::prims[];
+
+// Rope and frame pieces keep fixed thicknesses, so the drum is generated per size (in thousandths)
+template<int RADIUS_MILLI, int HEIGHT_MILLI>
+struct TaikoDrumModel {
+    static constexpr float r = RADIUS_MILLI / 1000.0f, h = HEIGHT_MILLI / 1000.0f;
+    static constexpr int PRIM_COUNT = 11;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshBox({0, h*0.7f, 0}, {r, h*0.7f, r}, meshTint(0, 1.0f)),                    // body
+        meshBox({0, h*1.35f, 0}, {r*0.95f, 0.15f, r*0.95f}, meshTint(2, 1.0f)),        // rope rings
+        meshBox({0, h*0.05f, 0}, {r*0.95f, 0.15f, r*0.95f}, meshTint(2, 0.9f)),
+        meshBox({ r*0.95f, h*0.7f, 0}, {0.15f, h*0.6f, r*0.35f}, meshTint(2, 1.0f)),   // rope ties
+        meshBox({-r*0.95f, h*0.7f, 0}, {0.15f, h*0.6f, r*0.35f}, meshTint(2, 1.0f)),
+        meshBox({0, h*0.7f,  r*0.95f}, {r*0.35f, h*0.6f, 0.15f}, meshTint(2, 1.0f)),
+        meshBox({0, h*0.7f, -r*0.95f}, {r*0.35f, h*0.6f, 0.15f}, meshTint(2, 1.0f)),
+        meshBox({-r*1.25f, h*0.4f, 0}, {0.25f, h*0.4f, 0.35f}, meshTint(1, 1.0f)),     // stand
+        meshBox({ r*1.25f, h*0.4f, 0}, {0.25f, h*0.4f, 0.35f}, meshTint(1, 1.0f)),
+        meshBox({0, h*0.35f, 0}, {r*1.45f, 0.12f, r*0.45f}, meshTint(1, 0.9f)),
+        meshBox({0, h*0.15f, 0}, {r*1.45f, 0.12f, r*0.55f}, meshTint(1, 0.75f)),
+    };
+};
+template<int R, int H> constexpr MeshPrim TaikoDrumModel<R, H>::prims[];
+
+struct StoneLanternModel {
+    static constexpr int PRIM_COUNT = 5;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshBox({0, 0.15f, 0}, {0.7f, 0.15f, 0.7f}, meshTint(0, 0.9f)),     // plinth
+        meshBox({0, 0.55f, 0}, {0.22f, 0.4f, 0.22f}, meshTint(0, 1.0f)),    // post
+        meshBox({0, 1.05f, 0}, {0.45f, 0.2f, 0.45f}, meshTint(0, 1.05f)),   // fire box
+        meshPyramid({0, 1.55f, 0}, 1.5f, 0.5f, meshTint(0, 0.85f)),         // roof
+        meshBox({0, 1.85f, 0}, {0.35f, 0.08f, 0.35f}, meshTint(0, 1.1f)),   // finial
+    };
+};
+constexpr MeshPrim StoneLanternModel::prims[];
+
+struct LotusOracleModel {
+    static constexpr int PRIM_COUNT = 7;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshPyramid({0.6f, 0, 0}, 0.8f, 1.0f, meshTint(0, 1.0f), 0),        // petals
+        meshPyramid({0.6f, 0, 0}, 0.8f, 1.0f, meshTint(0, 1.0f), 1),
+        meshPyramid({0.6f, 0, 0}, 0.8f, 1.0f, meshTint(0, 1.0f), 2),
+        meshPyramid({0.6f, 0, 0}, 0.8f, 1.0f, meshTint(0, 1.0f), 3),
+        meshPyramid({0.6f, 0, 0}, 0.8f, 1.0f, meshTint(0, 1.0f), 4),
+        meshPyramid({0.6f, 0, 0}, 0.8f, 1.0f, meshTint(0, 1.0f), 5),
+        meshDiamond({0, 0.6f, 0}, 0.4f, 1.2f, meshTint(0, 1.0f, 0.2f)),     // core
+    };
+};
+constexpr MeshPrim LotusOracleModel::prims[];
+
+struct CrystalColumnModel {
+    static constexpr int PRIM_COUNT = 3;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshDiamond({0, 0.4f, 0}, 0.5f, 1.1f, meshTint(0, 1.0f)),
+        meshDiamond({0, 1.2f, 0}, 0.35f, 0.8f, meshTint(0, 0.8f, 0.2f)),
+        meshDiamond({0, 0.0f, 0}, 0.35f, 0.8f, meshTint(0, 0.8f, 0.2f)),
+    };
+};
+constexpr MeshPrim CrystalColumnModel::prims[];
+
+struct WindBellModel {
+    static constexpr int PRIM_COUNT = 2;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshDiamond({0, 0.6f, 0}, 0.5f, 1.0f, meshTint(0, 1.0f)),
+        meshDiamond({0, 1.2f, 0}, 0.25f, 0.5f, meshTintRGB(0, {0.6f, 0.9f, 0.6f}, {0, 0, 0})),
+    };
+};
+constexpr MeshPrim WindBellModel::prims[];
+
+// The chimes keep a fixed width, so they scale with the bell's height only
+struct WindBellChimesModel {
+    static constexpr int PRIM_COUNT = 2;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshQuad({-0.2f, 0, 0}, {-0.05f, -1.2f, 0}, {0.2f, 0, 0}, {0.05f, -1.2f, 0}, meshTintRGB(0, {0.6f, 0.9f, 0.6f}, {0, 0, 0})),
+        meshQuad({0, 0, -0.2f}, {0, -1.3f, -0.05f}, {0, 0, 0.2f}, {0, -1.3f, 0.05f}, meshTintRGB(0, {0.6f, 0.9f, 0.6f}, {0, 0, 0})),
+    };
+};
+constexpr MeshPrim WindBellChimesModel::prims[];
+
+// Ninja warrior: torso, head, mask, headband, legs, arms, hands, katana, tabi boots
+struct PlayerModel {
+    static constexpr int PRIM_COUNT = 15;
+    static constexpr MeshPrim prims[PRIM_COUNT] = {
+        meshBox({0, 1.0f, 0}, {0.6f, 0.8f, 0.35f}, meshColor(0.1f, 0.1f, 0.15f)),
+        meshBox({0, 2.0f, 0}, {0.35f, 0.35f, 0.35f}, meshColor(0.85f, 0.75f, 0.65f)),
+        meshBox({0, 1.85f, 0}, {0.38f, 0.25f, 0.36f}, meshColor(0.08f, 0.08f, 0.12f)),
+        meshBox({0, 2.25f, 0}, {0.4f, 0.08f, 0.38f}, meshColor(0.7f, 0.1f, 0.1f)),
+        meshBox({-0.25f, 0.2f, 0}, {0.22f, 0.6f, 0.22f}, meshColor(0.12f, 0.1f, 0.15f)),
+        meshBox({ 0.25f, 0.2f, 0}, {0.22f, 0.6f, 0.22f}, meshColor(0.12f, 0.1f, 0.15f)),
+        meshBox({-0.7f, 1.1f, 0}, {0.18f, 0.6f, 0.15f}, meshColor(0.1f, 0.1f, 0.15f)),
+        meshBox({ 0.7f, 1.1f, 0}, {0.18f, 0.6f, 0.15f}, meshColor(0.1f, 0.1f, 0.15f)),
+        meshBox({-0.9f, 0.6f, 0}, {0.1f, 0.12f, 0.1f}, meshColor(0.15f, 0.1f, 0.1f)),
+        meshBox({ 0.9f, 0.6f, 0}, {0.1f, 0.12f, 0.1f}, meshColor(0.15f, 0.1f, 0.1f)),
+        meshBox({-0.3f, 1.8f, -0.45f}, {0.05f, 0.8f, 0.08f}, meshColor(0.7f, 0.75f, 0.8f)),
+        meshBox({-0.3f, 0.85f, -0.45f}, {0.08f, 0.25f, 0.1f}, meshColor(0.15f, 0.1f, 0.08f)),
+        meshBox({-0.3f, 1.15f, -0.45f}, {0.15f, 0.02f, 0.15f}, meshColor(0.6f, 0.5f, 0.2f)),
+        meshBox({-0.25f, -0.5f, 0.1f}, {0.2f, 0.1f, 0.28f}, meshColor(0.95f, 0.95f, 0.95f)),
+        meshBox({ 0.25f, -0.5f, 0.1f}, {0.2f, 0.1f, 0.28f}, meshColor(0.95f, 0.95f, 0.95f)),
+    };
+};
+constexpr MeshPrim PlayerModel::prims[];
+
+// A small torii-like gateway made from boxes (Japanese aesthetic)
+static void drawTorii(const Vec3&center, float scale, const float col[3]){
+    drawModel<ToriiModel>({center, 0.0f, {scale, scale, scale}}, meshPalette(col));
+}
+
+// A simple pagoda-like stack: boxes + pyramids
+static void drawPagoda(const Vec3&center, float scale, const float col[3]){
+    drawModel<PagodaModel>({center, 0.0f, {scale, scale, scale}}, meshPalette(col));
+}
+
+static void drawDiamond(const Vec3&center, float radius, float height, const float col[3]){
+    gfx->color(col[0], col[1], col[2]);
+    float halfH = height * 0.5f;
+    gfx->begin(DRAW_TRIANGLES);
+    for(int i=0;i<6;i++){
+        float a0 = (float)i/6.0f * 2.0f * PI_F;
+        float a1 = (float)(i+1)/6.0f * 2.0f * PI_F;
+        float x0 = cosf(a0) * radius;
+        float z0 = sinf(a0) * radius;
+        float x1 = cosf(a1) * radius;
+        float z1 = sinf(a1) * radius;
+        // Top half
+        gfx->vertex(center.x, center.y + halfH, center.z);
+        gfx->vertex(center.x + x0, center.y, center.z + z0);
+        gfx->vertex(center.x + x1, center.y, center.z + z1);
+        // Bottom half
+        gfx->vertex(center.x, center.y - halfH, center.z);
+        gfx->vertex(center.x + x1, center.y, center.z + z1);
+        gfx->vertex(center.x + x0, center.y, center.z + z0);
+    }
+    gfx->end();
+}
+
+// Halo rings and glow orbs are additive effects; they are queued and drawn in one batch per frame
+static void drawHaloRing(const Vec3&center, float innerR, float outerR, const float col[3], float alpha){
+    renderQueue.submit(PRIM_HALO_RING, center, innerR, outerR, col, alpha);
+}
+
+static void drawGlowingOrb(const Vec3&center, float radius, const float col[3], float alpha){
+    renderQueue.submit(PRIM_GLOW_ORB, center, radius, 0.0f, col, alpha);
+}
+
+template<int RADIUS_MILLI, int HEIGHT_MILLI>
+static void drawTaikoDrum(const float bodyCol[3], const float frameCol[3], const float ropeCol[3]){
+    drawModel<TaikoDrumModel<RADIUS_MILLI, HEIGHT_MILLI>>({{0,0,0}, 0.0f, {1,1,1}}, meshPalette(bodyCol, frameCol, ropeCol));
+}
+
+static void drawStoneLantern(float scale, const float stoneCol[3], const float glowCol[3]){
+    drawModel<StoneLanternModel>({{0,0,0}, 0.0f, {scale, scale, scale}}, meshPalette(stoneCol));
+    drawGlowingOrb({0.0f, 1.15f*scale, 0.0f}, 0.25f*scale, glowCol, 0.75f);
+}
+
+static void drawLotusOracleModel(float radius, float height, const float col[3]){
+    drawModel<LotusOracleModel>({{0,0,0}, 0.0f, {radius, height, radius}}, meshPalette(col));
+}
+
+static void drawCrystalColumn(float radius, float height, const float col[3]){
+    drawModel<CrystalColumnModel>({{0,0,0}, 0.0f, {radius, height, radius}}, meshPalette(col));
+}
+
+static void drawWindBell(float radius, float height, const float col[3]){
+    MeshPalette pal = meshPalette(col);
+    drawModel<WindBellModel>({{0,0,0}, 0.0f, {radius, height, radius}}, pal);
+    drawModel<WindBellChimesModel>({{0,0,0}, 0.0f, {1.0f, height, 1.0f}}, pal);
+}
+
+static void drawLanternOracle(float radius, float height, const float col[3]){
+    float bodyCol[3]={col[0]*0.9f+0.1f, col[1]*0.9f+0.1f, col[2]*0.6f+0.4f};
+    drawGlowingOrb({0,height*0.8f,0}, radius*0.8f, bodyCol, 0.8f);
+    drawDiamond({0,height*0.8f,0}, radius*0.45f, height, col);
+    drawDiamond({0,height*0.1f,0}, radius*0.3f, height*0.5f, bodyCol);
+}
+
+// Collectible: a small shrine-like piece (3+ primitives): base box + roof pyramid + ornament box
+static void drawCollectibleGeom(const Collectible&c){
+    float r=c.color[0], g=c.color[1], b=c.color[2];
+    // base
+    drawSolidBox({{c.box.center.x, c.box.center.y-0.1f, c.box.center.z}, {c.box.half.x, 0.1f, c.box.half.z}}, r*0.6f,g*0.6f,b*0.6f);
+    // roof
+    drawPyramid({c.box.center.x, c.box.center.y+0.0f, c.box.center.z}, c.box.half.x*3.0f, c.box.half.y*1.8f, r,g,b);
+    // ornament
+    drawSolidBox({{c.box.center.x, c.box.center.y+0.45f, c.box.center.z}, {0.08f,0.2f,0.08f}}, r*0.9f,g*0.9f,b*0.2f);
+}
+
+// Player model (ninja warrior): head with mask, torso (dark gi), legs (hakama pants), arms, katana sword, ninja hood
+static void drawPlayer(){
+    static const MeshPalette noPalette = {};
+    drawModel<PlayerModel>({playerPos, playerYawDeg, {1,1,1}}, noPalette);
+}
+
+// Feature object draw variants
+static void drawFeatureObj(const FeatureObj&f){
+    gfx->pushMatrix();
+    gfx->translate(f.box.center.x, f.box.center.y, f.box.center.z);
+
+    float r=f.baseColor[0], g=f.baseColor[1], b=f.baseColor[2];
+    auto anim = [&](FeatureTrack k){ return animTracks.value(f.track[k]); };
+    float glowPulse = anim(FT_GLOW);
+
+    switch(f.type){
+        case ANIM_ROTATE: {
+            gfx->pushMatrix();
+            gfx->rotate(anim(FT_SPIN), 0, 1, 0);
+            float toriiCol[3]={r,g,b};
+            drawTorii({0,0,0}, 1.6f, toriiCol);
+            gfx->popMatrix();
+
+            gfx->pushMatrix();
+            gfx->translate(0.0f, 4.8f + anim(FT_RISE), 0.0f);
+            drawGlowingOrb({0,0,0}, 0.7f + glowPulse*0.25f, toriiCol, 0.55f + glowPulse*0.35f);
+            gfx->popMatrix();
+
+            gfx->pushMatrix();
+            gfx->rotate(anim(FT_SPIN2), 0, 1, 0);
+            drawHaloRing({0, 3.0f, 0}, 1.0f, 3.5f, toriiCol, 0.25f + glowPulse*0.3f);
+            gfx->popMatrix();
+
+            drawHaloRing({0, 0.6f, 0}, 0.5f, 2.5f, toriiCol, 0.3f + glowPulse*0.3f);
+        } break;
+        case ANIM_SCALE: {
+            float scalePulse = anim(FT_SCALE_XZ);
+            gfx->pushMatrix();
+            gfx->scale(scalePulse, anim(FT_SCALE_Y), scalePulse);
+            float pagodaCol[3]={r,g,b};
+            drawPagoda({0,0,0}, 1.0f, pagodaCol);
+            gfx->popMatrix();
+
+            gfx->pushMatrix();
+            gfx->rotate(anim(FT_SPIN), 0, 1, 0);
+            drawHaloRing({0, 3.1f, 0}, 0.8f, 2.6f, pagodaCol, 0.35f + glowPulse*0.35f);
+            gfx->popMatrix();
+            drawGlowingOrb({0, 4.2f, 0}, 0.55f + glowPulse*0.2f, pagodaCol, 0.4f + glowPulse*0.4f);
+        } break;
+        case ANIM_TRANSLATE: {
+            gfx->pushMatrix();
+            gfx->translate(0, anim(FT_BOB), 0);
+            float bodyCol[3]={std::min(1.0f, r*1.1f), std::min(1.0f, g*0.6f + 0.2f), std::min(1.0f, b*0.5f + 0.15f)};
+            float frameCol[3]={0.45f, 0.2f, 0.12f};
+            float ropeCol[3]={0.95f, 0.9f, 0.8f};
+            drawTaikoDrum<1200, 900>(bodyCol, frameCol, ropeCol);
+            gfx->popMatrix();
+
+            auto drawMallet = [&](float side, float swing){
+                gfx->pushMatrix();
+                gfx->translate(side * 2.1f, 1.5f, 0.0f);
+                gfx->rotate(swing, 0, 0, 1);
+                drawSolidBox({{0.0f, 0.45f, 0.0f}, {0.08f, 0.45f, 0.08f}}, 0.75f, 0.7f, 0.65f);
+                drawSolidBox({{0.0f, 1.0f, 0.0f}, {0.28f, 0.18f, 0.28f}}, 0.3f, 0.3f, 0.3f);
+                gfx->popMatrix();
+            };
+            drawMallet(-1.0f, anim(FT_SWING_L));
+            drawMallet(1.0f, anim(FT_SWING_R));
+
+            drawHaloRing({0, 0.2f, 0}, 0.5f, 1.9f, bodyCol, 0.3f + glowPulse*0.45f);
+        } break;
+        case ANIM_COLOR: {
+            float colorShift = anim(FT_COLOR);
+            float stoneCol[3]={0.65f + 0.2f*r, 0.6f + 0.2f*g, 0.55f + 0.2f*b};
+            float glowCol[3]={0.9f, 0.8f + 0.15f*colorShift, 0.4f + 0.25f*colorShift};
+            gfx->pushMatrix();
+            gfx->scale(1.0f, anim(FT_SCALE_Y), 1.0f);
+            drawStoneLantern(1.0f, stoneCol, glowCol);
+            gfx->popMatrix();
+
+            drawHaloRing({0, 0.4f, 0}, 0.4f, 2.0f, glowCol, 0.35f + glowPulse*0.5f);
+        } break;
+    }
+
+    gfx->popMatrix();
+}
+
+// --------------------------- Particles ---------------------------
+// Structure-of-arrays particle pools for pickup bursts and the game-over explosion.
+// update() runs a four-wide gravity/bounce/fade kernel across the worker pool and writes
+// an interleaved position+colour stream, which draw() submits as a single point batch.
+// Particles bounce on the plane groundY, or on the surfaces of an optional floor grid.
+struct ParticleVertex {
+    float x, y, z;
+    uint32_t rgba; // bytes r,g,b,a in memory order
+};
+
+// Heights particles land on, per cell of a w x h grid over the XZ plane: LAYERS tops in
+// ascending order (unused slots +inf). Positions off the grid use the nearest edge cell.
+struct ParticleFloors {
+    static const int LAYERS = 4;  // one f4 per cell
+    const float* tops;            // w*h cells row-major in z, 16-byte aligned
+    float originX, originZ, invCell;
+    int w, h;
+};
+
+class ParticleSystem {
+public:
+    static constexpr float GRAVITY_Y = -9.8f;
+    static constexpr float BOUNCE = 0.55f;   // vertical restitution on ground contact
+    static constexpr float FRICTION = 0.8f;  // horizontal damping on ground contact
+
+    explicit ParticleSystem(size_t capacity) : cap((capacity + 3) & ~size_t(3)) {
+        size_t floats = cap * STREAM_COUNT;
+        block = static_cast<char*>(std::malloc(floats*sizeof(float) + cap*sizeof(uint32_t) + cap*sizeof(ParticleVertex) + 16));
+        float* base = reinterpret_cast<float*>((reinterpret_cast<uintptr_t>(block) + 15) & ~uintptr_t(15));
+        for(int k=0;k<STREAM_COUNT;k++) soa[k] = base + k*cap;
+        rgb = reinterpret_cast<uint32_t*>(base + floats);
+        verts = reinterpret_cast<ParticleVertex*>(rgb + cap);
+    }
+    ~ParticleSystem(){ std::free(block); }
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    void clear(){ count = 0; deadCount.store(0); }
+    size_t size() const { return count; }
+    size_t capacity() const { return cap; }
+
+    // Spray n particles from origin; excess beyond capacity is dropped
+    void emitBurst(const Vec3& origin, const float col[3], int n, float speed, float lifetime){
+        for(int k=0; k<n && count<cap; k++){
+            size_t i = count++;
+            // random direction on the upper-biased unit sphere
+            float u = randUnit()*2.0f - 1.0f, phi = randUnit()*2.0f*PI_F;
+            float ring = std::sqrt(std::max(0.0f, 1.0f - u*u));
+            float v = speed * (0.3f + 0.7f*randUnit());
+            soa[PX][i] = origin.x; soa[PY][i] = origin.y; soa[PZ][i] = origin.z;
+            soa[VX][i] = ring*cosf(phi)*v; soa[VY][i] = (std::abs(u)*0.8f + 0.2f)*v; soa[VZ][i] = ring*sinf(phi)*v;
+            float life = lifetime * (0.6f + 0.4f*randUnit());
+            soa[LIFE][i] = life; soa[INV_LIFE][i] = 1.0f / life;
+            float jitter = 0.85f + 0.3f*randUnit();
+            uint32_t r = (uint32_t)std::min(255.0f, col[0]*jitter*255.0f);
+            uint32_t g = (uint32_t)std::min(255.0f, col[1]*jitter*255.0f);
+            uint32_t b = (uint32_t)std::min(255.0f, col[2]*jitter*255.0f);
+            rgb[i] = r | (g<<8) | (b<<16);
+        }
+    }
+
+    void update(float dt, float groundY, const ParticleFloors* floors = nullptr){
+        if(deadCount.load()*4 > count) compact();
+        deadCount.store(0);
+        size_t lanes = (count + 3) & ~size_t(3); // tail lanes hold stale data and are never drawn
+        auto kernel = [&](int begin, int end){ updateRange((size_t)begin*4, std::min(lanes, (size_t)end*4), dt, groundY, floors); };
+        workerPool().parallelFor((int)(lanes/4), 2048, kernel);
+    }
+
+    // Every stride-th particle
+    void draw(int stride = 1) const {
+        int n = (int)((count + stride - 1) / stride);
+        if(!n) return;
+        gfx->setBlend(BLEND_ADDITIVE);
+        gfx->pointSize(2.0f);
+        size_t step = stride * sizeof(ParticleVertex);
+        gfx->drawArrays(DRAW_POINTS, n, &verts[0].x, step, &verts[0].rgba, step);
+        gfx->setBlend(BLEND_OPAQUE);
+    }
+
+private:
+    enum { PX, PY, PZ, VX, VY, VZ, LIFE, INV_LIFE, STREAM_COUNT };
+
+    void updateRange(size_t begin, size_t end, float dt, float groundY, const ParticleFloors* floors){
+        const f4 vdt = f4Set1(dt), gdt = f4Set1(GRAVITY_Y*dt), plane = f4Set1(groundY);
+        const f4 bounce = f4Set1(-BOUNCE), friction = f4Set1(FRICTION), zero = f4Set1(0.0f);
+        size_t dead = 0;
+        alignas(16) float outX[4], outY[4], outZ[4], outA[4];
+        for(size_t i=begin; i<end; i+=4){
+            f4 vx = f4Load(soa[VX]+i), vy = f4Load(soa[VY]+i), vz = f4Load(soa[VZ]+i);
+            vy = f4Add(vy, gdt);
+            f4 px = f4Add(f4Load(soa[PX]+i), f4Mul(vx, vdt));
+            f4 py = f4Add(f4Load(soa[PY]+i), f4Mul(vy, vdt));
+            f4 pz = f4Add(f4Load(soa[PZ]+i), f4Mul(vz, vdt));
+            f4 ground = plane;
+            if(floors){
+                // The highest top at or below where the particle was before this step
+                f4 gx = f4Mul(f4Sub(px, f4Set1(floors->originX)), f4Set1(floors->invCell));
+                f4 gz = f4Mul(f4Sub(pz, f4Set1(floors->originZ)), f4Set1(floors->invCell));
+                f4Store(outX, f4Min(f4Max(gx, zero), f4Set1((float)(floors->w - 1))));
+                f4Store(outZ, f4Min(f4Max(gz, zero), f4Set1((float)(floors->h - 1))));
+                int cell[4];
+                for(int k=0;k<4;k++) cell[k] = (int)outZ[k]*floors->w + (int)outX[k];
+                f4 t[4] = { f4Load(floors->tops + 4*cell[0]), f4Load(floors->tops + 4*cell[1]),
+                            f4Load(floors->tops + 4*cell[2]), f4Load(floors->tops + 4*cell[3]) };
+                f4Transpose(t[0], t[1], t[2], t[3]); // t[j] = layer j of the four cells
+                f4 fromY = f4Load(soa[PY]+i);
+                for(int j=0;j<ParticleFloors::LAYERS;j++) ground = f4Select(f4Less(fromY, t[j]), ground, t[j]);
+            }
+            f4 hit = f4Less(py, ground);
+            py = f4Select(hit, ground, py);
+            vy = f4Select(hit, f4Mul(vy, bounce), vy);
+            vx = f4Select(hit, f4Mul(vx, friction), vx);
+            vz = f4Select(hit, f4Mul(vz, friction), vz);
+            f4 life = f4Sub(f4Load(soa[LIFE]+i), vdt);
+            f4 alpha = f4Max(f4Mul(life, f4Load(soa[INV_LIFE]+i)), zero);
+            f4Store(soa[PX]+i, px); f4Store(soa[PY]+i, py); f4Store(soa[PZ]+i, pz);
+            f4Store(soa[VX]+i, vx); f4Store(soa[VY]+i, vy); f4Store(soa[VZ]+i, vz);
+            f4Store(soa[LIFE]+i, life);
+
+            f4Store(outX, px); f4Store(outY, py); f4Store(outZ, pz); f4Store(outA, alpha);
+            for(int k=0;k<4;k++){
+                uint32_t a = (uint32_t)(std::min(outA[k], 1.0f) * 255.0f);
+                dead += (a==0 && i+k<count);
+                verts[i+k] = { outX[k], outY[k], outZ[k], rgb[i+k] | (a<<24) };
+            }
+        }
+        deadCount.fetch_add(dead);
+    }
+
+    // Squeeze out expired particles (serial; only runs once a quarter of the pool is dead)
+    void compact(){
+        size_t w = 0;
+        for(size_t i=0;i<count;i++){
+            if(soa[LIFE][i] <= 0.0f) continue;
+            if(w != i){
+                for(int k=0;k<STREAM_COUNT;k++) soa[k][w] = soa[k][i];
+                rgb[w] = rgb[i];
+            }
+            w++;
+        }
+        count = w;
+    }
+
+    float randUnit(){
+        rng ^= rng<<13; rng ^= rng>>17; rng ^= rng<<5;
+        return (rng >> 8) * (1.0f / 16777216.0f);
+    }
+
+    char* block = nullptr;
+    float* soa[STREAM_COUNT];
+    uint32_t* rgb = nullptr;
+    ParticleVertex* verts = nullptr;
+    size_t cap, count = 0;
+    std::atomic<size_t> deadCount{0};
+    uint32_t rng = 0x2545F491u;
+};
+
+static ParticleSystem particles(1u << 17);
+
+static float groundTopY(){ return groundBox.center.y + groundBox.half.y; }
+
+// --------------------------- World BVH ---------------------------
+// Bounding-volume hierarchy over every solid box in the level: ground, walls, platforms,
+// obstacles and features. It is built by resetGame() and refit by updateObstacles(), so
+// moving obstacles only widen node bounds instead of forcing a rebuild. Queries take a
+// mask of primitive kinds. Prims and nodes live in the level arena, sized from the level's
+// box count at build time. castBox() sweeps a box along a direction and reports the
+// closest hit (a ray is a cast with zero extent); overlapBox() visits boxes touching a box.
+enum WorldPrimKind : uint8_t { WP_GROUND=0, WP_WALL, WP_PLATFORM, WP_OBSTACLE, WP_FEATURE };
+static const uint32_t WP_MASK_ALL = 0x1F;
+static const uint32_t WP_MASK_SOLID = WP_MASK_ALL & ~(1u<<WP_GROUND); // everything that can block a camera or a line of sight
+
+static inline uint32_t worldPrimBit(WorldPrimKind k){ return 1u << k; }
+
+struct WorldPrim {
+    AABB box;
+    WorldPrimKind kind;
+    int index; // into walls/platforms/obstacles/features; 0 for the ground
+};
+
+struct CastHit {
+    float t;      // distance along the (unit) direction; 0 if already overlapping
+    Vec3 normal;  // face of the hit box, zero when starting inside
+    WorldPrimKind kind;
+    int index;
+};
+
+class WorldBVH {
+public:
+    // Call after the level is laid out; the storage is abandoned with the next levelArena reset
+    void build(){
+        int capacity = 1 + (int)walls.size() + 4 + (int)obstacles.size() + 4;
+        prims = levelArena.allocArray<WorldPrim>(capacity);
+        nodes = levelArena.allocArray<Node>(2*capacity - 1); // leaves hold at least one prim
+        primCount = 0;
+        addPrim(groundBox, WP_GROUND, 0);
+        for(size_t i=0;i<walls.size();i++) addPrim(walls[i], WP_WALL, (int)i);
+        for(int i=0;i<4;i++) addPrim(platforms[i].box, WP_PLATFORM, i);
+        for(size_t i=0;i<obstacles.size();i++) addPrim(obstacles[i].box, WP_OBSTACLE, (int)i);
+        for(int i=0;i<4;i++) addPrim(features[i].box, WP_FEATURE, i);
+        nodeCount = primCount ? 1 : 0;
+        if(primCount) subdivide(0, 0, primCount);
+    }
+
+    // Re-reads moving obstacles and recomputes node bounds bottom-up (children follow parents)
+    void refit(){
+        for(int i=0;i<primCount;i++){
+            if(prims[i].kind==WP_OBSTACLE && obstacles[prims[i].index].isMoving) prims[i].box = obstacles[prims[i].index].box;
+        }
+        for(int n=nodeCount-1;n>=0;n--){
+            Node& nd = nodes[n];
+            if(nd.count){ boundsOf(nd.first, nd.count, nd.lo, nd.hi); continue; }
+            const Node& a = nodes[nd.left]; const Node& b = nodes[nd.left+1];
+            nd.lo = {std::min(a.lo.x,b.lo.x), std::min(a.lo.y,b.lo.y), std::min(a.lo.z,b.lo.z)};
+            nd.hi = {std::max(a.hi.x,b.hi.x), std::max(a.hi.y,b.hi.y), std::max(a.hi.z,b.hi.z)};
+        }
+    }
+
+    // Closest box hit by `box` moving along unit `dir` for up to maxDist; hit may be null for an any-hit test
+    bool castBox(const AABB& box, const Vec3& dir, float maxDist, uint32_t mask, CastHit* hit) const {
+        if(!nodeCount) return false;
+        Vec3 inv = { dir.x!=0.0f ? 1.0f/dir.x : 1e30f, dir.y!=0.0f ? 1.0f/dir.y : 1e30f, dir.z!=0.0f ? 1.0f/dir.z : 1e30f };
+        const Vec3& o = box.center; const Vec3& e = box.half;
+        float best = maxDist;
+        bool found = false;
+        int stack[64], sp = 0;
+        stack[sp++] = 0;
+        while(sp){
+            const Node& nd = nodes[stack[--sp]];
+            float tn;
+            if(!slab(o, inv, sub(nd.lo, e), add(nd.hi, e), best, tn, nullptr)) continue;
+            if(nd.count){
+                for(int i=nd.first;i<nd.first+nd.count;i++){
+                    const WorldPrim& pr = prims[i];
+                    if(!(mask & worldPrimBit(pr.kind))) continue;
+                    Vec3 lo = sub(sub(pr.box.center, pr.box.half), e), hi = add(add(pr.box.center, pr.box.half), e);
+                    int axis;
+                    float t;
+                    if(!slab(o, inv, lo, hi, best, t, &axis)) continue;
+                    found = true;
+                    if(!hit) return true;
+                    best = t;
+                    hit->t = t; hit->kind = pr.kind; hit->index = pr.index;
+                    hit->normal = {0,0,0};
+                    if(axis==0) hit->normal.x = dir.x>0 ? -1.0f : 1.0f;
+                    if(axis==1) hit->normal.y = dir.y>0 ? -1.0f : 1.0f;
+                    if(axis==2) hit->normal.z = dir.z>0 ? -1.0f : 1.0f;
+                }
+                continue;
+            }
+            // Push the farther child first so the nearer one is searched first and tightens `best`
+            int a = nd.left, b = nd.left+1;
+            float ta, tb;
+            bool ha = slab(o, inv, sub(nodes[a].lo, e), add(nodes[a].hi, e), best, ta, nullptr);
+            bool hb = slab(o, inv, sub(nodes[b].lo, e), add(nodes[b].hi, e), best, tb, nullptr);
+            if(ha && hb && ta < tb){ stack[sp++] = b; stack[sp++] = a; }
+            else { if(ha) stack[sp++] = a; if(hb) stack[sp++] = b; }
+        }
+        return found;
+    }
+
+    bool raycast(const Vec3& origin, const Vec3& dir, float maxDist, uint32_t mask, CastHit* hit) const {
+        return castBox({origin, {0,0,0}}, dir, maxDist, mask, hit);
+    }
+
+    bool lineOfSight(const Vec3& from, const Vec3& to, uint32_t mask = WP_MASK_SOLID) const {
+        Vec3 d = sub(to, from);
+        float len = std::sqrt(d.x*d.x + d.y*d.y + d.z*d.z);
+        if(len < 1e-6f) return true;
+        return !raycast(from, mul(d, 1.0f/len), len, mask, nullptr);
+    }
+
+    // Calls fn(prim) for each masked box intersecting `box` (inclusive, like aabbIntersects); fn returns true to stop
+    template<class Fn>
+    bool overlapBox(const AABB& box, uint32_t mask, const Fn& fn) const {
+        if(!nodeCount) return false;
+        Vec3 lo = sub(box.center, box.half), hi = add(box.center, box.half);
+        int stack[64], sp = 0;
+        stack[sp++] = 0;
+        while(sp){
+            const Node& nd = nodes[stack[--sp]];
+            if(hi.x < nd.lo.x || lo.x > nd.hi.x || hi.y < nd.lo.y || lo.y > nd.hi.y || hi.z < nd.lo.z || lo.z > nd.hi.z) continue;
+            if(!nd.count){ stack[sp++] = nd.left; stack[sp++] = nd.left+1; continue; }
+            for(int i=nd.first;i<nd.first+nd.count;i++){
+                if((mask & worldPrimBit(prims[i].kind)) && aabbIntersects(box, prims[i].box) && fn(prims[i])) return true;
+            }
+        }
+        return false;
+    }
+
+    int size() const { return primCount; }
+    const WorldPrim& prim(int i) const { return prims[i]; }
+
+private:
+    struct Node {
+        Vec3 lo, hi;
+        int left;         // first child (the second is left+1) for inner nodes
+        int first, count; // prim range for leaves; count==0 marks an inner node
+    };
+
+    void addPrim(const AABB& b, WorldPrimKind kind, int index){ prims[primCount++] = {b, kind, index}; }
+
+    void boundsOf(int first, int count, Vec3& lo, Vec3& hi) const {
+        lo = {1e30f, 1e30f, 1e30f}; hi = {-1e30f, -1e30f, -1e30f};
+        for(int i=first;i<first+count;i++){
+            Vec3 a = sub(prims[i].box.center, prims[i].box.half), b = add(prims[i].box.center, prims[i].box.half);
+            lo = {std::min(lo.x,a.x), std::min(lo.y,a.y), std::min(lo.z,a.z)};
+            hi = {std::max(hi.x,b.x), std::max(hi.y,b.y), std::max(hi.z,b.z)};
+        }
+    }
+
+    // Median split on the widest centre axis; leaves hold up to two boxes. Children are
+    // allocated as a pair after their parent, which is the order refit() relies on.
+    void subdivide(int n, int first, int count){
+        boundsOf(first, count, nodes[n].lo, nodes[n].hi);
+        if(count <= 2){ nodes[n].first = first; nodes[n].count = count; nodes[n].left = -1; return; }
+        Vec3 clo = {1e30f,1e30f,1e30f}, chi = {-1e30f,-1e30f,-1e30f};
+        for(int i=first;i<first+count;i++){
+            const Vec3& c = prims[i].box.center;
+            clo = {std::min(clo.x,c.x), std::min(clo.y,c.y), std::min(clo.z,c.z)};
+            chi = {std::max(chi.x,c.x), std::max(chi.y,c.y), std::max(chi.z,c.z)};
+        }
+        float ex = chi.x-clo.x, ey = chi.y-clo.y, ez = chi.z-clo.z;
+        int axis = (ex>=ey && ex>=ez) ? 0 : (ey>=ez ? 1 : 2);
+        auto key = [axis](const WorldPrim& p){ return axis==0 ? p.box.center.x : axis==1 ? p.box.center.y : p.box.center.z; };
+        int mid = first + count/2;
+        std::nth_element(prims+first, prims+mid, prims+first+count, [&](const WorldPrim& a, const WorldPrim& b){ return key(a) < key(b); });
+        int left = nodeCount;
+        nodeCount += 2;
+        nodes[n].left = left; nodes[n].first = 0; nodes[n].count = 0;
+        subdivide(left, first, mid-first);
+        subdivide(left+1, mid, first+count-mid);
+    }
+
+    // Ray/slab test; tEnter is clamped to 0 when the origin starts inside
+    static bool slab(const Vec3& o, const Vec3& inv, const Vec3& lo, const Vec3& hi, float maxT, float& tEnter, int* axis){
+        float tx1 = (lo.x-o.x)*inv.x, tx2 = (hi.x-o.x)*inv.x;
+        float ty1 = (lo.y-o.y)*inv.y, ty2 = (hi.y-o.y)*inv.y;
+        float tz1 = (lo.z-o.z)*inv.z, tz2 = (hi.z-o.z)*inv.z;
+        float nx = std::min(tx1,tx2), ny = std::min(ty1,ty2), nz = std::min(tz1,tz2);
+        float tmin = std::max(nx, std::max(ny, nz));
+        float tmax = std::min(std::max(tx1,tx2), std::min(std::max(ty1,ty2), std::max(tz1,tz2)));
+        if(tmax < std::max(tmin, 0.0f) || tmin > maxT) return false;
+        if(axis) *axis = tmin < 0.0f ? -1 : (tmin==nx ? 0 : (tmin==ny ? 1 : 2));
+        tEnter = std::max(tmin, 0.0f);
+        return true;
+    }
+
+    WorldPrim* prims = nullptr;
+    Node* nodes = nullptr;
+    int primCount = 0, nodeCount = 0;
+};
+
+static WorldBVH worldBVH;
+
+// --------------------------- Support map ---------------------------
+// Walkable tops of the courtyard compiled onto a SUPPORT_CELL grid over the XZ plane at
+// level load. Each cell lists the boxes (ground, platforms, obstacles, features) whose
+// footprint touches it, sorted by top height, so "what am I standing on" and "highest
+// surface below me" read a cell or two instead of scanning the level. A moving obstacle is
+// entered in every cell of its sweep and its live box is read at query time, so it never
+// forces a rebuild (obstacles only slide in x, which keeps the sort valid). Particles use a
+// finer, approximate copy: the static tops at the centre of each FLOOR_CELL square, which
+// the particle kernel reads without any footprint tests. Sources, cells, entries and floor
+// squares live in the level arena, sized from the level at build time.
+static const float SUPPORT_CELL = 2.0f;
+static const float FLOOR_CELL = 0.5f;
+
+struct SupportEntry {
+    float top;
+    WorldPrimKind kind;
+    bool moving;
+    int index; // into platforms/obstacles/features; 0 for the ground
+};
+
+static const uint32_t SUPPORT_MASK_STAND = (1u<<WP_GROUND) | (1u<<WP_PLATFORM) | (1u<<WP_OBSTACLE); // what isBoxOnSurface accepts
+static const uint32_t SUPPORT_MASK_ALL = SUPPORT_MASK_STAND | (1u<<WP_FEATURE);
+
+class SupportMap {
+public:
+    // Call after the level is laid out; the storage is abandoned with the next levelArena reset
+    void build(){
+        sources = levelArena.allocArray<Source>(1 + 4 + obstacles.size() + 4);
+        sourceCount = 0;
+        addSource(groundBox, WP_GROUND, 0, false);
+        for(int i=0;i<4;i++) addSource(platforms[i].box, WP_PLATFORM, i, false);
+        for(size_t i=0;i<obstacles.size();i++){
+            const Obstacle& o = obstacles[i];
+            AABB area = o.box;
+            if(o.isMoving){ area.center = o.basePos; area.half.x += o.moveRange; }
+            addSource(area, WP_OBSTACLE, (int)i, o.isMoving);
+        }
+        for(int i=0;i<4;i++) addSource(features[i].box, WP_FEATURE, i, false);
+
+        // Grid over the union of the footprints
+        loX = loZ = 1e30f;
+        float hiX = -1e30f, hiZ = -1e30f;
+        for(int s=0;s<sourceCount;s++){
+            const AABB& a = sources[s].area;
+            loX = std::min(loX, a.center.x - a.half.x); hiX = std::max(hiX, a.center.x + a.half.x);
+            loZ = std::min(loZ, a.center.z - a.half.z); hiZ = std::max(hiZ, a.center.z + a.half.z);
+        }
+        cellsX = sourceCount ? (int)((hiX - loX) / SUPPORT_CELL) + 1 : 0;
+        cellsZ = sourceCount ? (int)((hiZ - loZ) / SUPPORT_CELL) + 1 : 0;
+        const int cells = cellsX*cellsZ;
+
+        // Two passes: count entries per cell, then fill the compacted lists
+        cellStart = levelArena.allocArray<int>(cells + 1);
+        cellFill = levelArena.allocArray<int>(cells);
+        std::fill(cellStart, cellStart + cells + 1, 0);
+        for(int s=0;s<sourceCount;s++) forCells(sources[s].area, [&](int c){ cellStart[c+1]++; });
+        for(int c=0;c<cells;c++) cellStart[c+1] += cellStart[c];
+        entryCount = cellStart[cells];
+        entries = levelArena.allocArray<SupportEntry>(entryCount);
+        std::copy(cellStart, cellStart + cells, cellFill);
+        for(int s=0;s<sourceCount;s++){
+            const Source& src = sources[s];
+            SupportEntry e = { src.top, src.kind, src.moving, src.index };
+            forCells(src.area, [&](int c){ entries[cellFill[c]++] = e; });
+        }
+        for(int c=0;c<cells;c++){
+            std::sort(entries + cellStart[c], entries + cellStart[c+1], [](const SupportEntry& a, const SupportEntry& b){ return a.top < b.top; });
+        }
+
+        // Particle floors: the highest LAYERS static tops at each square's centre
+        const int layers = ParticleFloors::LAYERS;
+        floors.w = std::max(1, (int)(cellsX * SUPPORT_CELL / FLOOR_CELL));
+        floors.h = std::max(1, (int)(cellsZ * SUPPORT_CELL / FLOOR_CELL));
+        floors.originX = loX; floors.originZ = loZ;
+        floors.invCell = 1.0f / FLOOR_CELL;
+        float* floorTops = static_cast<float*>(levelArena.alloc(sizeof(float) * floors.w * floors.h * layers, 16)); // one f4 per square
+        floors.tops = floorTops;
+        for(int fz=0;fz<floors.h;fz++) for(int fx=0;fx<floors.w;fx++){
+            float slot[layers];
+            int used = 0;
+            forEachTop(loX + (fx + 0.5f)*FLOOR_CELL, loZ + (fz + 0.5f)*FLOOR_CELL, SUPPORT_MASK_ALL, [&](float top){
+                if(used == layers){ std::copy(slot + 1, slot + layers, slot); used--; } // keep the highest
+                slot[used++] = top;
+            });
+            for(int j=0;j<layers;j++) floorTops[(fz*floors.w + fx)*layers + j] = j < used ? slot[j] : INFINITY;
+        }
+    }
+
+    // Same answer as testing `box` against every masked walkable box with aabbIntersects
+    bool touches(const AABB& box, uint32_t mask, bool withMoving) const {
+        int cx0, cx1, cz0, cz1;
+        if(!cellRange(box, cx0, cx1, cz0, cz1)) return false;
+        float bottom = box.center.y - box.half.y;
+        for(int cz=cz0;cz<=cz1;cz++) for(int cx=cx0;cx<=cx1;cx++){
+            int c = cz*cellsX + cx;
+            for(int e=cellEnd(c)-1;e>=cellStart[c] && entries[e].top >= bottom;e--){
+                const SupportEntry& en = entries[e];
+                if(!(mask & worldPrimBit(en.kind)) || (en.moving && !withMoving)) continue;
+                if(aabbIntersects(box, boxOf(en))) return true;
+            }
+        }
+        return false;
+    }
+
+    // isBoxOnSurface for the live level: ground, a platform or an obstacle within 0.1 below
+    bool standing(const AABB& box, bool withMoving) const {
+        AABB probe = box;
+        probe.center.y -= 0.1f;
+        return touches(probe, SUPPORT_MASK_STAND, withMoving);
+    }
+
+    const ParticleFloors& particleFloors() const { return floors; }
+
+    // Calls fn(top) for the masked static tops whose footprint holds (x, z), lowest first
+    template<class Fn>
+    void forEachTop(float x, float z, uint32_t mask, const Fn& fn) const {
+        int c = cellAt(x, z);
+        if(c < 0) return;
+        for(int e=cellStart[c];e<cellEnd(c);e++){
+            const SupportEntry& en = entries[e];
+            if((mask & worldPrimBit(en.kind)) && !en.moving && contains(boxOf(en), x, z)) fn(en.top);
+        }
+    }
+
+    int cellCount() const { return cellsX*cellsZ; }
+    int entryTotal() const { return entryCount; }
+
+    static bool contains(const AABB& b, float x, float z){
+        return std::abs(x - b.center.x) <= b.half.x && std::abs(z - b.center.z) <= b.half.z;
+    }
+
+private:
+    struct Source {
+        AABB area; // footprint; the whole sweep for a moving obstacle
+        float top;
+        WorldPrimKind kind;
+        bool moving;
+        int index;
+    };
+
+    void addSource(const AABB& area, WorldPrimKind kind, int index, bool moving){
+        sources[sourceCount++] = { area, area.center.y + area.half.y, kind, moving, index };
+    }
+
+    static const AABB& boxOf(const SupportEntry& e){
+        switch(e.kind){
+            case WP_PLATFORM: return platforms[e.index].box;
+            case WP_OBSTACLE: return obstacles[e.index].box;
+            case WP_FEATURE:  return features[e.index].box;
+            default:          return groundBox;
+        }
+    }
+
+    int cellEnd(int c) const { return cellStart[c+1]; }
+
+    // Truncation is floor once negatives are clamped away
+    int cellX(float x) const { return std::min(cellsX-1, (int)std::max(0.0f, (x - loX) * (1.0f / SUPPORT_CELL))); }
+    int cellZ(float z) const { return std::min(cellsZ-1, (int)std::max(0.0f, (z - loZ) * (1.0f / SUPPORT_CELL))); }
+
+    int cellAt(float x, float z) const {
+        if(!cellsX || x < loX || z < loZ || x > loX + cellsX*SUPPORT_CELL || z > loZ + cellsZ*SUPPORT_CELL) return -1;
+        return cellZ(z)*cellsX + cellX(x);
+    }
+
+    // Cells touched by a footprint (inclusive edges, like aabbIntersects); false if it misses the grid
+    bool cellRange(const AABB& b, int& cx0, int& cx1, int& cz0, int& cz1) const {
+        float x0 = b.center.x - b.half.x, x1 = b.center.x + b.half.x;
+        float z0 = b.center.z - b.half.z, z1 = b.center.z + b.half.z;
+        if(!cellsX || x1 < loX || z1 < loZ || x0 > loX + cellsX*SUPPORT_CELL || z0 > loZ + cellsZ*SUPPORT_CELL) return false;
+        cx0 = cellX(x0); cx1 = cellX(x1); cz0 = cellZ(z0); cz1 = cellZ(z1);
+        return true;
+    }
+
+    template<class Fn>
+    void forCells(const AABB& area, const Fn& fn) const {
+        int cx0, cx1, cz0, cz1;
+        if(!cellRange(area, cx0, cx1, cz0, cz1)) return;
+        for(int cz=cz0;cz<=cz1;cz++) for(int cx=cx0;cx<=cx1;cx++) fn(cz*cellsX + cx);
+    }
+
+    Source* sources = nullptr;
+    int sourceCount = 0;
+    float loX = 0.0f, loZ = 0.0f;
+    int cellsX = 0, cellsZ = 0;
+    int* cellStart = nullptr;
+    int* cellFill = nullptr;
+    SupportEntry* entries = nullptr;
+    int entryCount = 0;
+    ParticleFloors floors = {};
+};
+
+static SupportMap supportMap;
+
+// --------------------------- World streaming ---------------------------
+// Beyond the courtyard the world is an endless grid of CHUNK_SIZE chunks generated from
+// their coordinates. Loader threads build each chunk: its solid boxes, a CHUNK_GRID^2
+// collision grid over them, and all its geometry baked into one triangle array. The main
+// thread only installs finished chunks, evicts ones outside EVICT_RADIUS or over the byte
+// budget, and queues the missing ones nearest-first. Positions stay small through a
+// floating origin: chunk data is chunk-local, and once the player is REBASE_DISTANCE from
+// the local origin the origin moves by whole chunks. The courtyard keeps its absolute
+// coordinates and only exists while the origin is home, so while the origin is elsewhere
+// it is far out of reach and out of view.
+static const float CHUNK_SIZE = 40.0f;
+static const int CHUNK_GRID = 8; // collision cells per chunk side
+static const int LOAD_RADIUS = 3, EVICT_RADIUS = 4; // in chunks (Chebyshev distance)
+static const float REBASE_DISTANCE = 1024.0f;
+static const float REHOME_DISTANCE = 768.0f; // the courtyard is beyond the far plane when it pops back
+
+// Absolute chunk coordinates of the local origin
+static int originChunkX = 0, originChunkZ = 0;
+
+static bool originAtHome(){ return originChunkX==0 && originChunkZ==0; }
+static int chunkCoordOf(int originChunk, float local){ return originChunk + (int)std::floor(local / CHUNK_SIZE); }
+static Vec3 chunkOffset(int cx, int cz){ return { (cx - originChunkX) * CHUNK_SIZE, 0.0f, (cz - originChunkZ) * CHUNK_SIZE }; }
+
+// The courtyard ground covers these four chunks exactly; they are never streamed
+static bool isCourtyardChunk(int cx, int cz){ return (cx==-1 || cx==0) && (cz==-1 || cz==0); }
+// Courtyard plus its backdrop: ground only, no props
+static bool isHomeChunk(int cx, int cz){ return cx >= -2 && cx <= 1 && cz >= -2 && cz <= 0; }
+
+struct ChunkVertex {
+    float x, y, z;
+    uint32_t rgba;
+};
+
+struct WorldChunk {
+    int cx, cz;
+    std::vector<AABB> solids;        // chunk-local
+    std::vector<uint16_t> cellStart; // CHUNK_GRID*CHUNK_GRID + 1 offsets into cellItems
+    std::vector<uint16_t> cellItems; // indices into solids
+    std::vector<ChunkVertex> verts;  // chunk-local, drawn as GL_TRIANGLES
+
+    size_t bytes() const {
+        return sizeof(WorldChunk) + solids.capacity()*sizeof(AABB) + (cellStart.capacity() + cellItems.capacity())*sizeof(uint16_t) +
+               verts.capacity()*sizeof(ChunkVertex);
+    }
+};
+
+static const AABB CHUNK_GROUND = {{CHUNK_SIZE*0.5f, 0.0f, CHUNK_SIZE*0.5f}, {CHUNK_SIZE*0.5f, 0.2f, CHUNK_SIZE*0.5f}};
+static const float CHUNK_TOP = 24.0f; // nothing built in a chunk reaches above this
+
+static uint32_t packColor(float r, float g, float b){
+    return (uint32_t)(std::min(1.0f, r)*255.0f + 0.5f) | ((uint32_t)(std::min(1.0f, g)*255.0f + 0.5f) << 8) |
+           ((uint32_t)(std::min(1.0f, b)*255.0f + 0.5f) << 16) | 0xFF000000u;
+}
+
+// Same faces and winding as drawSolidBox
+static void bakeBox(std::vector<ChunkVertex>& out, const AABB& b, float r, float g, float bl){
+    uint32_t c = packColor(r, g, bl);
+    for(int i=0;i<36;i++){
+        const signed char* sg = &MESH_BOX_SIGNS[((i/6)*4 + meshQuadCorner((i%6)/3, i%3))*3];
+        out.push_back({ b.center.x + sg[0]*b.half.x, b.center.y + sg[1]*b.half.y, b.center.z + sg[2]*b.half.z, c });
+    }
+}
+
+template<class Model>
+static void bakeModel(std::vector<ChunkVertex>& out, const Vec3& pos, float scale, const MeshPalette& pal){
+    typedef MeshData<Model> Mesh;
+    for(int i=0;i<Mesh::COUNT;i++){
+        const MeshVertex& v = Mesh::verts[i];
+        out.push_back({ pos.x + v.x*scale, pos.y + v.y*scale, pos.z + v.z*scale, meshTintColor(Model::prims[v.prim].tint, pal) });
+    }
+}
+
+// Deterministic per-chunk generator state
+struct ChunkRng {
+    uint32_t state;
+    ChunkRng(int cx, int cz){
+        uint32_t h = (uint32_t)cx * 0x9E3779B1u ^ ((uint32_t)cz + 0x7F4A7C15u) * 0x85EBCA77u;
+        h ^= h >> 15; h *= 0x2C1B3C6Du; h ^= h >> 12;
+        state = h ? h : 1u;
+    }
+    uint32_t next(){ state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; }
+    float range(float a, float b){ return a + (b - a) * (float)(next() >> 8) * (1.0f / 16777216.0f); }
+    bool chance(float p){ return range(0.0f, 1.0f) < p; }
+};
+
+static WorldChunk* buildChunk(int cx, int cz){
+    WorldChunk* c = new WorldChunk();
+    c->cx = cx; c->cz = cz;
+    ChunkRng rng(cx, cz);
+    const float groundTop = CHUNK_GROUND.center.y + CHUNK_GROUND.half.y;
+
+    // Meadow ground with a few flagstones
+    float tone = rng.range(-0.04f, 0.04f);
+    bakeBox(c->verts, CHUNK_GROUND, 0.31f + tone, 0.36f + tone, 0.25f);
+    int stones = 3 + (int)(rng.next() % 5);
+    for(int i=0;i<stones;i++){
+        float x = rng.range(3.0f, CHUNK_SIZE-3.0f), z = rng.range(3.0f, CHUNK_SIZE-3.0f), h = rng.range(1.5f, 3.5f);
+        bakeBox(c->verts, {{x, groundTop + 0.005f, z}, {h, 0.005f, h}}, 0.3f, 0.29f, 0.27f);
+    }
+
+    if(!isHomeChunk(cx, cz)){
+        // Boulders
+        int boulders = 2 + (int)(rng.next() % 4);
+        for(int i=0;i<boulders;i++){
+            Vec3 half = { rng.range(0.6f, 1.8f), rng.range(0.4f, 1.5f), rng.range(0.6f, 1.8f) };
+            AABB b = {{rng.range(4.0f, CHUNK_SIZE-4.0f), groundTop + half.y, rng.range(4.0f, CHUNK_SIZE-4.0f)}, half};
+            float grey = rng.range(0.38f, 0.52f);
+            c->solids.push_back(b);
+            bakeBox(c->verts, b, grey, grey*0.97f, grey*0.92f);
+        }
+        // Bamboo grove
+        if(rng.chance(0.5f)){
+            float gx = rng.range(6.0f, CHUNK_SIZE-6.0f), gz = rng.range(6.0f, CHUNK_SIZE-6.0f);
+            int stalks = 3 + (int)(rng.next() % 4);
+            for(int i=0;i<stalks;i++){
+                float h = rng.range(10.0f, 20.0f);
+                AABB b = {{gx + rng.range(-2.5f, 2.5f), groundTop + h*0.5f, gz + rng.range(-2.5f, 2.5f)}, {0.3f, h*0.5f, 0.3f}};
+                c->solids.push_back(b);
+                bakeBox(c->verts, b, 0.25f, rng.range(0.45f, 0.6f), 0.25f);
+            }
+        }
+        // Wayside torii
+        if(rng.chance(0.25f)){
+            Vec3 pos = { rng.range(8.0f, CHUNK_SIZE-8.0f), groundTop, rng.range(8.0f, CHUNK_SIZE-8.0f) };
+            const float scale = 0.8f;
+            const float red[3] = { 0.75f, 0.12f, 0.1f };
+            bakeModel<ToriiModel>(c->verts, pos, scale, meshPalette(red));
+            c->solids.push_back({{pos.x - scale, pos.y + 2.0f*scale, pos.z}, {0.3f*scale, 2.0f*scale, 0.3f*scale}});
+            c->solids.push_back({{pos.x + scale, pos.y + 2.0f*scale, pos.z}, {0.3f*scale, 2.0f*scale, 0.3f*scale}});
+        }
+        // Stone lantern
+        if(rng.chance(0.3f)){
+            Vec3 pos = { rng.range(4.0f, CHUNK_SIZE-4.0f), groundTop, rng.range(4.0f, CHUNK_SIZE-4.0f) };
+            const float stone[3] = { 0.6f, 0.58f, 0.54f };
+            bakeModel<StoneLanternModel>(c->verts, pos, 1.0f, meshPalette(stone));
+            c->solids.push_back({{pos.x, pos.y + 0.95f, pos.z}, {0.45f, 0.95f, 0.45f}});
+        }
+    }
+
+    // Collision grid: counting sort of solids into the cells their XZ extent touches
+    const float cell = CHUNK_SIZE / CHUNK_GRID;
+    auto cellRange = [cell](float lo, float hi, int& a, int& b){
+        a = std::max(0, std::min(CHUNK_GRID-1, (int)std::floor(lo / cell)));
+        b = std::max(0, std::min(CHUNK_GRID-1, (int)std::floor(hi / cell)));
+    };
+    c->cellStart.assign(CHUNK_GRID*CHUNK_GRID + 1, 0);
+    for(int pass=0;pass<2;pass++){
+        std::vector<uint16_t> fill;
+        if(pass==1){
+            for(int i=0;i<CHUNK_GRID*CHUNK_GRID;i++) c->cellStart[i+1] += c->cellStart[i];
+            c->cellItems.resize(c->cellStart.back());
+            fill.assign(c->cellStart.begin(), c->cellStart.end() - 1);
+        }
+        for(size_t i=0;i<c->solids.size();i++){
+            const AABB& b = c->solids[i];
+            int x0, x1, z0, z1;
+            cellRange(b.center.x - b.half.x, b.center.x + b.half.x, x0, x1);
+            cellRange(b.center.z - b.half.z, b.center.z + b.half.z, z0, z1);
+            for(int z=z0;z<=z1;z++) for(int x=x0;x<=x1;x++){
+                if(pass==0) c->cellStart[z*CHUNK_GRID + x + 1]++;
+                else c->cellItems[fill[z*CHUNK_GRID + x]++] = (uint16_t)i;
+            }
+        }
+    }
+    c->verts.shrink_to_fit();
+    return c;
+}
+
+class WorldStreamer {
+public:
+    static const int MAX_LOADED = (2*EVICT_RADIUS+1) * (2*EVICT_RADIUS+1);
+    static const int LOADER_THREADS = 2;
+
+    size_t budgetBytes = 8u << 20;
+
+    // Main-thread hitch and loader statistics
+    struct Stats {
+        int built = 0, installed = 0, evicted = 0, discarded = 0, rebases = 0;
+        double buildMsTotal = 0.0, buildMsMax = 0.0;
+        double updateUsTotal = 0.0, updateUsMax = 0.0;
+        int updates = 0;
+        size_t peakBytes = 0;
+    };
+
+    ~WorldStreamer(){
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for(auto& t : loaders) t.join();
+        for(WorldChunk* c : loaded) delete c;
+        for(WorldChunk* c : finished) delete c;
+        for(WorldChunk* c : retired) delete c;
+    }
+
+    // Spawns the loader threads and waits until they are running; call once at startup so
+    // no frame pays for thread creation
+    void start(){
+        if(!loaders.empty()) return;
+        loaded.reserve(MAX_LOADED);
+        finished.reserve(MAX_LOADED);
+        retired.reserve(2*MAX_LOADED);
+        queue.reserve(MAX_LOADED);
+        inFlight.reserve(LOADER_THREADS);
+        for(int dz=-LOAD_RADIUS; dz<=LOAD_RADIUS; dz++) for(int dx=-LOAD_RADIUS; dx<=LOAD_RADIUS; dx++) ringOffsets.push_back({dx, dz});
+        std::stable_sort(ringOffsets.begin(), ringOffsets.end(), [](const ChunkKey& a, const ChunkKey& b){
+            return a.cx*a.cx + a.cz*a.cz < b.cx*b.cx + b.cz*b.cz;
+        });
+        for(int i=0;i<LOADER_THREADS;i++) loaders.emplace_back(&WorldStreamer::loaderLoop, this);
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&]{ return startedLoaders == LOADER_THREADS; });
+    }
+
+    // Called once per frame on the main thread after start(); may move the origin (and the player with it)
+    void update(Vec3& player){
+        auto t0 = std::chrono::steady_clock::now();
+        rebase(player);
+        int pcx = chunkCoordOf(originChunkX, player.x), pcz = chunkCoordOf(originChunkZ, player.z);
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            for(WorldChunk* c : finished){
+                if(chunkDistance(c, pcx, pcz) > EVICT_RADIUS || find(c->cx, c->cz) || (int)loaded.size() >= MAX_LOADED){
+                    retired.push_back(c); stats.discarded++;
+                    continue;
+                }
+                loaded.push_back(c);
+                loadedBytes += c->bytes();
+                stats.installed++;
+            }
+            finished.clear();
+
+            // Evict out-of-range chunks, then the farthest ones while over budget (never the 3x3 around the player)
+            for(size_t i=0;i<loaded.size();){
+                if(chunkDistance(loaded[i], pcx, pcz) > EVICT_RADIUS) evict(i); else i++;
+            }
+            while(loadedBytes > budgetBytes){
+                int far = -1, farDist = 1;
+                for(size_t i=0;i<loaded.size();i++){
+                    int d = chunkDistance(loaded[i], pcx, pcz);
+                    if(d > farDist){ farDist = d; far = (int)i; }
+                }
+                if(far < 0) break;
+                evict((size_t)far);
+            }
+
+            // Re-queue what is still missing, nearest first, while the budget has room for it
+            queue.clear();
+            queueHead = 0;
+            size_t projected = loadedBytes + inFlight.size() * averageChunkBytes();
+            for(const ChunkKey& o : ringOffsets){
+                int cx = pcx + o.cx, cz = pcz + o.cz;
+                if(isCourtyardChunk(cx, cz) || find(cx, cz) || isInFlight(cx, cz)) continue;
+                if(projected + averageChunkBytes() > budgetBytes) break;
+                projected += averageChunkBytes();
+                queue.push_back({cx, cz});
+            }
+            stats.peakBytes = std::max(stats.peakBytes, loadedBytes);
+            wake = !queue.empty() || !retired.empty(); // loaders pop retired under m
+        }
+        if(wake) cv.notify_all();
+
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        stats.updateUsTotal += us;
+        stats.updateUsMax = std::max(stats.updateUsMax, us);
+        stats.updates++;
+    }
+
+    // The chunk must be loaded for the player to stand on streamed ground
+    bool isLoaded(int cx, int cz) const { return isCourtyardChunk(cx, cz) || find(cx, cz) != nullptr; }
+
+    // Calls pred(box) for each streamed solid overlapping box (both in local coordinates) until it returns true
+    template<class Pred>
+    bool overlapSolids(const AABB& box, const Pred& pred) const {
+        const float cell = CHUNK_SIZE / CHUNK_GRID;
+        int cx0 = chunkCoordOf(originChunkX, box.center.x - box.half.x), cx1 = chunkCoordOf(originChunkX, box.center.x + box.half.x);
+        int cz0 = chunkCoordOf(originChunkZ, box.center.z - box.half.z), cz1 = chunkCoordOf(originChunkZ, box.center.z + box.half.z);
+        for(int cz=cz0;cz<=cz1;cz++) for(int cx=cx0;cx<=cx1;cx++){
+            const WorldChunk* c = find(cx, cz);
+            if(!c || c->solids.empty()) continue;
+            Vec3 off = chunkOffset(cx, cz);
+            int x0 = std::max(0, (int)std::floor((box.center.x - box.half.x - off.x) / cell));
+            int x1 = std::min(CHUNK_GRID-1, (int)std::floor((box.center.x + box.half.x - off.x) / cell));
+            int z0 = std::max(0, (int)std::floor((box.center.z - box.half.z - off.z) / cell));
+            int z1 = std::min(CHUNK_GRID-1, (int)std::floor((box.center.z + box.half.z - off.z) / cell));
+            for(int z=z0;z<=z1;z++) for(int x=x0;x<=x1;x++){
+                int k = z*CHUNK_GRID + x;
+                for(int j=c->cellStart[k]; j<c->cellStart[k+1]; j++){
+                    const AABB& s = c->solids[c->cellItems[j]];
+                    AABB w = { add(s.center, off), s.half };
+                    if(aabbIntersects(box, w) && pred(w)) return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool overlapsGround(const AABB& box) const {
+        int cx0 = chunkCoordOf(originChunkX, box.center.x - box.half.x), cx1 = chunkCoordOf(originChunkX, box.center.x + box.half.x);
+        int cz0 = chunkCoordOf(originChunkZ, box.center.z - box.half.z), cz1 = chunkCoordOf(originChunkZ, box.center.z + box.half.z);
+        for(int cz=cz0;cz<=cz1;cz++) for(int cx=cx0;cx<=cx1;cx++){
+            if(!find(cx, cz)) continue;
+            AABB g = CHUNK_GROUND;
+            g.center = add(g.center, chunkOffset(cx, cz));
+            if(aabbIntersects(box, g)) return true;
+        }
+        return false;
+    }
+
+    void draw() const {
+        for(const WorldChunk* c : loaded) submit(c);
+    }
+
+    // Chunk-by-chunk access for callers that cull; i < loadedCount()
+    AABB chunkBounds(int i) const {
+        const WorldChunk* c = loaded[i];
+        Vec3 off = chunkOffset(c->cx, c->cz);
+        return {{off.x + CHUNK_SIZE*0.5f, CHUNK_TOP*0.5f, off.z + CHUNK_SIZE*0.5f}, {CHUNK_SIZE*0.5f, CHUNK_TOP*0.5f + 0.5f, CHUNK_SIZE*0.5f}};
+    }
+    void drawChunk(int i) const { submit(loaded[i]); }
+
+    size_t bytes() const { return loadedBytes; }
+    int loadedCount() const { return (int)loaded.size(); }
+    Stats statistics(){ std::lock_guard<std::mutex> lock(m); return stats; }
+
+private:
+    struct ChunkKey { int cx, cz; };
+
+    static void submit(const WorldChunk* c){
+        Vec3 off = chunkOffset(c->cx, c->cz);
+        gfx->pushMatrix();
+        gfx->translate(off.x, off.y, off.z);
+        // A chunk's contents depend only on its coordinates
+        uint64_t id = RETAIN_CHUNK | ((uint64_t)(uint32_t)c->cx << 32) | (uint32_t)c->cz;
+        if(gfx->beginRetained(id)){
+            gfx->drawArrays(DRAW_TRIANGLES, (int)c->verts.size(), &c->verts[0].x, sizeof(ChunkVertex), &c->verts[0].rgba, sizeof(ChunkVertex));
+            gfx->endRetained();
+        }
+        gfx->popMatrix();
+    }
+
+    // Whole-chunk origin moves; the player and the free camera move back by the same amount
+    void rebase(Vec3& player){
+        int pcx = chunkCoordOf(originChunkX, player.x), pcz = chunkCoordOf(originChunkZ, player.z);
+        int ox = originChunkX, oz = originChunkZ;
+        if(!originAtHome()){
+            float ax = (pcx + 0.5f) * CHUNK_SIZE, az = (pcz + 0.5f) * CHUNK_SIZE;
+            if(ax*ax + az*az < REHOME_DISTANCE*REHOME_DISTANCE){ ox = 0; oz = 0; }
+        }
+        if(ox==originChunkX && oz==originChunkZ && (std::fabs(player.x) > REBASE_DISTANCE || std::fabs(player.z) > REBASE_DISTANCE)){
+            ox = pcx; oz = pcz;
+        }
+        if(ox==originChunkX && oz==originChunkZ) return;
+        Vec3 shift = { (originChunkX - ox) * CHUNK_SIZE, 0.0f, (originChunkZ - oz) * CHUNK_SIZE };
+        player = add(player, shift);
+        camPos = add(camPos, shift);
+        camTarget = add(camTarget, shift);
+        originChunkX = ox; originChunkZ = oz;
+        stats.rebases++;
+    }
+
+    void loaderLoop(){
+        // A throwaway build sets up this thread's allocator arena and stack while start() waits,
+        // instead of on the first frame that queues chunks
+        delete buildChunk(LOAD_RADIUS + 1, LOAD_RADIUS + 1);
+        { std::lock_guard<std::mutex> lock(m); startedLoaders++; }
+        cv.notify_all();
+        for(;;){
+            ChunkKey key;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&]{ return stopping || queueHead < queue.size() || !retired.empty(); });
+                if(stopping) return;
+                if(!retired.empty()){ // freeing is left to the loaders as well
+                    WorldChunk* c = retired.back();
+                    retired.pop_back();
+                    lock.unlock();
+                    delete c;
+                    continue;
+                }
+                key = queue[queueHead++];
+                inFlight.push_back(key);
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            WorldChunk* c = buildChunk(key.cx, key.cz);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            std::lock_guard<std::mutex> lock(m);
+            for(size_t i=0;i<inFlight.size();i++) if(inFlight[i].cx==key.cx && inFlight[i].cz==key.cz){ inFlight.erase(inFlight.begin() + i); break; }
+            finished.push_back(c);
+            stats.built++;
+            stats.buildMsTotal += ms;
+            stats.buildMsMax = std::max(stats.buildMsMax, ms);
+            builtBytes += c->bytes();
+        }
+    }
+
+    const WorldChunk* find(int cx, int cz) const {
+        for(const WorldChunk* c : loaded) if(c->cx==cx && c->cz==cz) return c;
+        return nullptr;
+    }
+    bool isInFlight(int cx, int cz) const {
+        for(const ChunkKey& k : inFlight) if(k.cx==cx && k.cz==cz) return true;
+        return false;
+    }
+    static int chunkDistance(const WorldChunk* c, int cx, int cz){ return std::max(std::abs(c->cx - cx), std::abs(c->cz - cz)); }
+    size_t averageChunkBytes() const { return stats.built ? builtBytes / stats.built : 32u << 10; }
+
+    void evict(size_t i){
+        loadedBytes -= loaded[i]->bytes();
+        retired.push_back(loaded[i]);
+        loaded[i] = loaded.back();
+        loaded.pop_back();
+        stats.evicted++;
+    }
+
+    std::vector<WorldChunk*> loaded;   // main thread only
+    size_t loadedBytes = 0;
+    std::vector<ChunkKey> ringOffsets;
+    std::vector<std::thread> loaders;
+    std::mutex m;                      // guards everything below
+    std::condition_variable cv;
+    std::vector<ChunkKey> queue, inFlight;
+    size_t queueHead = 0;
+    std::vector<WorldChunk*> finished, retired;
+    size_t builtBytes = 0;
+    Stats stats;
+    int startedLoaders = 0;
+    bool stopping = false;
+};
+
+static WorldStreamer worldStreamer;
+
+// --------------------------- Update LOD ---------------------------
+// Moving obstacles and the animation of sky oracles and features don't need advancing
+// every tick when nobody can see or touch them. Each tick an entity gets an update period
+// from its distance to the player and whether it is in one of the views last drawn:
+// gameplay entities near the player run every tick, visible ones every tick (every second
+// tick when far), hidden ones every 4th (8th when far). Entities of the same period are
+// spread round-robin over the ticks by their index. Everything scheduled is closed-form in
+// a clock, so an update evaluates it at the current time and skipped ticks never drift.
+// Six clip planes (a,b,c,d; inside is positive), unnormalised since only signs are compared
+struct Frustum {
+    float plane[6][4];
+
+    // Gribb/Hartmann: each plane is row 4 of projection*modelview plus or minus row 1, 2 or 3
+    void fromCurrentMatrices(){
+        Mat4 p, mv;
+        gfx->projection(p.m);
+        gfx->modelview(mv.m);
+        Mat4 mvp = mat4Mul(p, mv);
+        const float* m = mvp.m;
+        for(int i=0;i<3;i++) for(int side=0;side<2;side++){
+            float sign = side ? -1.0f : 1.0f;
+            for(int j=0;j<4;j++) plane[i*2+side][j] = m[j*4+3] + sign*m[j*4+i];
+        }
+    }
+
+    bool intersects(const AABB& b) const {
+        for(int i=0;i<6;i++){
+            const float* pl = plane[i];
+            float d = pl[0]*b.center.x + pl[1]*b.center.y + pl[2]*b.center.z + pl[3];
+            float r = std::fabs(pl[0])*b.half.x + std::fabs(pl[1])*b.half.y + std::fabs(pl[2])*b.half.z;
+            if(d + r < 0.0f) return false;
+        }
+        return true;
+    }
+};
+
+class UpdateScheduler {
+public:
+    static const int MAX_VIEWS = 4;
+    static constexpr float NEAR_RADIUS = 12.0f;  // gameplay entities always run at full rate inside this
+    static constexpr float FAR_RADIUS = 40.0f;
+    static constexpr float VIEW_MARGIN = 2.0f;   // bounds are grown so entities wake just before they come into view
+
+    uint32_t tick = 0; // round-robin position; part of the snapshot
+
+    // The renderer reports the views it drew; until it does (headless runs) everything counts as visible
+    void clearViews(){ views = 0; viewsKnown = true; }
+    void addView(const Frustum& f){ if(views < MAX_VIEWS) view[views++] = f; }
+
+    int period(const AABB& bounds, bool gameplay) const {
+        float dx = std::max(0.0f, std::fabs(playerPos.x - bounds.center.x) - bounds.half.x);
+        float dy = std::max(0.0f, std::fabs(playerPos.y - bounds.center.y) - bounds.half.y);
+        float dz = std::max(0.0f, std::fabs(playerPos.z - bounds.center.z) - bounds.half.z);
+        float d2 = dx*dx + dy*dy + dz*dz;
+        if(gameplay && d2 < NEAR_RADIUS*NEAR_RADIUS) return 1;
+        bool far = d2 >= FAR_RADIUS*FAR_RADIUS;
+        if(visible(bounds)) return far ? 2 : 1;
+        return far ? 8 : 4;
+    }
+
+    bool due(int index, const AABB& bounds, bool gameplay){
+        int p = period(bounds, gameplay);
+        bool run = (tick + (uint32_t)index) % (uint32_t)p == 0;
+        (run ? updated : skipped)++;
+        return run;
+    }
+
+    // Marks the animation blocks due this tick; call before the tick's updates
+    void scheduleAnimation(){
+        updated = skipped = 0;
+        for(int i=0;i<4;i++){
+            const FeatureObj& f = features[i];
+            AABB b = f.box; b.half = add(b.half, {1.5f, 2.5f, 1.5f}); // animation and halo reach
+            animTracks.setDue(f.animBlock, due(i, b, false));
+        }
+        for(size_t i=0;i<skyOracles.size();i++){
+            const SkyOracle& o = skyOracles[i];
+            float r = o.radius + 0.6f; // bob amplitude
+            animTracks.setDue(o.animBlock, due((int)i, {o.pos, {r, r, r}}, false));
+        }
+    }
+
+    void endTick(){ tick++; }
+
+    int updatedLastTick() const { return updated; }
+    int skippedLastTick() const { return skipped; }
+
+private:
+    bool visible(const AABB& b) const {
+        if(!viewsKnown) return true;
+        AABB grown = b;
+        grown.half = add(b.half, {VIEW_MARGIN, VIEW_MARGIN, VIEW_MARGIN});
+        for(int v=0;v<views;v++) if(view[v].intersects(grown)) return true;
+        return false;
+    }
+
+    Frustum view[MAX_VIEWS];
+    int views = 0;
+    bool viewsKnown = false;
+    int updated = 0, skipped = 0;
+};
+
+static UpdateScheduler updateLod;
+
+// --------------------------- Scene setup ---------------------------
+static void resetGame(){
+    playerPos = {0.0f, 1.0f, 0.0f};
+    originChunkX = originChunkZ = 0;
+    playerDir = {0.0f, 0.0f, -1.0f};
+    playerYawDeg = 0.0f;
+    playerVelY = 0.0f;
+    playerOnGround = true;
+    camPos = {0.0f, 18.0f, 28.0f};
+    camTarget = {0.0f, 0.0f, 0.0f};
+    camUp = {0.0f, 1.0f, 0.0f};
+    camMode = CAM_FOLLOW;
+    gameTime = 120.0f;
+    gameState = PLAYING;
+    gameTimers.reset(0, 0.0);
+    obstacleClock = 0.0f;
+    updateLod.tick = 0;
+    timeUpTick = (uint64_t)(gameTime / TIMER_TICK_SECONDS + 0.5);
+    armGameTimers();
+    
+    particles.clear();
+
+    // Reset audio
+    if(audioBgm.loaded) playAudio(audioBgm);
+
+    // Level containers are re-carved from the start of the level arena, so a restart
+    // reuses the memory of the previous run
+    levelArena.reset();
+    walls.attach(levelArena, 4);
+    obstacles.attach(levelArena, 16);
+    collectibles.attach(levelArena, 16);
+    skyOracles.attach(levelArena, 8);
+
+    // Ground
+    groundBox = {{0.0f, 0.0f, 0.0f}, {WORLD_HALF, 0.2f, WORLD_HALF}};
+
+    // Walls: make U-shape (3 walls)
+    walls.clear();
+    walls.push_back({{0.0f, 2.0f, -WORLD_HALF+1.0f}, {WORLD_HALF, 2.0f, 1.0f}}); // back
+    walls.push_back({{-WORLD_HALF+1.0f, 2.0f, 0.0f}, {1.0f, 2.0f, WORLD_HALF}}); // left
+    walls.push_back({{ WORLD_HALF-1.0f, 2.0f, 0.0f}, {1.0f, 2.0f, WORLD_HALF}}); // right
+
+    // Platforms in four quadrants with different colors, sizes, AND heights for visual distinction
+    platforms[0] = {{ {-20, 0.3f, -20}, {8, 0.3f, 6} }, {0.8f,0.2f,0.2f}}; // red - lowest
+    platforms[1] = {{ { 20, 0.4f, -15}, {6, 0.4f, 8} }, {0.2f,0.6f,0.9f}}; // blue - medium-low
+    platforms[2] = {{ {-18, 0.5f,  20}, {7, 0.5f, 7} }, {0.2f,0.8f,0.3f}}; // green - highest
+    platforms[3] = {{ { 18, 0.35f, 18}, {9, 0.35f, 5} }, {0.9f,0.8f,0.2f}}; // yellow - medium
+
+    // Setup obstacles for each platform to create platformer challenges
+    obstacles.clear();
+
+    // Platform 0 (Red/Torii): Small walls as barriers
+    obstacles.push_back({{{-23.0f, 1.5f, -20.0f}, {0.5f, 1.2f, 2.0f}}, {0.6f, 0.15f, 0.15f}, false, 0, 0, {0,0,0}, 0, 0});
+    obstacles.push_back({{{-17.0f, 1.5f, -20.0f}, {0.5f, 1.2f, 2.0f}}, {0.6f, 0.15f, 0.15f}, false, 0, 0, {0,0,0}, 0, 0});
+    obstacles.push_back({{{-20.0f, 1.0f, -17.0f}, {3.0f, 0.7f, 0.5f}}, {0.6f, 0.15f, 0.15f}, false, 0, 0, {0,0,0}, 0, 0});
+
+    // Platform 1 (Blue/Pagoda): Multi-level elevated sections (stairs-like)
+    obstacles.push_back({{{ 17.5f, 1.5f, -15.0f}, {2.0f, 1.2f, 2.5f}}, {0.15f, 0.4f, 0.7f}, false, 0, 0, {0,0,0}, 0, 0});
+    obstacles.push_back({{{ 21.0f, 2.5f, -15.0f}, {2.0f, 2.2f, 2.5f}}, {0.15f, 0.4f, 0.7f}, false, 0, 0, {0,0,0}, 0, 0});
+    obstacles.push_back({{{ 24.0f, 3.5f, -15.0f}, {2.0f, 3.2f, 2.5f}}, {0.15f, 0.4f, 0.7f}, false, 0, 0, {0,0,0}, 0, 0});
+
+    // Platform 2 (Green/Taiko): Moving horizontal obstacles
+    Vec3 moveBase1 = {-18.0f, 1.5f, 18.0f};
+    obstacles.push_back({{moveBase1, {1.5f, 1.2f, 0.5f}}, {0.15f, 0.6f, 0.2f}, true, 3.0f, 4.0f, moveBase1, 0, 0});
+    Vec3 moveBase2 = {-18.0f, 1.5f, 22.0f};
+    obstacles.push_back({{moveBase2, {1.5f, 1.2f, 0.5f}}, {0.15f, 0.6f, 0.2f}, true, 2.5f, 3.5f, moveBase2, 1.5f, 1.5f});
+
+    // Platform 3 (Yellow/Lantern): Mix - elevated sections and static barriers
+    obstacles.push_back({{{ 15.0f, 2.0f, 18.0f}, {2.5f, 1.7f, 2.0f}}, {0.7f, 0.6f, 0.15f}, false, 0, 0, {0,0,0}, 0, 0});
+    obstacles.push_back({{{ 21.0f, 1.2f, 16.0f}, {1.0f, 0.9f, 1.0f}}, {0.7f, 0.6f, 0.15f}, false, 0, 0, {0,0,0}, 0, 0});
+    obstacles.push_back({{{ 18.0f, 1.0f, 21.0f}, {2.0f, 0.7f, 0.5f}}, {0.7f, 0.6f, 0.15f}, false, 0, 0, {0,0,0}, 0, 0});
+
+    // Feature objects centered on each platform
+    // Red oracle - on ground
+    features[0].box.center = {platforms[0].box.center.x, 0.0f, platforms[0].box.center.z};
+    features[0].box.half = {1.6f,2.6f,1.0f};
+    features[0].baseColor[0] = 0.8f; features[0].baseColor[1] = 0.15f; features[0].baseColor[2] = 0.15f;
+    features[0].type = ANIM_ROTATE;
+    features[0].allCollected = false;
+    features[0].animEnabled = false;
+    features[0].t = 0.0f;
+
+    // Blue oracle - floating 3 units above ground
+    features[1].box.center = {platforms[1].box.center.x, 3.0f, platforms[1].box.center.z};
+    features[1].box.half = {1.6f,2.6f,1.6f};
+    features[1].baseColor[0] = 0.7f; features[1].baseColor[1] = 0.4f; features[1].baseColor[2] = 0.9f;
+    features[1].type = ANIM_SCALE;
+    features[1].allCollected = false;
+    features[1].animEnabled = false;
+    features[1].t = 0.0f;
+
+    // Green oracle - floating 2.5 units above ground
+    features[2].box.center = {platforms[2].box.center.x, 2.5f, platforms[2].box.center.z};
+    features[2].box.half = {1.6f,2.0f,1.6f};
+    features[2].baseColor[0] = 0.9f; features[2].baseColor[1] = 0.3f; features[2].baseColor[2] = 0.3f;
+    features[2].type = ANIM_TRANSLATE;
+    features[2].allCollected = false;
+    features[2].animEnabled = false;
+    features[2].t = 0.0f;
+
+    // Yellow oracle - floating 3.5 units above ground
+    features[3].box.center = {platforms[3].box.center.x, 3.5f, platforms[3].box.center.z};
+    features[3].box.half = {1.6f,2.2f,1.6f};
+    features[3].baseColor[0] = 0.6f; features[3].baseColor[1] = 0.6f; features[3].baseColor[2] = 0.7f;
+    features[3].type = ANIM_COLOR;
+    features[3].allCollected = false;
+    features[3].animEnabled = false;
+    features[3].t = 0.0f;
+
+    // Collectibles: 3 per platform arranged in small triangle pattern
+    collectibles.clear();
+    for(int i=0;i<4;i++){ collectedPerPlatform[i]=0; }
+
+    auto platformSurfaceY = [&](int pi){
+        const Platform& p = platforms[pi];
+        return p.box.center.y + p.box.half.y;
+    };
+
+    auto addCollectible = [&](int pi, float offx, float offz, float heightAboveSurface, float r, float g, float b){
+        const Platform& p = platforms[pi];
+        Vec3 c = {p.box.center.x + offx, platformSurfaceY(pi) + heightAboveSurface, p.box.center.z + offz};
+        Collectible col;
+        col.box = { c, {0.18f, 0.35f, 0.18f} };
+        col.color[0]=r; col.color[1]=g; col.color[2]=b;
+        col.collected=false; col.platformIndex=pi;
+        collectibles.push_back(col);
+    };
+
+    // Red platform - keep as is (accessible)
+    addCollectible(0, -2.0f, -1.5f, 0.25f, 0.9f,0.3f,0.3f);
+    addCollectible(0,  2.2f, -1.2f, 0.65f, 0.9f,0.5f,0.3f);
+    addCollectible(0,  0.0f,  2.0f, 1.2f, 0.9f,0.3f,0.5f);
+
+    // Blue platform - repositioned to avoid stair obstacles
+    addCollectible(1, -4.0f, -5.0f, 0.35f, 0.3f,0.7f,0.9f); // Front left, clear of obstacles
+    addCollectible(1,  4.0f, -5.0f, 1.0f, 0.3f,0.9f,0.7f); // Front right, higher ledge
+    addCollectible(1,  0.0f,  5.0f, 1.6f, 0.5f,0.8f,0.9f); // Back center, atop stairs
+
+    // Green platform - keep as is (accessible)
+    addCollectible(2, -2.0f,  1.4f, 0.35f, 0.2f,0.9f,0.3f);
+    addCollectible(2,  2.0f,  0.0f, 0.7f, 0.2f,0.7f,0.4f);
+    addCollectible(2,  0.0f, -1.8f, 1.2f, 0.2f,0.9f,0.6f);
+
+    // Yellow platform - repositioned to avoid large obstacles
+    addCollectible(3, -7.0f,  0.0f, 0.4f, 0.9f,0.9f,0.3f); // Left edge, clear
+    addCollectible(3,  6.0f,  0.0f, 1.1f, 0.9f,0.8f,0.2f); // Right edge, elevated
+    addCollectible(3,  0.0f, -4.0f, 0.8f, 0.9f,0.7f,0.2f); // Front, mid-height
+
+    // Reset feature gates
+    for(int i=0;i<4;i++){
+        features[i].allCollected=false;
+        features[i].animEnabled=false;
+        features[i].t=0.0f;
+    }
+
+    skyOracles.clear();
+    for(int i=0; i<4; i++){
+        const Platform& p = platforms[i];
+        for(int j=0; j<2; j++){
+            SkyOracle o;
+            float offx = (j==0) ? -3.0f : 3.5f;
+            float offz = (j==0) ? -2.0f : 1.5f;
+            float height = 5.0f + j * 2.0f;
+            o.pos = {p.box.center.x + offx, p.box.center.y + p.box.half.y + height, p.box.center.z + offz};
+            o.radius = 1.5f + j * 0.5f;
+            o.rotation = (float)(rand()%360);
+            o.color[0] = features[i].baseColor[0];
+            o.color[1] = features[i].baseColor[1];
+            o.color[2] = features[i].baseColor[2];
+            skyOracles.push_back(o);
+        }
+    }
+
+    animTracks.clear();
+    for(int i=0;i<4;i++) addFeatureTracks(features[i], CLOCK_FEATURE0 + i);
+    for(auto& o : skyOracles) addSkyOracleTracks(o);
+    updateAnimation(0.0f);
+
+    worldBVH.build();
+    supportMap.build();
+}
+
+// --------------------------- Collision ---------------------------
+// Obstacle boxes are looked up through a functor so the batched environment can evaluate
+// moving obstacles on its own clock; the game itself just reads the live obstacle list.
+template<class ObstacleBoxAt>
+static bool collidesWithLevel(const AABB&box, size_t obstacleCount, const ObstacleBoxAt& obstacleBoxAt){
+    // Against walls
+    for(const auto&w : walls){ if(aabbIntersects(box,w)) return true; }
+    // Against platforms - special handling to allow walking on top
+    for(const auto&p : platforms){
+        // Check if player is standing on top of platform (player's bottom is above or at platform's surface)
+        float playerBottom = box.center.y - box.half.y;
+        float platformTop = p.box.center.y + p.box.half.y;
+
+        // If player's bottom is above the platform surface (with small tolerance),
+        // they're standing on top - don't block horizontal movement
+        const float tolerance = 0.5f; // Allow some overlap for standing on top
+        if(playerBottom >= platformTop - tolerance){
+            continue; // Skip collision check, player is on top
+        }
+
+        // If player is significantly below platform top, check for collision
+        // This handles side collisions and prevents clipping through platforms
+        if(aabbIntersects(box, p.box)) return true;
+    }
+    // Against obstacles - same handling as platforms to allow standing on elevated obstacles
+    for(size_t i=0;i<obstacleCount;i++){
+        const AABB ob = obstacleBoxAt(i);
+        float playerBottom = box.center.y - box.half.y;
+        float obstacleTop = ob.center.y + ob.half.y;
+
+        const float tolerance = 0.5f;
+        if(playerBottom >= obstacleTop - tolerance){
+            continue; // Player is on top of obstacle
+        }
+
+        if(aabbIntersects(box, ob)) return true;
+    }
+    // Against feature objects (platform oracles) - treat as solid; allow standing on top
+    for(const auto& f : features){
+        float playerBottom = box.center.y - box.half.y;
+        float featureTop = f.box.center.y + f.box.half.y;
+        const float tolerance = 0.5f;
+        if(playerBottom >= featureTop - tolerance){
+            continue; // Player is on top of the feature
+        }
+        if(aabbIntersects(box, f.box)) return true;
+    }
+    return false;
+}
+
+// Check if a box rests on ground, a platform or an obstacle
+template<class ObstacleBoxAt>
+static bool isBoxOnSurface(const AABB&box, size_t obstacleCount, const ObstacleBoxAt& obstacleBoxAt){
+    AABB pb = box;
+    // Check a small distance below the box
+    pb.center.y -= 0.1f;
+
+    // Check against ground
+    if(aabbIntersects(pb, groundBox)) return true;
+
+    // Check against platforms
+    for(const auto& p : platforms){
+        if(aabbIntersects(pb, p.box)) return true;
+    }
+
+    // Check against obstacles (for elevated platforms)
+    for(size_t i=0;i<obstacleCount;i++){
+        if(aabbIntersects(pb, obstacleBoxAt(i))) return true;
+    }
+
+    return false;
+}
+
+static AABB liveObstacleBox(size_t i){ return obstacles[i].box; }
+
+// Level queries used by stepPlayerBody. ListLevel scans the level arrays with obstacles
+// supplied by a functor (the batched environment and the nav graph evaluate obstacles on
+// their own clocks); LiveLevel answers the same questions for the live level from worldBVH
+// (collisions) and supportMap (standing).
+template<class ObstacleBoxAt>
+struct ListLevel {
+    size_t obstacleCount;
+    const ObstacleBoxAt& obstacleBoxAt;
+    bool collides(const AABB&box) const { return collidesWithLevel(box, obstacleCount, obstacleBoxAt); }
+    bool onSurface(const AABB&box) const { return isBoxOnSurface(box, obstacleCount, obstacleBoxAt); }
+};
+template<class ObstacleBoxAt>
+static ListLevel<ObstacleBoxAt> listLevel(size_t obstacleCount, const ObstacleBoxAt& obstacleBoxAt){ return { obstacleCount, obstacleBoxAt }; }
+
+// Streamed chunks are answered from their collision grids, their props following the obstacle rule.
+struct LiveLevel {
+    // Same rules as collidesWithLevel: walls always block, anything else only when the box is not resting on its top
+    bool collides(const AABB&box) const {
+        float bottom = box.center.y - box.half.y;
+        if(originAtHome() && worldBVH.overlapBox(box, WP_MASK_SOLID, [bottom](const WorldPrim& p){
+            return p.kind==WP_WALL || bottom < p.box.center.y + p.box.half.y - 0.5f;
+        })) return true;
+        return worldStreamer.overlapSolids(box, [bottom](const AABB& b){ return bottom < b.center.y + b.half.y - 0.5f; });
+    }
+    // Same rule as isBoxOnSurface: something solid (features excepted) within 0.1 below
+    bool onSurface(const AABB&box) const {
+        if(originAtHome() && supportMap.standing(box, true)) return true;
+        AABB probe = box;
+        probe.center.y -= 0.1f;
+        return worldStreamer.overlapsGround(probe) || worldStreamer.overlapSolids(probe, [](const AABB&){ return true; });
+    }
+};
+
+static bool collidesWithWorld(const AABB&box){
+    return LiveLevel().collides(box);
+}
+
+// Player kinematics shared by the interactive game and the batched environment
+struct PlayerBody {
+    Vec3 pos;
+    float velY;
+    float yawDeg;
+    bool onGround;
+};
+
+template<class Level>
+static void stepPlayerBody(PlayerBody&body, Vec3 move, float dt, const Level& level){
+    // Horizontal movement
+    float len = std::sqrt(move.x*move.x + move.z*move.z);
+    if(len>0.0001f){
+        move = mul(move, 1.0f/len);
+        Vec3 delta = mul(move, playerSpeed*dt);
+        // Separate axis resolution to avoid sticking too much
+        AABB pb = { body.pos, playerHalf };
+        Vec3 attempt = body.pos; attempt.x += delta.x;
+        pb.center = attempt; if(!level.collides(pb)) body.pos.x = attempt.x;
+        attempt = body.pos; attempt.z += delta.z;
+        pb.center = attempt; if(!level.collides(pb)) body.pos.z = attempt.z;
+        // face movement direction
+        body.yawDeg = atan2f(move.x, -move.z) * 180.0f / 3.14159265f; // z- forward
+    }
+
+    // Vertical movement (jumping and gravity)
+    body.onGround = level.onSurface({ body.pos, playerHalf });
+
+    // Apply gravity
+    if(!body.onGround){
+        body.velY += GRAVITY * dt;
+    } else {
+        // On ground, reset vertical velocity
+        if(body.velY < 0.0f) body.velY = 0.0f;
+    }
+
+    // Update vertical position
+    float nextY = body.pos.y + body.velY * dt;
+
+    // Check if new position would collide
+    AABB testBox = { body.pos, playerHalf };
+    testBox.center.y = nextY;
+
+    // Only update Y if no collision or moving down to ground
+    if(!level.collides(testBox) || nextY < body.pos.y){
+        body.pos.y = nextY;
+
+        // Clamp to ground level (minimum Y position)
+        if(body.pos.y < 1.0f){
+            body.pos.y = 1.0f;
+            body.velY = 0.0f;
+            body.onGround = true;
+        }
+    } else {
+        // Hit ceiling or obstacle
+        if(body.velY > 0.0f) body.velY = 0.0f;
+    }
+}
+
+// --------------------------- Game logic ---------------------------
+// Pickup detection only; counting, unlocks and the win follow from EVT_COLLECTED (Game events)
+static void updateCollectibles(){
+    AABB pb = { playerPos, playerHalf };
+    for(size_t i=0;i<collectibles.size();i++){
+        Collectible& c = collectibles[i];
+        if(!c.collected && aabbIntersects(pb, c.box)){
+            c.collected = true;
+            particles.emitBurst(c.box.center, c.color, 4000, 8.0f, 1.5f);
+            gameEvents.publish({EVT_COLLECTED, (int)i});
+        }
+    }
+}
+
+static void updateFeatures(float dt){
+    for(int i=0;i<4;i++){
+        if(features[i].animEnabled) features[i].t += dt;
+    }
+}
+
+// --------------------------- Game Over Scene ---------------------------
+static void initFlyingOracles(){
+    for(int i=0; i<4; i++){
+        particles.emitBurst(features[i].box.center, features[i].baseColor, 25000, 14.0f, 4.0f);
+        flyingOracles[i].pos = features[i].box.center;
+        float vx = (rand()%200 - 100) / 20.0f;
+        float vy = (rand()%100 + 50) / 20.0f;
+        float vz = (rand()%200 - 100) / 20.0f;
+        flyingOracles[i].vel = {vx, vy, vz};
+        flyingOracles[i].rotation = 0.0f;
+        flyingOracles[i].spin = 180.0f;
+        flyingOracles[i].color[0] = features[i].baseColor[0];
         flyingOracles[i].color[1] = features[i].baseColor[1];
         flyingOracles[i].color[2] = features[i].baseColor[2];
     }
 }
 
-static void updateFlyingOracles(float dt){
-    const float gravity = -9.8f;
-    for(int i=0; i<4; i++){
-        flyingOracles[i].pos.x += flyingOracles[i].vel.x * dt;
-        flyingOracles[i].pos.y += flyingOracles[i].vel.y * dt;
-        flyingOracles[i].pos.z += flyingOracles[i].vel.z * dt;
-        flyingOracles[i].vel.y += gravity * dt;
-        
-        if(flyingOracles[i].pos.y < 0.0f){
-            flyingOracles[i].pos.y = 0.0f;
-            flyingOracles[i].vel.y = -flyingOracles[i].vel.y * 0.7f;
+// The oracles bounce until a bounce is too weak to leave the ground, then lie still
+static void updateFlyingOracles(float dt){
+    const float gravity = -9.8f;
+    for(int i=0; i<4; i++){
+        if(flyingOracles[i].spin == 0.0f) continue;
+        flyingOracles[i].pos.x += flyingOracles[i].vel.x * dt;
+        flyingOracles[i].pos.y += flyingOracles[i].vel.y * dt;
+        flyingOracles[i].pos.z += flyingOracles[i].vel.z * dt;
+        flyingOracles[i].vel.y += gravity * dt;
+        
+        if(flyingOracles[i].pos.y < 0.0f){
+            flyingOracles[i].pos.y = 0.0f;
+            flyingOracles[i].vel.y = -flyingOracles[i].vel.y * 0.7f;
+            if(flyingOracles[i].vel.y < 1.0f){ flyingOracles[i].vel = {0.0f, 0.0f, 0.0f}; flyingOracles[i].spin = 0.0f; }
+        }
+        
+        flyingOracles[i].rotation += flyingOracles[i].spin * dt;
+        if(flyingOracles[i].rotation > 360.0f) flyingOracles[i].rotation -= 360.0f;
+    }
+}
+
+// Moving obstacles slide back and forth on the shared obstacle clock; one that was not due
+// for a few ticks is simply placed at the current time
+static void updateObstacles(float dt){
+    obstacleClock += dt;
+    bool moved = false;
+    for(size_t i=0;i<obstacles.size();i++){
+        Obstacle& obs = obstacles[i];
+        if(!obs.isMoving) continue;
+        AABB sweep = {obs.basePos, {obs.box.half.x + obs.moveRange, obs.box.half.y, obs.box.half.z}};
+        if(!updateLod.due((int)i, sweep, true)) continue;
+        obs.moveTime = obs.movePhase + obstacleClock;
+        // Move horizontally back and forth
+        float offset = sinf(obs.moveTime * obs.moveSpeed) * obs.moveRange;
+        obs.box.center.x = obs.basePos.x + offset;
+        moved = true;
+    }
+    if(moved) worldBVH.refit();
+}
+
+// --bvh-bench [queries]: BVH against a linear scan over the same boxes, checking they agree
+static int runBvhBenchmark(int argc, char** argv){
+    int queries = argc>2 ? std::max(1, atoi(argv[2])) : 200000;
+    resetGame();
+    uint32_t rng = 0x9E3779B9u;
+    auto rnd = [&](float lo, float hi){ rng ^= rng<<13; rng ^= rng>>17; rng ^= rng<<5; return lo + (hi-lo)*((rng>>8) * (1.0f/16777216.0f)); };
+    auto bruteCast = [](const AABB& box, const Vec3& d, float maxDist){
+        float best = maxDist; bool found = false;
+        for(int i=0;i<worldBVH.size();i++){
+            const AABB& b = worldBVH.prim(i).box;
+            float tmin = 0.0f, tmax = best;
+            const float o[3] = {box.center.x, box.center.y, box.center.z}, dd[3] = {d.x, d.y, d.z};
+            const float lo[3] = {b.center.x-b.half.x-box.half.x, b.center.y-b.half.y-box.half.y, b.center.z-b.half.z-box.half.z};
+            const float hi[3] = {b.center.x+b.half.x+box.half.x, b.center.y+b.half.y+box.half.y, b.center.z+b.half.z+box.half.z};
+            bool miss = false;
+            for(int a=0;a<3 && !miss;a++){
+                if(dd[a]==0.0f){ miss = o[a]<lo[a] || o[a]>hi[a]; continue; }
+                float t1 = (lo[a]-o[a])/dd[a], t2 = (hi[a]-o[a])/dd[a];
+                tmin = std::max(tmin, std::min(t1,t2)); tmax = std::min(tmax, std::max(t1,t2));
+                miss = tmax < tmin;
+            }
+            if(!miss){ best = tmin; found = true; }
+        }
+        return found ? best : -1.0f;
+    };
+
+    std::vector<AABB> boxes(queries);
+    std::vector<Vec3> dirs(queries);
+    for(int q=0;q<queries;q++){
+        float h = (q & 1) ? rnd(0.0f, 0.6f) : 0.0f; // alternate rays and box casts
+        boxes[q] = {{rnd(-WORLD_HALF, WORLD_HALF), rnd(0.2f, 12.0f), rnd(-WORLD_HALF, WORLD_HALF)}, {h, h, h}};
+        Vec3 d = {rnd(-1,1), rnd(-1,0.3f), rnd(-1,1)};
+        float len = std::sqrt(d.x*d.x + d.y*d.y + d.z*d.z);
+        dirs[q] = len>1e-3f ? mul(d, 1.0f/len) : Vec3{0,-1,0};
+    }
+
+    int mismatches = 0, hits = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(int q=0;q<queries;q++){
+        CastHit hit;
+        if(worldBVH.castBox(boxes[q], dirs[q], 60.0f, WP_MASK_ALL, &hit)) hits++;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    float sink = 0.0f;
+    for(int q=0;q<queries;q++) sink += bruteCast(boxes[q], dirs[q], 60.0f);
+    auto t2 = std::chrono::steady_clock::now();
+    for(int q=0;q<queries;q++){
+        CastHit hit;
+        float a = worldBVH.castBox(boxes[q], dirs[q], 60.0f, WP_MASK_ALL, &hit) ? hit.t : -1.0f;
+        if(std::abs(a - bruteCast(boxes[q], dirs[q], 60.0f)) > 1e-4f) mismatches++;
+    }
+
+    // Collision queries must give exactly what the linear scan gives
+    int levelMismatches = 0;
+    for(int q=0;q<queries;q++){
+        if(q % 64 == 0) updateObstacles(1.0f/60.0f);
+        AABB pb = {boxes[q].center, playerHalf};
+        if(LiveLevel().collides(pb) != collidesWithLevel(pb, obstacles.size(), liveObstacleBox)) levelMismatches++;
+        if(LiveLevel().onSurface(pb) != isBoxOnSurface(pb, obstacles.size(), liveObstacleBox)) levelMismatches++;
+    }
+
+    // Standing queries: support map against the scan, at heights where surfaces are within reach
+    for(int q=0;q<queries;q++) boxes[q] = {{boxes[q].center.x, rnd(1.0f, 8.0f), boxes[q].center.z}, playerHalf};
+    int mapStanding = 0, scanStanding = 0;
+    auto t3 = std::chrono::steady_clock::now();
+    for(int q=0;q<queries;q++) mapStanding += supportMap.standing(boxes[q], true);
+    auto t4 = std::chrono::steady_clock::now();
+    for(int q=0;q<queries;q++) scanStanding += isBoxOnSurface(boxes[q], obstacles.size(), liveObstacleBox);
+    auto t5 = std::chrono::steady_clock::now();
+    for(int q=0;q<queries;q++)
+        if(supportMap.standing(boxes[q], true) != isBoxOnSurface(boxes[q], obstacles.size(), liveObstacleBox)) levelMismatches++;
+
+    double bvhUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / queries;
+    double scanUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / queries;
+    std::printf("[bvh] %d boxes, %d casts (%d hit): bvh %.3f us/cast, linear %.3f us/cast (checksum %.1f)\n",
+        worldBVH.size(), queries, hits, bvhUs, scanUs, sink);
+    std::printf("[bvh] support map (%d cells, %d entries): standing %.3f us/query, linear %.3f us/query (%d/%d standing)\n",
+        supportMap.cellCount(), supportMap.entryTotal(),
+        std::chrono::duration<double, std::micro>(t4 - t3).count() / queries, std::chrono::duration<double, std::micro>(t5 - t4).count() / queries,
+        mapStanding, scanStanding);
+    std::printf("[bvh] cast mismatches %d, collision/surface mismatches %d\n", mismatches, levelMismatches);
+    return (mismatches || levelMismatches) ? 1 : 0;
+}
+
+// --------------------------- Game events ---------------------------
+static void onCollected(const GameEvent& e){
+    int platform = collectibles[e.arg].platformIndex;
+    playAudio(audioCollect);
+    if(++collectedPerPlatform[platform] == totalCollectiblesPerPlatform) gameEvents.publish({EVT_PLATFORM_COMPLETE, platform});
+}
+
+static void onPlatformComplete(const GameEvent& e){
+    features[e.arg].allCollected = true; // Animation unlocked
+    features[e.arg].animEnabled = true;  // Auto-start animation!
+    for(int i=0;i<4;i++) if(collectedPerPlatform[i] < totalCollectiblesPerPlatform) return;
+    if(gameState == PLAYING) gameEvents.publish({EVT_GAME_WON, 0});
+}
+
+static void onGameWon(const GameEvent&){
+    gameState = WON;
+    gameTimers.cancel(timeUpTimer); // the countdown stops
+    timeUpTimer = 0;
+    playAudio(audioWin);
+}
+
+static void onTimeUp(const GameEvent&){
+    timeUpTimer = 0;
+    gameTime = 0.0f;
+    gameState = LOST;
+    playAudio(audioLose);
+    initFlyingOracles();
+}
+
+// Once at startup, before any mode runs the simulation
+static void subscribeGameEvents(){
+    gameEvents.subscribe(EVT_COLLECTED, onCollected);
+    gameEvents.subscribe(EVT_PLATFORM_COMPLETE, onPlatformComplete);
+    gameEvents.subscribe(EVT_GAME_WON, onGameWon);
+    gameEvents.subscribe(EVT_TIME_UP, onTimeUp);
+}
+
+// --timer-bench [timers]: the wheel against polling every deadline each tick, checking
+// that every timer fires on exactly its tick and cancelled ones never do
+static int runTimerBenchmark(int argc, char** argv){
+    int count = argc>2 ? std::max(1, std::min(atoi(argv[2]), 0xFFFF)) : 20000;
+    const float dt = 1.0f / 60.0f;
+    const double horizon = 300.0;
+    uint32_t rng = 0x2545F491u;
+    auto rnd = [&](double lo, double hi){ rng ^= rng<<13; rng ^= rng>>17; rng ^= rng<<5; return lo + (hi-lo)*((rng>>8) * (1.0/16777216.0)); };
+
+    static TimerWheel* wheel;
+    static std::vector<uint64_t> deadline; // UINT64_MAX once fired or cancelled
+    static int fired, wrongTick;
+    TimerWheel w(count);
+    wheel = &w;
+    deadline.resize(count);
+    fired = wrongTick = 0;
+    EventBus bus;
+    bus.subscribe(EVT_TIME_UP, [](const GameEvent& e){
+        if(deadline[e.arg] != wheel->now()) wrongTick++;
+        deadline[e.arg] = UINT64_MAX;
+        fired++;
+    });
+
+    std::vector<TimerHandle> handles(count);
+    for(int i=0;i<count;i++) deadline[i] = (uint64_t)std::ceil(rnd(0.001, horizon) / TIMER_TICK_SECONDS);
+    auto t0 = std::chrono::steady_clock::now();
+    for(int i=0;i<count;i++) handles[i] = w.scheduleAt(deadline[i], {EVT_TIME_UP, i});
+    double scheduleNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / count;
+    std::vector<uint64_t> polled(deadline); // the same deadlines, found by scanning instead
+
+    int cancelled = 0;
+    for(int i=0;i<count;i+=4){
+        if(!w.cancel(handles[i]) || w.cancel(handles[i])) wrongTick++; // second cancel must be refused
+        deadline[i] = polled[i] = UINT64_MAX;
+        cancelled++;
+    }
+
+    int ticks = (int)((horizon + 1.0) / dt);
+    t0 = std::chrono::steady_clock::now();
+    for(int t=0;t<ticks;t++) w.advance(dt, bus);
+    double wheelUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / ticks;
+
+    int polledFired = 0;
+    double clock = 0.0;
+    t0 = std::chrono::steady_clock::now();
+    for(int t=0;t<ticks;t++){
+        clock += dt / TIMER_TICK_SECONDS;
+        for(uint64_t& d : polled) if((double)d <= clock){ d = UINT64_MAX; polledFired++; }
+    }
+    double pollUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / ticks;
+
+    int missing = 0;
+    for(uint64_t d : deadline) if(d != UINT64_MAX) missing++;
+    std::printf("[timers] %d timers over %.0f s, %d cancelled: schedule %.1f ns each, advance %.2f us/tick vs. polling %.2f us/tick\n",
+        count, horizon, cancelled, scheduleNs, wheelUs, pollUs);
+    std::printf("[timers] fired %d (polling found %d), on the wrong tick %d, never fired %d, still pending %d\n",
+        fired, polledFired, wrongTick, missing, w.pending());
+    bool ok = fired == count - cancelled && polledFired == fired && wrongTick == 0 && missing == 0 && w.pending() == 0;
+    std::printf("[timers] %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// --------------------------- Batched environment ---------------------------
+// Headless multi-instance version of the game for bot training and level tuning.
+// The level layout (walls, platforms, features, obstacle tracks, collectible slots) is
+// built once by resetGame() and shared read-only; each instance only carries the state
+// that the rules mutate, packed into one contiguous array so step() streams through it.
+enum EnvActionBits : uint8_t {
+    ACT_FORWARD = 1, ACT_BACK = 2, ACT_LEFT = 4, ACT_RIGHT = 8, ACT_JUMP = 16
+};
+
+struct EnvObservation {
+    Vec3 playerPos;
+    int collectiblesRemaining;
+    float timeLeft;
+};
+
+struct EnvInstance {
+    PlayerBody body;
+    GameState state;
+    float gameTime;
+    float obstacleTime;     // shared clock for all moving obstacles of this instance
+    int collectedCount;     // set bits in this instance's row of BatchedEnv::collectedBits
+    int collectedPerPlatform[4];
+};
+
+class BatchedEnv {
+public:
+    static constexpr float STEP_DT = 1.0f / 60.0f;
+
+    // Snapshots the current level; call after resetGame().
+    explicit BatchedEnv(int instanceCount)
+        : instances(instanceCount), observations(instanceCount), rewards(instanceCount), dones(instanceCount),
+          obstacleTrack(obstacles.begin(), obstacles.end()), slots(collectibles.begin(), collectibles.end()),
+          maskWords((slots.size() + 31) / 32), collectedBits((size_t)instanceCount * maskWords) {}
+
+    int size() const { return (int)instances.size(); }
+    const std::vector<EnvObservation>& lastObservations() const { return observations; }
+    const std::vector<float>& lastRewards() const { return rewards; }
+    const std::vector<uint8_t>& lastDones() const { return dones; }
+    double stepsPerSecond() const { return stepSeconds>0.0 ? (double)stepCount*instances.size()/stepSeconds : 0.0; }
+
+    const std::vector<EnvObservation>& reset(){
+        for(int i=0;i<size();i++){ resetInstance(i); observe(i); rewards[i]=0.0f; dones[i]=0; }
+        return observations;
+    }
+
+    // Advances every instance by STEP_DT; finished instances restart on their next step.
+    const std::vector<EnvObservation>& step(const uint8_t* actions){
+        auto start = std::chrono::steady_clock::now();
+        auto kernel = [&](int begin, int end){
+            for(int i=begin;i<end;i++) stepInstance(i, actions[i]);
+        };
+        workerPool().parallelFor(size(), 256, kernel);
+        stepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stepCount++;
+        return observations;
+    }
+
+private:
+    AABB obstacleBoxAt(size_t i, float t) const {
+        const Obstacle& o = obstacleTrack[i];
+        if(!o.isMoving) return o.box;
+        AABB b = o.box;
+        b.center.x = o.basePos.x + sinf((o.moveTime + t) * o.moveSpeed) * o.moveRange;
+        return b;
+    }
+
+    void resetInstance(int i){
+        EnvInstance& e = instances[i];
+        e.body = { {0.0f, 1.0f, 0.0f}, 0.0f, 0.0f, true };
+        e.state = PLAYING;
+        e.gameTime = 120.0f;
+        e.obstacleTime = 0.0f;
+        e.collectedCount = 0;
+        std::fill_n(collectedBits.begin() + (size_t)i * maskWords, maskWords, 0u);
+        for(int p=0;p<4;p++) e.collectedPerPlatform[p] = 0;
+    }
+
+    void observe(int i){
+        const EnvInstance& e = instances[i];
+        observations[i] = { e.body.pos, (int)slots.size() - e.collectedCount, e.gameTime };
+    }
+
+    void stepInstance(int i, uint8_t action){
+        EnvInstance& e = instances[i];
+        float reward = 0.0f;
+        if(e.state != PLAYING) resetInstance(i);
+
+        e.gameTime -= STEP_DT;
+        e.obstacleTime += STEP_DT;
+
+        Vec3 move = {0,0,0};
+        if(action & ACT_FORWARD) move.z -= 1;
+        if(action & ACT_BACK)    move.z += 1;
+        if(action & ACT_LEFT)    move.x -= 1;
+        if(action & ACT_RIGHT)   move.x += 1;
+        if((action & ACT_JUMP) && e.body.onGround){
+            e.body.velY = JUMP_VELOCITY;
+            e.body.onGround = false;
+        }
+        const float t = e.obstacleTime;
+        auto trackBox = [&](size_t k){ return obstacleBoxAt(k, t); };
+        stepPlayerBody(e.body, move, STEP_DT, listLevel(obstacleTrack.size(), trackBox));
+
+        AABB pb = { e.body.pos, playerHalf };
+        int completedCount = 0;
+        uint32_t* collected = collectedBits.data() + (size_t)i * maskWords;
+        for(size_t k=0;k<slots.size();k++){
+            uint32_t bit = 1u << (k & 31);
+            if(!(collected[k >> 5] & bit) && aabbIntersects(pb, slots[k].box)){
+                collected[k >> 5] |= bit;
+                e.collectedCount++;
+                e.collectedPerPlatform[slots[k].platformIndex]++;
+                reward += 1.0f;
+            }
+        }
+        for(int p=0;p<4;p++) if(e.collectedPerPlatform[p] >= totalCollectiblesPerPlatform) completedCount++;
+
+        if(completedCount==4){ e.state = WON; reward += 10.0f; }
+        else if(e.gameTime<=0.0f){ e.gameTime = 0.0f; e.state = LOST; reward -= 1.0f; }
+
+        rewards[i] = reward;
+        dones[i] = e.state != PLAYING;
+        observe(i);
+    }
+
+    std::vector<EnvInstance> instances;
+    std::vector<EnvObservation> observations;
+    std::vector<float> rewards;
+    std::vector<uint8_t> dones;
+    std::vector<Obstacle> obstacleTrack; // obstacle layout at reset time
+    std::vector<Collectible> slots;      // collectible layout at reset time
+    size_t maskWords;                    // 32-bit words per instance in collectedBits
+    std::vector<uint32_t> collectedBits; // bit k of row i = slots[k] picked up by instance i
+    double stepSeconds = 0.0;
+    long long stepCount = 0;
+};
+
+// --env-bench [instances] [steps]: random-action throughput run plus a scripted
+// pickup/timeout/auto-reset episode; no window needed
+static int runEnvBenchmark(int argc, char** argv){
+    int instanceCount = argc>2 ? std::max(1, atoi(argv[2])) : 4096;
+    int steps = argc>3 ? std::max(1, atoi(argv[3])) : 600;
+    resetGame();
+    BatchedEnv env(instanceCount);
+    env.reset();
+
+    std::vector<uint8_t> actions(instanceCount);
+    uint32_t rng = 0x9E3779B9u;
+    double totalReward = 0.0;
+    int episodes = 0;
+    for(int s=0;s<steps;s++){
+        for(auto& a : actions){
+            rng ^= rng<<13; rng ^= rng>>17; rng ^= rng<<5;
+            a = (uint8_t)(rng & 31u);
+        }
+        env.step(actions.data());
+        for(int i=0;i<instanceCount;i++){ totalReward += env.lastRewards()[i]; episodes += env.lastDones()[i]; }
+    }
+    std::printf("[env] %d instances x %d steps on %d threads: %.0f steps/s (episodes done %d, total reward %.1f)\n",
+        instanceCount, steps, workerPool().threadCount(), env.stepsPerSecond(), episodes, totalReward);
+
+    // Scripted episode: instance 0 walks along x, then z, to the red collectible on the open
+    // side of the oracle (jumping when it makes no headway), instance 1 stands still. Both must time out exactly once and restart clean.
+    BatchedEnv script(2);
+    const std::vector<EnvObservation>& obs = script.reset();
+    const int slotCount = obs[0].collectiblesRemaining;
+    const Vec3 goal = collectibles[2].box.center;
+    const int timeoutStep = (int)std::ceil(obs[0].timeLeft / BatchedEnv::STEP_DT);
+    int pickupStep = -1, doneStep[2] = {-1, -1};
+    float pickupReward = 0.0f, doneReward[2] = {0.0f, 0.0f};
+    Vec3 lastPos = obs[0].playerPos;
+    uint8_t scripted[2] = {0, 0};
+    for(int s=0;s<timeoutStep;s++){
+        scripted[0] = 0;
+        if(pickupStep<0){
+            Vec3 d = sub(goal, obs[0].playerPos);
+            if(d.x < -0.1f) scripted[0] |= ACT_LEFT;
+            if(d.x >  0.1f) scripted[0] |= ACT_RIGHT;
+            if(!scripted[0] && d.z < -0.1f) scripted[0] |= ACT_FORWARD;
+            if(!scripted[0] && d.z >  0.1f) scripted[0] |= ACT_BACK;
+            if(s % 30 == 0){
+                if(dist2XZ(obs[0].playerPos, lastPos) < 0.25f) scripted[0] |= ACT_JUMP;
+                lastPos = obs[0].playerPos;
+            }
+        }
+        int remaining = obs[0].collectiblesRemaining;
+        script.step(scripted);
+        if(pickupStep<0 && obs[0].collectiblesRemaining < remaining){ pickupStep = s; pickupReward = script.lastRewards()[0]; }
+        for(int i=0;i<2;i++) if(script.lastDones()[i]){
+            if(doneStep[i]<0){ doneStep[i] = s; doneReward[i] = script.lastRewards()[i]; }
+            else doneStep[i] = -2; // finished twice
+        }
+    }
+    script.step(scripted);
+    bool resetOk = true;
+    for(int i=0;i<2;i++){
+        const EnvObservation& o = obs[i];
+        resetOk = resetOk && !script.lastDones()[i] && o.collectiblesRemaining == slotCount &&
+                  std::fabs(o.timeLeft - (120.0f - BatchedEnv::STEP_DT)) < 1e-4f && std::fabs(o.playerPos.x) < 0.5f && std::fabs(o.playerPos.z) < 0.5f;
+    }
+    std::printf("[env] scripted: pickup on step %d (reward %.1f), timeouts on steps %d/%d of %d (reward %.1f/%.1f), restart %s\n",
+        pickupStep, pickupReward, doneStep[0], doneStep[1], timeoutStep, doneReward[0], doneReward[1], resetOk ? "clean" : "dirty");
+    bool ok = pickupStep>=0 && pickupReward == 1.0f && resetOk;
+    for(int i=0;i<2;i++) ok = ok && doneStep[i] == timeoutStep-1 && doneReward[i] == -1.0f;
+    std::printf("[env] %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// --------------------------- Navigation ---------------------------
+// Walkable-surface graph for bot players. The XZ plane is sampled on a NAV_CELL grid and
+// every standable top (ground, platforms, static obstacles, features) above a cell becomes
+// a node. Nodes are linked by walk/drop edges to neighbouring cells and by jump edges to
+// higher surfaces inside the JUMP_VELOCITY/GRAVITY arc. Moving obstacles never change the
+// graph: they only toggle a blocked flag on the nodes inside their sweep, and cached paths
+// are revalidated against the ticks at which those flags last changed.
+static const float NAV_CELL = 1.0f;
+static const int NAV_GRID = (int)(2.0f * (WORLD_HALF - 1.0f) / NAV_CELL);
+static const float NAV_STEP_UP = 0.5f; // same tolerance collidesWithLevel allows when walking onto a top
+static const float NAV_JUMP_HEIGHT = JUMP_VELOCITY*JUMP_VELOCITY / (-2.0f*GRAVITY);
+
+struct NavNode {
+    Vec3 feet;          // player feet position when standing here
+    int firstEdge, edgeCount;
+    bool blocked;       // inside a moving obstacle this tick
+    int blockTick;      // tick at which the node last became blocked
+};
+
+struct NavEdge {
+    int to;
+    float cost;
+    bool jump;
+};
+
+class NavGraph {
+public:
+    bool built() const { return !nodes.empty(); }
+    int nodeCount() const { return (int)nodes.size(); }
+    int edgeCount() const { return (int)edges.size(); }
+    const NavNode& node(int i) const { return nodes[i]; }
+    const NavEdge* edgesOf(int i) const { return &edges[nodes[i].firstEdge]; }
+    int goalForCollectible(size_t i) const { return i<collectibleGoal.size() ? collectibleGoal[i] : -1; }
+    Vec3 standSpotForCollectible(size_t i) const { return collectibleStand[i]; }
+    int currentTick() const { return tick; }
+    int lastUnblockTick() const { return anyUnblockTick; }
+
+    void build(){
+        nodes.clear(); edges.clear(); cellFirst.assign(NAV_GRID*NAV_GRID + 1, 0);
+        staticObstacles.clear(); movingObstacles.clear();
+        for(size_t i=0;i<obstacles.size();i++) (obstacles[i].isMoving ? movingObstacles : staticObstacles).push_back((int)i);
+
+        // Nodes, grouped by cell so lookups are a range scan; the support map lists the
+        // static tops above each point already sorted
+        std::vector<float> tops;
+        const uint32_t raised = SUPPORT_MASK_ALL & ~worldPrimBit(WP_GROUND);
+        for(int cz=0; cz<NAV_GRID; cz++){
+            for(int cx=0; cx<NAV_GRID; cx++){
+                float x = cellCenter(cx), z = cellCenter(cz);
+                tops.clear();
+                tops.push_back(0.0f); // ground: game clamps player center to y=1
+                supportMap.forEachTop(x, z, raised, [&](float top){ tops.push_back(top); });
+                cellFirst[cz*NAV_GRID + cx] = (int)nodes.size();
+                float lastTop = -1e9f;
+                for(float top : tops){
+                    if(top - lastTop < 0.05f) continue;
+                    lastTop = top;
+                    if(staticCollides({x, top, z})) continue;
+                    nodes.push_back({ {x, top, z}, 0, 0, false, 0 });
+                }
+            }
+        }
+        cellFirst[NAV_GRID*NAV_GRID] = (int)nodes.size();
+
+        // Edges
+        const int jumpCells = (int)std::ceil(jumpReach(0.0f) / NAV_CELL);
+        for(size_t ni=0; ni<nodes.size(); ni++){
+            NavNode& n = nodes[ni];
+            n.firstEdge = (int)edges.size();
+            int cx = cellOf(n.feet.x), cz = cellOf(n.feet.z);
+            for(int dz=-jumpCells; dz<=jumpCells; dz++){
+                for(int dx=-jumpCells; dx<=jumpCells; dx++){
+                    if(dx==0 && dz==0) continue;
+                    int nx = cx+dx, nz = cz+dz;
+                    if(nx<0 || nz<0 || nx>=NAV_GRID || nz>=NAV_GRID) continue;
+                    int ring = std::max(std::abs(dx), std::abs(dz));
+                    for(int mi=cellFirst[nz*NAV_GRID+nx]; mi<cellFirst[nz*NAV_GRID+nx+1]; mi++){
+                        const Vec3& to = nodes[mi].feet;
+                        float rise = to.y - n.feet.y;
+                        float d = std::sqrt(dist2XZ(n.feet, to));
+                        if(ring==1 && rise <= NAV_STEP_UP){
+                            // walk or step off: the player crosses at the higher of the two heights
+                            if(!staticCollides({to.x, std::max(to.y, n.feet.y), to.z})) edges.push_back({mi, d, false});
+                        } else if(ring==2 && rise < -NAV_STEP_UP){
+                            // drop off an edge whose foot cell is blocked by the ledge itself
+                            Vec3 mid = mul(add(n.feet, to), 0.5f); mid.y = n.feet.y;
+                            if(!staticCollides(mid) && !staticCollides({to.x, n.feet.y, to.z})) edges.push_back({mi, d, false});
+                        } else if(rise > NAV_STEP_UP && rise <= NAV_JUMP_HEIGHT && d <= jumpReach(rise) && jumpClear(n.feet, to)){
+                            edges.push_back({mi, d + 1.0f, true});
+                        }
+                    }
+                }
+            }
+            n.edgeCount = (int)edges.size() - n.firstEdge;
+        }
+
+        // Nodes each moving obstacle can ever touch
+        sweepNodes.assign(movingObstacles.size(), std::vector<int>());
+        for(size_t m=0;m<movingObstacles.size();m++){
+            const Obstacle& o = obstacles[movingObstacles[m]];
+            AABB sweep = { o.basePos, o.box.half };
+            sweep.half.x += o.moveRange;
+            for(size_t ni=0; ni<nodes.size(); ni++) if(aabbIntersects(standingBox(nodes[ni].feet), sweep)) sweepNodes[m].push_back((int)ni);
+        }
+
+        // Per collectible: an off-grid standing spot that reaches it (preferring spots with
+        // slack around them, since the bot steers at full speed), and the node nearest to it
+        collectibleGoal.assign(collectibles.size(), -1);
+        collectibleStand.assign(collectibles.size(), Vec3{0,0,0});
+        for(size_t c=0;c<collectibles.size();c++){
+            const AABB& cb = collectibles[c].box;
+            AABB reach = { cb.center, {1.2f + playerHalf.x, 100.0f, 1.2f + playerHalf.z} };
+            tops.clear();
+            tops.push_back(0.0f);
+            for(const auto&p : platforms) if(aabbIntersects(reach, p.box)) tops.push_back(p.box.center.y + p.box.half.y);
+            for(int oi : staticObstacles) if(aabbIntersects(reach, obstacles[oi].box)) tops.push_back(obstacles[oi].box.center.y + obstacles[oi].box.half.y);
+            auto reaches = [&](const Vec3& feet){ return aabbIntersects(standingBox(feet), cb) && !staticCollides(feet) && supportMap.standing(standingBox(feet), false); };
+            float bestStand = -1e30f;
+            Vec3 stand = { cb.center.x, 0.0f, cb.center.z };
+            for(float top : tops){
+                for(int dz=-12; dz<=12; dz++){
+                    for(int dx=-12; dx<=12; dx++){
+                        Vec3 feet = { cb.center.x + dx*0.1f, top, cb.center.z + dz*0.1f };
+                        if(!reaches(feet)) continue;
+                        int slack = 0;
+                        for(int k=0;k<4;k++) slack += reaches({feet.x + (k==0?0.25f:k==1?-0.25f:0.0f), top, feet.z + (k==2?0.25f:k==3?-0.25f:0.0f)});
+                        float score = slack*1000.0f - (float)(dx*dx + dz*dz);
+                        if(score > bestStand){ bestStand = score; stand = feet; }
+                    }
+                }
+            }
+            collectibleStand[c] = stand;
+            float best = 1e30f;
+            for(size_t ni=0; ni<nodes.size(); ni++){
+                Vec3 d = sub(nodes[ni].feet, stand);
+                float score = d.x*d.x + 25.0f*d.y*d.y + d.z*d.z; // prefer the same surface
+                if(score < best){ best = score; collectibleGoal[c] = (int)ni; }
+            }
+        }
+
+        gScore.assign(nodes.size(), 0.0f);
+        parent.assign(nodes.size(), -1);
+        visitStamp.assign(nodes.size(), 0);
+        stamp = 0;
+        tick = 0; anyUnblockTick = 0;
+        updateMovingObstacles();
+    }
+
+    // Refresh blocked flags for nodes in the sweep of each moving obstacle
+    void updateMovingObstacles(){
+        tick++;
+        for(size_t m=0;m<movingObstacles.size();m++){
+            for(int ni : sweepNodes[m]){
+                AABB pb = standingBox(nodes[ni].feet);
+                bool blocked = false;
+                for(int oi : movingObstacles) if(aabbIntersects(pb, obstacles[oi].box)){ blocked = true; break; }
+                if(blocked != nodes[ni].blocked){
+                    nodes[ni].blocked = blocked;
+                    if(blocked) nodes[ni].blockTick = tick; else anyUnblockTick = tick;
+                }
+            }
+        }
+    }
+
+    // Node the player is standing on (or hovering over): highest top not above the feet
+    int nodeAt(const Vec3& playerCenter) const {
+        int cx = cellOf(playerCenter.x), cz = cellOf(playerCenter.z);
+        if(cx<0 || cz<0 || cx>=NAV_GRID || cz>=NAV_GRID) return -1;
+        float feet = playerCenter.y - playerHalf.y;
+        int best = -1;
+        for(int i=cellFirst[cz*NAV_GRID+cx]; i<cellFirst[cz*NAV_GRID+cx+1]; i++){
+            if(nodes[i].feet.y <= feet + NAV_STEP_UP) best = i;
+        }
+        return best;
+    }
+
+    // A* over unblocked nodes; 'out' receives start..goal. Scratch storage persists between calls.
+    bool findPath(int start, int goal, std::vector<int>& out){
+        out.clear();
+        if(start<0 || goal<0 || nodes[goal].blocked) return false;
+        if(++stamp == 0){ std::fill(visitStamp.begin(), visitStamp.end(), 0u); stamp = 1; }
+        open.clear();
+        gScore[start] = 0.0f; parent[start] = -1; visitStamp[start] = stamp;
+        open.push_back({heuristic(start, goal), start});
+        while(!open.empty()){
+            std::pop_heap(open.begin(), open.end(), OpenOrder());
+            OpenEntry cur = open.back(); open.pop_back();
+            if(cur.f - heuristic(cur.node, goal) > gScore[cur.node] + 1e-4f) continue; // stale entry
+            if(cur.node == goal){
+                for(int n=goal; n!=-1; n=parent[n]) out.push_back(n);
+                std::reverse(out.begin(), out.end());
+                return true;
+            }
+            const NavNode& n = nodes[cur.node];
+            for(int e=n.firstEdge; e<n.firstEdge+n.edgeCount; e++){
+                int to = edges[e].to;
+                if(nodes[to].blocked) continue;
+                float g = gScore[cur.node] + edges[e].cost;
+                if(visitStamp[to]==stamp && g >= gScore[to]) continue;
+                visitStamp[to] = stamp; gScore[to] = g; parent[to] = cur.node;
+                open.push_back({g + heuristic(to, goal), to});
+                std::push_heap(open.begin(), open.end(), OpenOrder());
+            }
+        }
+        return false;
+    }
+
+    bool edgeIsJump(int from, int to) const {
+        const NavNode& n = nodes[from];
+        for(int e=n.firstEdge; e<n.firstEdge+n.edgeCount; e++) if(edges[e].to==to) return edges[e].jump;
+        return false;
+    }
+
+private:
+    struct OpenEntry { float f; int node; };
+    struct OpenOrder { bool operator()(const OpenEntry&a, const OpenEntry&b) const { return a.f > b.f; } };
+
+    static float cellCenter(int c){ return -WORLD_HALF + 1.0f + (c + 0.5f) * NAV_CELL; }
+    static int cellOf(float v){ return (int)std::floor((v + WORLD_HALF - 1.0f) / NAV_CELL); }
+    static AABB standingBox(const Vec3& feet){ return { {feet.x, feet.y + playerHalf.y, feet.z}, playerHalf }; }
+
+    // Horizontal distance covered before landing 'rise' above the take-off height
+    static float jumpReach(float rise){
+        float disc = JUMP_VELOCITY*JUMP_VELOCITY + 2.0f*GRAVITY*rise;
+        if(disc < 0.0f) return 0.0f;
+        float tLand = (JUMP_VELOCITY + std::sqrt(disc)) / -GRAVITY;
+        return 0.8f * playerSpeed * tLand; // keep a margin for the bot's steering
+    }
+
+    bool staticCollides(const Vec3& feet) const {
+        const std::vector<int>& idx = staticObstacles;
+        return collidesWithLevel(standingBox(feet), idx.size(), [&](size_t i){ return obstacles[idx[i]].box; });
+    }
+
+    // Sample the straight-line path at the landing height; the arc is above it on the way up
+    bool jumpClear(const Vec3& from, const Vec3& to) const {
+        for(int s=1;s<=4;s++){
+            float k = s / 4.0f;
+            Vec3 p = add(from, mul(sub(to, from), k));
+            p.y = to.y + 0.05f;
+            if(staticCollides(p)) return false;
+        }
+        return true;
+    }
+
+    float heuristic(int a, int b) const {
+        Vec3 d = sub(nodes[a].feet, nodes[b].feet);
+        return std::sqrt(d.x*d.x + d.z*d.z);
+    }
+
+    std::vector<NavNode> nodes;
+    std::vector<NavEdge> edges;
+    std::vector<int> cellFirst;
+    std::vector<int> staticObstacles, movingObstacles;
+    std::vector<std::vector<int> > sweepNodes;
+    std::vector<int> collectibleGoal;
+    std::vector<Vec3> collectibleStand;
+    // A* scratch
+    std::vector<float> gScore;
+    std::vector<int> parent;
+    std::vector<unsigned> visitStamp;
+    std::vector<OpenEntry> open;
+    unsigned stamp = 0;
+    int tick = 0, anyUnblockTick = 0;
+};
+
+static NavGraph navGraph;
+
+// Direct-mapped cache of (start, goal) paths. A found path stays valid until one of its
+// nodes gets blocked; a failed search stays valid until some node gets unblocked.
+class NavPathCache {
+public:
+    static const int SLOTS = 8192;
+
+    const std::vector<int>* query(int start, int goal, bool* hit = nullptr){
+        Entry& e = slots[((unsigned)start*73856093u ^ (unsigned)goal*19349663u) % SLOTS];
+        bool valid = e.start==start && e.goal==goal && isFresh(e);
+        if(hit) *hit = valid;
+        if(!valid){
+            e.start = start; e.goal = goal;
+            e.found = navGraph.findPath(start, goal, e.path);
+            e.computedTick = navGraph.currentTick();
+            misses++;
+        } else hits++;
+        return e.found ? &e.path : nullptr;
+    }
+
+    bool isPathFresh(const std::vector<int>& path, int computedTick) const {
+        for(int n : path) if(navGraph.node(n).blockTick > computedTick) return false;
+        return true;
+    }
+
+    void clear(){ for(auto&e : slots){ e.start = e.goal = -1; } hits = misses = 0; }
+    long long hits = 0, misses = 0;
+
+private:
+    struct Entry { int start=-1, goal=-1, computedTick=0; bool found=false; std::vector<int> path; };
+    bool isFresh(const Entry& e) const {
+        if(!e.found) return navGraph.lastUnblockTick() <= e.computedTick;
+        return isPathFresh(e.path, e.computedTick);
+    }
+    Entry slots[SLOTS];
+};
+
+static NavPathCache navCache;
+
+// Autopilot: walks the player to the nearest remaining collectible for soak testing
+struct NavBot {
+    bool enabled = false;
+    std::vector<int> path;
+    size_t waypoint = 0;
+    int goalCollectible = -1;
+    int pathTick = 0;
+    float stuckTimer = 0.0f;
+    float sidestepTimer = 0.0f;
+    float sidestepSign = 1.0f;
+    Vec3 lastPos = {0,0,0};
+};
+static NavBot navBot;
+
+// Returns the move direction for this tick and whether to jump
+static Vec3 updateNavBot(float dt, bool& wantJump){
+    wantJump = false;
+    Vec3 move = {0,0,0};
+    if(!navGraph.built()) navGraph.build();
+    navGraph.updateMovingObstacles();
+
+    // Pick nearest uncollected collectible
+    int goalC = -1; float best = 1e30f;
+    for(size_t i=0;i<collectibles.size();i++){
+        if(collectibles[i].collected) continue;
+        float d = dist2XZ(playerPos, collectibles[i].box.center);
+        if(d < best){ best = d; goalC = (int)i; }
+    }
+    if(goalC<0) return move;
+
+    // Replan when the goal changes, we left the path, or a node on it got blocked
+    int start = navGraph.nodeAt(playerPos);
+    auto onPath = std::find(navBot.path.begin(), navBot.path.end(), start);
+    if(goalC != navBot.goalCollectible || onPath==navBot.path.end() || !navCache.isPathFresh(navBot.path, navBot.pathTick)){
+        navBot.goalCollectible = goalC;
+        navBot.path.clear();
+        const std::vector<int>* p = navCache.query(start, navGraph.goalForCollectible(goalC));
+        if(p){ navBot.path = *p; navBot.pathTick = navGraph.currentTick(); }
+        onPath = navBot.path.begin();
+    }
+
+    // Final approach (or no path): steer at the spot the collectible is reachable from
+    Vec3 target = navGraph.standSpotForCollectible(goalC);
+    if(!navBot.path.empty() && start != navBot.path.back()){
+        // Head for the node after the one we are standing on
+        navBot.waypoint = std::min((size_t)(onPath - navBot.path.begin()) + 1, navBot.path.size() - 1);
+        int next = navBot.path[navBot.waypoint];
+        target = navGraph.node(next).feet;
+        if(start>=0 && navGraph.edgeIsJump(start, next)) wantJump = true;
+    }
+    move = sub(target, playerPos); move.y = 0;
+
+    // Unstick by jumping and side-stepping if we made no headway over the last half second
+    navBot.stuckTimer += dt;
+    if(navBot.stuckTimer > 0.5f){
+        if(dist2XZ(playerPos, navBot.lastPos) < 0.25f){
+            wantJump = true;
+            navBot.sidestepTimer = 0.4f;
+            navBot.sidestepSign = -navBot.sidestepSign;
+        }
+        navBot.stuckTimer = 0.0f;
+        navBot.lastPos = playerPos;
+    }
+    if(navBot.sidestepTimer > 0.0f){
+        navBot.sidestepTimer -= dt;
+        move = { move.z * navBot.sidestepSign, 0.0f, -move.x * navBot.sidestepSign };
+    }
+    // Goal slot above reach from where we stand
+    const AABB& goalBox = collectibles[goalC].box;
+    if(dist2XZ(playerPos, target) < 0.25f && goalBox.center.y - goalBox.half.y > playerPos.y + playerHalf.y) wantJump = true;
+    return move;
+}
+
+// --nav-bench [queries]: graph build time and cold/cached query throughput
+static int runNavBenchmark(int argc, char** argv){
+    int queries = argc>2 ? std::max(1, atoi(argv[2])) : 20000;
+    resetGame();
+    auto t0 = std::chrono::steady_clock::now();
+    navGraph.build();
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    uint32_t rng = 12345u;
+    auto nextRand = [&](){ rng ^= rng<<13; rng ^= rng>>17; rng ^= rng<<5; return rng; };
+    std::vector<int> starts(256);
+    for(auto& s : starts) s = (int)(nextRand() % (uint32_t)navGraph.nodeCount());
+
+    std::vector<int> path;
+    int found = 0;
+    t0 = std::chrono::steady_clock::now();
+    for(int q=0;q<queries;q++){
+        int goal = navGraph.goalForCollectible(q % collectibles.size());
+        found += navGraph.findPath(starts[q % starts.size()], goal, path);
+    }
+    double coldS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Cached: many bots sharing starts, obstacles ticking at 60 Hz every 100 queries
+    navCache.clear();
+    t0 = std::chrono::steady_clock::now();
+    for(int q=0;q<queries;q++){
+        if(q % 100 == 0){ updateObstacles(1.0f/60.0f); navGraph.updateMovingObstacles(); }
+        navCache.query(starts[q % starts.size()], navGraph.goalForCollectible(q % collectibles.size()));
+    }
+    double warmS = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::printf("[nav] %d nodes, %d edges, built in %.1f ms\n", navGraph.nodeCount(), navGraph.edgeCount(), buildMs);
+    std::printf("[nav] A*: %.0f queries/s (%d/%d found); cached: %.0f queries/s (hit rate %.1f%%)\n",
+        queries/coldS, found, queries, queries/warmS, 100.0*navCache.hits/std::max(1LL, navCache.hits+navCache.misses));
+    return 0;
+}
+
+// --------------------------- Snapshots ---------------------------
+// Everything the simulation mutates, packed into one flat POD so it can be copied,
+// compared and delta-encoded byte-wise. The level layout is rebuilt identically by
+// resetGame() and is not part of it, and neither are view-only state (camera, particles).
+// Per-obstacle and per-collectible state is held for up to fixed counts; a level with more
+// runs without rewind and restarts by rebuilding (see startSnapshots()).
+static const int SNAPSHOT_MAX_OBSTACLES = 32;
+static const int SNAPSHOT_MAX_COLLECTIBLES = 128;
+
+struct SimSnapshot {
+    Vec3 playerPos, playerDir;
+    float playerYawDeg, playerVelY;
+    float gameTime, animWorldClock;
+    int32_t gameState;
+    uint32_t playerOnGround;
+    uint32_t collectedBits[SNAPSHOT_MAX_COLLECTIBLES / 32];
+    int32_t collectedPerPlatform[4];
+    uint32_t featureFlags[4]; // bit 0 allCollected, bit 1 animEnabled
+    float featureTime[4];
+    uint32_t obstacleCount;
+    float obstacleX[SNAPSHOT_MAX_OBSTACLES], obstacleMoveTime[SNAPSHOT_MAX_OBSTACLES];
+    FlyingOracle flyingOracles[4];
+    int32_t originChunkX, originChunkZ; // playerPos is relative to this chunk
+    uint64_t timerNow, timeUpTick;      // timer wheel clock; pending timers are re-armed from state
+    double timerFraction;
+    float obstacleClock;
+    uint32_t lodTick;                   // update LOD round-robin position
+};
+
+static bool levelFitsSnapshot(){
+    return obstacles.size() <= (size_t)SNAPSHOT_MAX_OBSTACLES && collectibles.size() <= (size_t)SNAPSHOT_MAX_COLLECTIBLES;
+}
+
+// Only for a level that fits (levelFitsSnapshot())
+static void captureSnapshot(SimSnapshot& s){
+    std::memset(&s, 0, sizeof(s)); // padding and unused slots must be stable for the deltas
+    s.playerPos = playerPos; s.playerDir = playerDir;
+    s.originChunkX = originChunkX; s.originChunkZ = originChunkZ;
+    s.playerYawDeg = playerYawDeg; s.playerVelY = playerVelY;
+    s.gameTime = gameTime; s.animWorldClock = animTracks.clock(CLOCK_WORLD);
+    s.timerNow = gameTimers.now(); s.timerFraction = gameTimers.fraction(); s.timeUpTick = timeUpTick;
+    s.obstacleClock = obstacleClock; s.lodTick = updateLod.tick;
+    s.gameState = gameState;
+    s.playerOnGround = playerOnGround;
+    for(size_t i=0;i<collectibles.size();i++) if(collectibles[i].collected) s.collectedBits[i >> 5] |= 1u << (i & 31);
+    for(int i=0;i<4;i++){
+        s.collectedPerPlatform[i] = collectedPerPlatform[i];
+        s.featureFlags[i] = (features[i].allCollected ? 1u : 0u) | (features[i].animEnabled ? 2u : 0u);
+        s.featureTime[i] = features[i].t;
+        s.flyingOracles[i] = flyingOracles[i];
+    }
+    s.obstacleCount = (uint32_t)obstacles.size();
+    for(uint32_t i=0;i<s.obstacleCount;i++){
+        s.obstacleX[i] = obstacles[i].box.center.x;
+        s.obstacleMoveTime[i] = obstacles[i].moveTime;
+    }
+}
+
+static void restoreSnapshot(const SimSnapshot& s){
+    playerPos = s.playerPos; playerDir = s.playerDir;
+    originChunkX = s.originChunkX; originChunkZ = s.originChunkZ;
+    playerYawDeg = s.playerYawDeg; playerVelY = s.playerVelY;
+    gameTime = s.gameTime;
+    animTracks.setClock(CLOCK_WORLD, s.animWorldClock, true);
+    gameState = (GameState)s.gameState;
+    gameTimers.reset(s.timerNow, s.timerFraction);
+    timeUpTick = s.timeUpTick;
+    obstacleClock = s.obstacleClock; updateLod.tick = s.lodTick;
+    armGameTimers();
+    playerOnGround = s.playerOnGround != 0;
+    for(size_t i=0;i<collectibles.size();i++) collectibles[i].collected = (s.collectedBits[i >> 5] >> (i & 31)) & 1u;
+    for(int i=0;i<4;i++){
+        collectedPerPlatform[i] = s.collectedPerPlatform[i];
+        features[i].allCollected = (s.featureFlags[i] & 1u) != 0;
+        features[i].animEnabled = (s.featureFlags[i] & 2u) != 0;
+        features[i].t = s.featureTime[i];
+        flyingOracles[i] = s.flyingOracles[i];
+    }
+    for(uint32_t i=0;i<s.obstacleCount && i<obstacles.size();i++){
+        obstacles[i].box.center.x = s.obstacleX[i];
+        obstacles[i].moveTime = s.obstacleMoveTime[i];
+    }
+    worldBVH.refit();
+    animTracks.setAllDue(); // skipped blocks hold values from before the restore
+    updateAnimation(0.0f);
+    navBot.path.clear(); // replan from wherever the player ends up
+    navBot.waypoint = 0;
+}
+
+// Per-tick history in a fixed byte ring. Every KEYFRAME_INTERVAL ticks a full snapshot is
+// stored; the ticks in between store their XOR against that keyframe, run-length coded as
+// (zero run, literal count, literals) byte pairs, so unchanged fields cost almost nothing.
+// A delta that would come out larger than a full snapshot is stored as a new keyframe.
+// When space runs out the oldest keyframe is dropped together with its deltas.
+class SnapshotHistory {
+public:
+    static const int KEYFRAME_INTERVAL = 30;
+    static const size_t RING_BYTES = 128 * 1024;
+    static const int MAX_ENTRIES = 1024;
+
+    SnapshotHistory() : ring(static_cast<uint8_t*>(std::malloc(RING_BYTES))) {}
+    ~SnapshotHistory(){ std::free(ring); }
+    SnapshotHistory(const SnapshotHistory&) = delete;
+    SnapshotHistory& operator=(const SnapshotHistory&) = delete;
+
+    void clear(){ oldest = 0; count = 0; writePos = 0; bytesUsed = 0; }
+    int size() const { return count; }
+    size_t bytes() const { return bytesUsed; }
+
+    void record(const SimSnapshot& s){
+        const Entry* newest = count ? &entry(oldest + count - 1) : nullptr;
+        bool key = !newest || (oldest + count) - newest->keySeq >= (uint32_t)KEYFRAME_INTERVAL;
+        size_t len = key ? sizeof(SimSnapshot) : encodeDelta(s, keyframe(newest->keySeq), scratch);
+        if(!len){ key = true; len = sizeof(SimSnapshot); }
+        uint32_t keySeq = key ? oldest + count : newest->keySeq;
+        uint32_t offset = reserve(len, key ? nullptr : &keySeq);
+        if(keySeq == NO_KEY){ // our keyframe was evicted to make room: store a full frame instead
+            writePos = offset;
+            len = sizeof(SimSnapshot);
+            offset = reserve(len, nullptr);
+            keySeq = oldest + count;
+            key = true;
         }
-        
-        flyingOracles[i].rotation += 180.0f * dt;
-        if(flyingOracles[i].rotation > 360.0f) flyingOracles[i].rotation -= 360.0f;
+        std::memcpy(ring + offset, key ? reinterpret_cast<const uint8_t*>(&s) : scratch, len);
+        Entry& e = entry(oldest + count);
+        e.offset = offset; e.length = (uint32_t)len; e.keySeq = keySeq;
+        count++;
+        bytesUsed += len;
+    }
+
+    // Drops the newest tick and returns the one before it; false once only one tick is left
+    bool stepBack(SimSnapshot& out){
+        if(count <= 1) return false;
+        bytesUsed -= entry(oldest + count - 1).length;
+        count--;
+        writePos = entry(oldest + count - 1).offset + entry(oldest + count - 1).length;
+        decode(oldest + count - 1, out);
+        return true;
+    }
+
+private:
+    static const uint32_t NO_KEY = 0xFFFFFFFFu;
+    static const size_t MAX_DELTA = sizeof(SimSnapshot);
+
+    struct Entry { uint32_t offset, length, keySeq; };
+
+    Entry& entry(uint32_t seq){ return entries[seq % MAX_ENTRIES]; }
+    const uint8_t* keyframe(uint32_t seq){ return ring + entry(seq).offset; }
+
+    void decode(uint32_t seq, SimSnapshot& out){
+        const Entry& e = entry(seq);
+        uint8_t* dst = reinterpret_cast<uint8_t*>(&out);
+        const uint8_t* key = keyframe(e.keySeq);
+        if(e.keySeq == seq){ std::memcpy(dst, key, sizeof(SimSnapshot)); return; }
+        const uint8_t* src = ring + e.offset;
+        size_t pos = 0;
+        while(pos < sizeof(SimSnapshot)){
+            size_t zeros = *src++, literals = *src++;
+            for(size_t i=0;i<zeros;i++, pos++) dst[pos] = key[pos];
+            for(size_t i=0;i<literals;i++, pos++) dst[pos] = key[pos] ^ *src++;
+        }
+    }
+
+    // Encoded length, or 0 if the delta would not fit in MAX_DELTA bytes
+    static size_t encodeDelta(const SimSnapshot& s, const uint8_t* key, uint8_t* out){
+        const uint8_t* cur = reinterpret_cast<const uint8_t*>(&s);
+        size_t pos = 0, n = 0;
+        while(pos < sizeof(SimSnapshot)){
+            size_t zeros = 0;
+            while(pos < sizeof(SimSnapshot) && zeros < 255 && cur[pos]==key[pos]){ pos++; zeros++; }
+            if(n + 2 > MAX_DELTA) return 0;
+            uint8_t* lit = out + n + 2;
+            size_t literals = 0;
+            while(pos < sizeof(SimSnapshot) && literals < 255 && cur[pos]!=key[pos]){
+                if(n + 2 + literals == MAX_DELTA) return 0;
+                lit[literals++] = cur[pos] ^ key[pos]; pos++;
+            }
+            out[n] = (uint8_t)zeros; out[n+1] = (uint8_t)literals;
+            n += 2 + literals;
+        }
+        return n;
+    }
+
+    // Finds room for len bytes after the newest entry, evicting whole keyframe groups from the
+    // oldest end. *keySeq is set to NO_KEY if that evicted the keyframe it refers to.
+    uint32_t reserve(size_t len, uint32_t* keySeq){
+        if(writePos + len > RING_BYTES){
+            // Entries past the write position are left over from the previous lap; they are the
+            // oldest and go before writing restarts at the front
+            while(count && entry(oldest).offset >= writePos) evictOldestGroup();
+            writePos = 0;
+        }
+        while(count && (count >= MAX_ENTRIES - 1 || overlaps(entry(oldest), writePos, len))) evictOldestGroup();
+        if(keySeq && (!count || *keySeq < oldest)) *keySeq = NO_KEY;
+        if(!count) writePos = 0;
+        uint32_t at = (uint32_t)writePos;
+        writePos += len;
+        return at;
+    }
+
+    void evictOldestGroup(){
+        do { bytesUsed -= entry(oldest).length; oldest++; count--; }
+        while(count && entry(oldest).keySeq != oldest);
+    }
+
+    static bool overlaps(const Entry& e, size_t at, size_t len){ return at < e.offset + e.length && e.offset < at + len; }
+
+    uint8_t* ring;
+    Entry entries[MAX_ENTRIES];
+    uint8_t scratch[MAX_DELTA];
+    uint32_t oldest = 0;   // sequence number of the oldest entry
+    int count = 0;
+    size_t writePos = 0, bytesUsed = 0;
+};
+
+static SnapshotHistory history;
+static SimSnapshot initialSnapshot;
+static bool rewindEnabled = false; // the level fits a SimSnapshot
+
+// After the level is first built: capture the state restarts return to and start the
+// history, or say once that this level runs without rewind
+static void startSnapshots(){
+    history.clear();
+    rewindEnabled = levelFitsSnapshot();
+    if(!rewindEnabled){
+        std::fprintf(stderr, "[snapshot] level has %zu obstacles and %zu collectibles, snapshots hold at most %d and %d; rewind is off\n",
+            obstacles.size(), collectibles.size(), SNAPSHOT_MAX_OBSTACLES, SNAPSHOT_MAX_COLLECTIBLES);
+        return;
     }
+    captureSnapshot(initialSnapshot);
+    history.record(initialSnapshot);
 }
 
-static void updateObstacles(float dt){
-    for(auto& obs : obstacles){
-        if(obs.isMoving){
-            obs.moveTime += dt;
-            // Move horizontally back and forth
-            float offset = sinf(obs.moveTime * obs.moveSpeed) * obs.moveRange;
-            obs.box.center.x = obs.basePos.x + offset;
+// ESC: return to the state captured right after the level was first built
+static void restartGame(){
+    if(!rewindEnabled){ resetGame(); return; }
+    restoreSnapshot(initialSnapshot);
+    camPos = {0.0f, 18.0f, 28.0f};
+    camTarget = {0.0f, 0.0f, 0.0f};
+    camUp = {0.0f, 1.0f, 0.0f};
+    camMode = CAM_FOLLOW;
+    particles.clear();
+    if(audioBgm.loaded) playAudio(audioBgm);
+    history.clear();
+    history.record(initialSnapshot);
+}
+
+// --------------------------- Occlusion culling ---------------------------
+// Before features, sky oracles and collectibles are submitted, a few large opaque
+// occluders (the walls in segments, the big fixed obstacles such as the blue stairs, the
+// temple bases) are rasterized into a small CPU depth buffer, and objects whose bounds lie
+// entirely behind it are skipped. Each occluder is filled as the convex hull of its
+// projected corners at the depth of its farthest corner, and only pixels the hull covers
+// completely are written, so the buffer never hides more than the occluders really do.
+// Depth is stored as 1/w (larger is nearer, 0 is empty) and processed four pixels at a time.
+// It is off unless --occlusion is given: in the courtyard's views it hides about 1% of the
+// candidates, which does not repay building it (--occlusion-bench measures both sides).
+
+// Bases of the background temples, left and right of each of two rows; the roofs sit on top
+static const int TEMPLE_COUNT = 4;
+static AABB templeBase(int i){
+    float z = -15.0f + (i/2) * 25.0f;
+    if(i & 1) return {{65.0f, 10.0f, z + 10.0f}, {7.0f, 10.0f, 7.0f}};
+    return {{-65.0f, 8.0f, z}, {6.0f, 8.0f, 6.0f}};
+}
+
+// Conservative bounds: features and oracles cover their whole animation range plus halos
+static AABB featureBounds(int i){
+    return {add(features[i].box.center, {0.0f, 3.5f, 0.0f}), {4.5f, 5.5f, 4.5f}};
+}
+static AABB skyOracleBounds(const SkyOracle& o){
+    return {o.pos, {o.radius, o.radius*0.5f + 0.8f, o.radius}};
+}
+static AABB collectibleBounds(const Collectible& c){
+    return {c.box.center, {c.box.half.x*1.5f, c.box.half.y*2.0f + 0.7f, c.box.half.z*1.5f}};
+}
+
+class OcclusionBuffer {
+public:
+    static const int W = 256, H = 128;           // W is a multiple of 4
+    static constexpr float NEAR_W = 0.1f;        // the camera's near plane
+    static constexpr float WALL_SEGMENT = 8.0f;  // long walls are cut up so each piece's far depth stays tight
+    static constexpr float MIN_OCCLUDER_SIZE = 4.0f; // fixed obstacles at least this wide in x and z occlude
+
+    bool enabled = false;                        // --occlusion
+    int tested = 0, culled = 0, occluders = 0;   // since resetStats()
+
+    void resetStats(){ tested = culled = occluders = 0; }
+
+    // Clears the buffer and draws the occluders with the current camera
+    void build(){
+        built = enabled;
+        if(!enabled) return;
+        Mat4 p, mv;
+        gfx->projection(p.m);
+        gfx->modelview(mv.m);
+        mvp = mat4Mul(p, mv);
+        std::memset(depth, 0, sizeof(depth));
+        for(const AABB& w : walls) drawWall(w);
+        for(const Obstacle& o : obstacles)
+            if(!o.isMoving && 2.0f*o.box.half.x >= MIN_OCCLUDER_SIZE && 2.0f*o.box.half.z >= MIN_OCCLUDER_SIZE) drawOccluder(o.box);
+        for(int i=0;i<TEMPLE_COUNT;i++) drawOccluder(templeBase(i));
+    }
+
+    // False only when all of b is behind the occluders drawn by the last build()
+    bool visible(const AABB& b){
+        if(!built) return true;
+        tested++;
+        float sx[8], sy[8], iw[8];
+        if(!project(b, sx, sy, iw)) return true;
+        float minX = sx[0], maxX = sx[0], minY = sy[0], maxY = sy[0], nearest = iw[0];
+        for(int i=1;i<8;i++){
+            minX = std::min(minX, sx[i]); maxX = std::max(maxX, sx[i]);
+            minY = std::min(minY, sy[i]); maxY = std::max(maxY, sy[i]);
+            nearest = std::max(nearest, iw[i]);
+        }
+        if(maxX < 0.0f || maxY < 0.0f || minX >= (float)W || minY >= (float)H) return true; // off-screen is the frustum's business
+        int x0 = std::max(0, (int)minX), x1 = std::min(W-1, (int)maxX);
+        int y0 = std::max(0, (int)minY), y1 = std::min(H-1, (int)maxY);
+
+        // Occluded where the buffer is strictly nearer than the object's nearest corner
+        const f4 lanes = f4Load(LANES), limit = f4Set1(std::nextafter(nearest, 2.0f*nearest + 1.0f));
+        const f4 lo = f4Set1((float)x0 - 0.5f), hi = f4Set1((float)x1 + 0.5f), ignore = f4Set1(2.0f/NEAR_W);
+        for(int y=y0;y<=y1;y++){
+            const float* row = depth + y*W;
+            for(int x=x0 & ~3;x<=x1;x+=4){
+                f4 px = f4Add(f4Set1((float)x), lanes);
+                f4 d = f4Select(f4And(f4Less(lo, px), f4Less(px, hi)), f4Load(row + x), ignore); // lanes outside the rect
+                if(f4Any(f4Less(d, limit))) return true;
+            }
+        }
+        culled++;
+        return false;
+    }
+
+    float cullRate() const { return tested ? (float)culled / (float)tested : 0.0f; }
+
+private:
+    // Corners to buffer pixels (y up) and 1/w; false if any is closer than the near plane
+    bool project(const AABB& b, float* sx, float* sy, float* iw) const {
+        Vec3 corners[8];
+        for(int i=0;i<8;i++)
+            corners[i] = { b.center.x + ((i & 1) ? b.half.x : -b.half.x),
+                           b.center.y + ((i & 2) ? b.half.y : -b.half.y),
+                           b.center.z + ((i & 4) ? b.half.z : -b.half.z) };
+        Vec4 clip[8];
+        transformPoints(mvp, &corners[0].x, sizeof(Vec3), 8, clip);
+        for(int i=0;i<8;i++){
+            if(clip[i].w < NEAR_W) return false;
+            iw[i] = 1.0f / clip[i].w;
+            sx[i] = (clip[i].x * iw[i] * 0.5f + 0.5f) * W;
+            sy[i] = (clip[i].y * iw[i] * 0.5f + 0.5f) * H;
+        }
+        return true;
+    }
+
+    // Pieces overlap a little so the seams between them are covered
+    void drawWall(const AABB& w){
+        bool alongX = w.half.x >= w.half.z;
+        float len = 2.0f * (alongX ? w.half.x : w.half.z);
+        float start = alongX ? w.center.x - w.half.x : w.center.z - w.half.z;
+        int pieces = std::max(1, (int)std::ceil(len / WALL_SEGMENT));
+        float step = len / pieces;
+        for(int i=0;i<pieces;i++){
+            float a = std::max(start, start + i*step - 0.5f), b = std::min(start + len, start + (i+1)*step + 0.5f);
+            AABB piece = w;
+            if(alongX){ piece.center.x = 0.5f*(a + b); piece.half.x = 0.5f*(b - a); }
+            else { piece.center.z = 0.5f*(a + b); piece.half.z = 0.5f*(b - a); }
+            drawOccluder(piece);
+        }
+    }
+
+    void drawOccluder(const AABB& b){
+        float sx[8], sy[8], iw[8];
+        if(!project(b, sx, sy, iw)) return; // clipping would be needed; skipping is always safe
+
+        // Andrew's monotone chain: counter-clockwise hull of the projected corners
+        int order[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+        std::sort(order, order + 8, [&](int a, int c){ return sx[a] < sx[c] || (sx[a] == sx[c] && sy[a] < sy[c]); });
+        auto turn = [&](int o, int a, int c){ return (sx[a]-sx[o])*(sy[c]-sy[o]) - (sy[a]-sy[o])*(sx[c]-sx[o]); };
+        int hull[17], n = 0;
+        for(int i=0;i<8;i++){
+            while(n >= 2 && turn(hull[n-2], hull[n-1], order[i]) <= 0.0f) n--;
+            hull[n++] = order[i];
+        }
+        for(int i=6, lower=n+1;i>=0;i--){
+            while(n >= lower && turn(hull[n-2], hull[n-1], order[i]) <= 0.0f) n--;
+            hull[n++] = order[i];
+        }
+        n--; // the last point repeats the first
+        if(n < 3) return;
+
+        // Edge functions a*x + b*y + c, positive inside; c is lowered by half a pixel's
+        // extent along the normal so only fully covered pixels test positive
+        float ea[8], eb[8], ec[8];
+        float minX = sx[hull[0]], maxX = minX, minY = sy[hull[0]], maxY = minY, farthest = iw[0];
+        for(int i=0;i<n;i++){
+            int p = hull[i], q = hull[(i+1) % n];
+            ea[i] = sy[p] - sy[q];
+            eb[i] = sx[q] - sx[p];
+            ec[i] = -(ea[i]*sx[p] + eb[i]*sy[p]) - 0.5f*(std::fabs(ea[i]) + std::fabs(eb[i]));
+            minX = std::min(minX, sx[p]); maxX = std::max(maxX, sx[p]);
+            minY = std::min(minY, sy[p]); maxY = std::max(maxY, sy[p]);
+        }
+        for(int i=1;i<8;i++) farthest = std::min(farthest, iw[i]);
+        int x0 = std::max(0, (int)std::floor(minX)) & ~3, x1 = std::min(W-1, (int)std::floor(maxX));
+        int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(H-1, (int)std::floor(maxY));
+        if(x0 > x1 || y0 > y1) return;
+        occluders++;
+
+        const f4 zero = f4Set1(0.0f), lanes = f4Load(LANES), far4 = f4Set1(farthest);
+        for(int y=y0;y<=y1;y++){
+            float* row = depth + y*W;
+            float cy = (float)y + 0.5f;
+            for(int x=x0;x<=x1;x+=4){
+                f4 px = f4Add(f4Set1((float)x + 0.5f), lanes);
+                f4 inside = f4Less(zero, f4Add(f4Mul(f4Set1(ea[0]), px), f4Set1(eb[0]*cy + ec[0])));
+                for(int e=1;e<n;e++)
+                    inside = f4And(inside, f4Less(zero, f4Add(f4Mul(f4Set1(ea[e]), px), f4Set1(eb[e]*cy + ec[e]))));
+                f4 d = f4Load(row + x);
+                f4Store(row + x, f4Select(inside, f4Max(d, far4), d));
+            }
+        }
+    }
+
+    alignas(16) static const float LANES[4];
+    alignas(16) float depth[W*H];
+    Mat4 mvp;
+    bool built = false;
+};
+
+alignas(16) const float OcclusionBuffer::LANES[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+
+static OcclusionBuffer occlusion;
+
+// --------------------------- Quality governor ---------------------------
+// On slow machines (software GL in particular) the frame rate sinks as more of the scene
+// animates. The governor compares each frame's cost, display() up to the swap plus the
+// tick before it, with the frame budget and moves through QUALITY_LEVELS: fewer glow and
+// outline segments and drawn particles first, then less background, then a smaller render
+// resolution that is stretched over the window. It steps down once the smoothed cost has been over budget
+// for half a second and up only after seconds well under it; a step up that is undone
+// within a few seconds makes the next one wait twice as long, so the level does not flap.
+struct QualityLevel {
+    const char* name;
+    int segmentStep;      // stride through the halo, orb and oracle outline segments
+    int particleStride;   // every n-th particle is drawn
+    int mountainLayers;   // of body, shoulder and snow cap
+    int bambooClusters;
+    float renderScale;    // of the window's width and height
+};
+
+static const QualityLevel QUALITY_LEVELS[] = {
+    { "full",   1, 1, 3, 5, 1.0f  },
+    { "high",   2, 2, 3, 5, 1.0f  },
+    { "medium", 2, 2, 2, 3, 0.85f },
+    { "low",    4, 4, 2, 2, 0.7f  },
+    { "lowest", 4, 8, 1, 0, 0.5f  },
+};
+static const int QUALITY_LEVEL_COUNT = (int)(sizeof(QUALITY_LEVELS) / sizeof(QUALITY_LEVELS[0]));
+
+class QualityGovernor {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr float SMOOTHING = 0.1f;                 // weight of a new frame's load
+    static constexpr float DOWN_LOAD = 0.95f, UP_LOAD = 0.6f; // of the frame budget
+    static constexpr double DOWN_HOLD_S = 0.5, UP_HOLD_S = 3.0, MAX_UP_HOLD_S = 48.0;
+    static constexpr double BOUNCE_S = 5.0;                  // a step down this soon after a step up is a bounce
+    static constexpr double MAX_FRAME_GAP_S = 0.25;          // longer gaps (pauses, low-power) count as this
+
+    float targetHz = 60.0f; // the budget is one frame at this rate
+    bool adaptive = true;   // false once pinned
+
+    const QualityLevel& current() const { return QUALITY_LEVELS[lvl]; }
+    int level() const { return lvl; }
+
+    void pin(int level){
+        adaptive = false;
+        setLevel(std::min(QUALITY_LEVEL_COUNT - 1, std::max(0, level)));
+    }
+
+    void onTick(float ms){ lastTickMs = ms; }
+
+    // One displayed frame that spent displayMs in display() up to submitting it (not the
+    // swap); true if the level changed
+    bool onFrame(float displayMs){
+        if(!adaptive) return false;
+        Clock::time_point now = Clock::now();
+        double gap = lastFrame.time_since_epoch().count() ? std::chrono::duration<double>(now - lastFrame).count() : 0.0;
+        gap = std::min(gap, MAX_FRAME_GAP_S);
+        lastFrame = now;
+
+        float budgetMs = 1000.0f / (targetHz > 0.0f ? targetHz : 60.0f);
+        float load = (displayMs + lastTickMs) / budgetMs;
+        smoothed = haveLoad ? smoothed + (load - smoothed) * SMOOTHING : load;
+        haveLoad = true;
+        overS = smoothed > DOWN_LOAD ? overS + gap : 0.0;
+        underS = smoothed < UP_LOAD ? underS + gap : 0.0;
+
+        bool recentUp = steppedUp && now - upAt < std::chrono::duration<double>(BOUNCE_S);
+        if(steppedUp && !recentUp){ upHoldS = std::max(UP_HOLD_S, upHoldS * 0.5); steppedUp = false; }
+
+        if(overS >= DOWN_HOLD_S && lvl + 1 < QUALITY_LEVEL_COUNT){
+            if(recentUp){ upHoldS = std::min(MAX_UP_HOLD_S, upHoldS * 2.0); steppedUp = false; }
+            setLevel(lvl + 1);
+            return true;
+        }
+        if(underS >= upHoldS && lvl > 0){
+            setLevel(lvl - 1);
+            steppedUp = true;
+            upAt = now;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    void setLevel(int level){
+        lvl = level;
+        renderQueue.segmentStep = QUALITY_LEVELS[lvl].segmentStep;
+        haveLoad = false; // the old level's cost says little about the new one
+        overS = underS = 0.0;
+    }
+
+    int lvl = 0;
+    float lastTickMs = 0.0f, smoothed = 0.0f;
+    bool haveLoad = false, steppedUp = false;
+    double overS = 0.0, underS = 0.0, upHoldS = UP_HOLD_S;
+    Clock::time_point lastFrame, upAt;
+};
+constexpr double QualityGovernor::UP_HOLD_S, QualityGovernor::MAX_UP_HOLD_S, QualityGovernor::BOUNCE_S, QualityGovernor::MAX_FRAME_GAP_S; // std::min/max take them by reference
+
+static QualityGovernor quality;
+
+// Reduced render resolution: the world is drawn into the lower-left w x h pixels of the
+// back buffer, which are then copied to a texture and stretched over the window with
+// bilinear filtering before the HUD goes on top. Fixed-function only, like the static
+// layer cache.
+class ResolutionScaler {
+public:
+    // The size to draw at for a window of winW x winH; the window size itself at full scale
+    static void scaledSize(float scale, int winW, int winH, int& w, int& h){
+        w = std::max(1, (int)(winW * scale + 0.5f));
+        h = std::max(1, (int)(winH * scale + 0.5f));
+    }
+
+    // Stretches the lower-left w x h pixels over the whole winW x winH window
+    void upsample(int w, int h, int winW, int winH){
+        if(!tex) glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        if(w > texW || h > texH){
+            // power-of-two storage so this works without NPOT texture support
+            texW = 1; while(texW < w) texW <<= 1;
+            texH = 1; while(texH < h) texH <<= 1;
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texW, texH, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, w, h);
+
+        glViewport(0, 0, winW, winH);
+        glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+        glMatrixMode(GL_PROJECTION); glPushMatrix(); glLoadIdentity(); glOrtho(0, winW, 0, winH, -1, 1);
+        glMatrixMode(GL_MODELVIEW); glPushMatrix(); glLoadIdentity();
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_LIGHTING);
+        glDisable(GL_BLEND);
+        glEnable(GL_TEXTURE_2D);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+        // Texel centres to texel centres, so the filter never reads past the copied pixels
+        float u0 = 0.5f / texW, v0 = 0.5f / texH, u1 = (w - 0.5f) / texW, v1 = (h - 0.5f) / texH;
+        drawCallCount++;
+        glBegin(GL_QUADS);
+        glTexCoord2f(u0, v0); glVertex2f(0, 0);
+        glTexCoord2f(u1, v0); glVertex2f((float)winW, 0);
+        glTexCoord2f(u1, v1); glVertex2f((float)winW, (float)winH);
+        glTexCoord2f(u0, v1); glVertex2f(0, (float)winH);
+        glEnd();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION); glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopAttrib();
+    }
+
+private:
+    GLuint tex = 0;
+    int texW = 0, texH = 0;
+};
+
+static ResolutionScaler resolutionScaler;
+
+// --------------------------- Rendering ---------------------------
+static void drawEastAsianBackground(){
+    // Draw East Asian landscape in the background (mountains, temples, bamboo)
+    const QualityLevel& detail = quality.current();
+
+    // Mountain range in the far background - varying heights
+    for(int i = -4; i <= 4; i++){
+        float x = i * 18.0f;
+        float height = 35.0f + (i % 3) * 12.0f;
+        float width = 12.0f + (i % 2) * 5.0f;
+
+        // Mountain body - dark gray/brown stone
+        float mountainR = 0.25f + (i % 3) * 0.05f;
+        float mountainG = 0.28f + (i % 2) * 0.04f;
+        float mountainB = 0.22f + (i % 3) * 0.03f;
+
+        // Draw mountain as tapered shape (wider at base)
+        drawSolidBox({{x, height/3, -70.0f}, {width/2, height/3, 8.0f}},
+                     mountainR, mountainG, mountainB);
+        if(detail.mountainLayers > 1)
+            drawSolidBox({{x, height*0.7f, -70.0f}, {width/3, height*0.2f, 7.0f}},
+                         mountainR + 0.1f, mountainG + 0.1f, mountainB + 0.1f);
+
+        // Snow caps on peaks
+        if(detail.mountainLayers > 2)
+            drawSolidBox({{x, height - 2.0f, -70.0f}, {width/4, 3.0f, 6.0f}},
+                         0.9f, 0.92f, 0.95f);
+    }
+
+    // Traditional pagoda temples along the sides
+    for(int i = 0; i < TEMPLE_COUNT/2; i++){
+        // Left side temple
+        AABB left = templeBase(2*i);
+        drawSolidBox(left, 0.35f, 0.25f, 0.2f); // Dark wood base
+        drawPyramid({left.center.x, left.center.y + left.half.y, left.center.z}, 14.0f, 6.0f, 0.6f, 0.15f, 0.15f); // Red roof
+
+        // Right side temple
+        AABB right = templeBase(2*i + 1);
+        drawSolidBox(right, 0.4f, 0.3f, 0.25f);
+        drawPyramid({right.center.x, right.center.y + right.half.y, right.center.z}, 16.0f, 7.0f, 0.55f, 0.18f, 0.18f);
+    }
+
+    // Bamboo forest effect - tall thin boxes in clusters
+    for(int cluster = 0; cluster < detail.bambooClusters; cluster++){
+        float baseX = -50.0f + cluster * 25.0f;
+        for(int stalk = 0; stalk < 4; stalk++){
+            float x = baseX + (stalk - 2) * 1.5f;
+            float z = -55.0f + (stalk % 2) * 2.0f;
+            float height = 18.0f + (stalk % 3) * 4.0f;
+            // Bamboo stalks - green
+            drawSolidBox({{x, height/2, z}, {0.3f, height/2, 0.3f}},
+                       0.25f, 0.5f + (stalk % 2) * 0.1f, 0.25f);
+        }
+    }
+}
+
+static void drawGround(){
+    // Traditional East Asian ground - earth/stone courtyard style
+    drawSolidBox(groundBox, 0.35f, 0.32f, 0.28f); // Earthy brown/tan
+
+    // Stone tile pattern - darker squares creating traditional courtyard look
+    gfx->color(0.28f, 0.26f, 0.24f);
+    gfx->begin(DRAW_QUADS);
+    for(int i=-35; i<=35; i+=8){
+        for(int j=-35; j<=35; j+=8){
+            // Alternating pattern like traditional stone tiles
+            if((i/8 + j/8) % 2 == 0){
+                gfx->vertex((float)i, 0.21f, (float)j);
+                gfx->vertex((float)i+7.5f, 0.21f, (float)j);
+                gfx->vertex((float)i+7.5f, 0.21f, (float)j+7.5f);
+                gfx->vertex((float)i, 0.21f, (float)j+7.5f);
+            }
+        }
+    }
+    gfx->end();
+
+    // Gravel/sand paths - lighter colored paths crossing the courtyard
+    gfx->color(0.5f, 0.48f, 0.42f);
+    gfx->begin(DRAW_QUADS);
+    // Horizontal path
+    gfx->vertex(-40.0f, 0.22f, -2.0f);
+    gfx->vertex(40.0f, 0.22f, -2.0f);
+    gfx->vertex(40.0f, 0.22f, 2.0f);
+    gfx->vertex(-40.0f, 0.22f, 2.0f);
+    // Vertical path
+    gfx->vertex(-2.0f, 0.22f, -40.0f);
+    gfx->vertex(2.0f, 0.22f, -40.0f);
+    gfx->vertex(2.0f, 0.22f, 40.0f);
+    gfx->vertex(-2.0f, 0.22f, 40.0f);
+    gfx->end();
+}
+
+// Traditional East Asian walls - stone/wood fortress walls
+static void drawWall(const AABB& w){
+    // Main wall - gray stone
+    drawSolidBox(w, 0.45f, 0.42f, 0.40f);
+
+    // Wooden top rail - dark wood beam along top of wall
+    gfx->color(0.25f, 0.18f, 0.12f);
+    gfx->begin(DRAW_QUADS);
+    float y = w.center.y + w.half.y + 0.15f;
+
+    // Draw wooden beam on top
+    if(std::abs(w.half.x - w.half.z) > 0.5f){ // Long wall (back/side walls)
+        // Top beam
+        gfx->vertex(w.center.x - w.half.x, y, w.center.z - w.half.z - 0.3f);
+        gfx->vertex(w.center.x + w.half.x, y, w.center.z - w.half.z - 0.3f);
+        gfx->vertex(w.center.x + w.half.x, y, w.center.z + w.half.z + 0.3f);
+        gfx->vertex(w.center.x - w.half.x, y, w.center.z + w.half.z + 0.3f);
+    }
+    gfx->end();
+
+    // Stone texture - horizontal lines suggesting stacked stones
+    gfx->color(0.35f, 0.33f, 0.32f);
+    gfx->begin(DRAW_LINES);
+    for(float h = w.center.y - w.half.y + 0.8f; h < w.center.y + w.half.y; h += 0.8f){
+        gfx->vertex(w.center.x - w.half.x, h, w.center.z - w.half.z);
+        gfx->vertex(w.center.x + w.half.x, h, w.center.z - w.half.z);
+        gfx->vertex(w.center.x - w.half.x, h, w.center.z + w.half.z);
+        gfx->vertex(w.center.x + w.half.x, h, w.center.z + w.half.z);
+    }
+    gfx->end();
+}
+
+static void drawWalls(){
+    for(const auto&w : walls) drawWall(w);
+}
+
+static void drawPlatform(const Platform& p){
+    gfx->color(p.color[0],p.color[1],p.color[2]);
+    drawSolidBox(p.box, p.color[0],p.color[1],p.color[2]);
+    // Add a decorative rim to make platforms visually distinct
+    gfx->color(0.1f,0.1f,0.1f);
+    AABB rim = p.box; rim.half.x += 0.5f; rim.half.z += 0.5f; rim.half.y = 0.05f; rim.center.y = p.box.center.y + p.box.half.y + rim.half.y;
+    drawSolidBox(rim, 0.1f,0.1f,0.1f);
+}
+
+static void drawPlatforms(){
+    for(int i=0;i<4;i++) drawPlatform(platforms[i]);
+}
+
+static void drawCollectibles(){
+    for(const auto&c : collectibles){ if(!c.collected && occlusion.visible(collectibleBounds(c))) drawCollectibleGeom(c); }
+}
+
+static void drawFeatures(){
+    for(int i=0;i<4;i++) if(occlusion.visible(featureBounds(i))) drawFeatureObj(features[i]);
+}
+
+static void drawSkyOracle(const SkyOracle& o){
+    Vec3 center = {o.pos.x, o.pos.y + animTracks.value(o.track[OT_BOB]), o.pos.z};
+    float pulse = animTracks.value(o.track[OT_PULSE]);
+    
+    drawGlowingOrb(center, o.radius * 0.5f * (0.8f + 0.2f*pulse), o.color, 0.6f + 0.4f*pulse);
+    drawHaloRing({center.x, center.y - 0.2f, center.z}, o.radius * 0.4f, o.radius, o.color, 0.3f + 0.4f*pulse);
+
+    gfx->pushMatrix();
+    gfx->translate(center.x, center.y, center.z);
+    gfx->rotate(animTracks.value(o.track[OT_SPIN]), 0, 1, 0);
+    gfx->color(o.color[0]*0.85f, o.color[1]*0.85f, o.color[2]*0.85f);
+    gfx->begin(DRAW_LINE_LOOP);
+    for(int i=0;i<48;i+=quality.current().segmentStep){
+        float ang = (float)i/48.0f * 2.0f * PI_F;
+        gfx->vertex(cosf(ang) * o.radius * 0.85f, 0.0f, sinf(ang) * o.radius * 0.85f);
+    }
+    gfx->end();
+    gfx->popMatrix();
+}
+
+static void drawSkyOracles(){
+    for(const auto& o : skyOracles) if(occlusion.visible(skyOracleBounds(o))) drawSkyOracle(o);
+}
+
+static void drawObstacles(bool moving){
+    for(const auto& obs : obstacles){
+        if(obs.isMoving != moving) continue;
+        drawSolidBox(obs.box, obs.color[0], obs.color[1], obs.color[2]);
+    }
+}
+
+// --------------------------- Static layer cache ---------------------------
+// The top, side and front presets never move the camera, so the static part of the scene
+// (background, ground, walls, platforms, fixed obstacles) is rendered once and captured:
+// colour into a texture, depth into a host buffer. Later frames restore both and draw
+// only the moving objects on top. A capture is tied to the camera mode and window size
+// it was taken at, so switching presets or resizing re-renders it.
+class StaticLayerCache {
+public:
+    static bool cacheable(CameraPreset mode){ return mode==CAM_TOP || mode==CAM_SIDE || mode==CAM_FRONT; }
+
+    void invalidate(){ valid = false; }
+
+    // Restores the captured layer into the current framebuffer; false if there is none for this view
+    bool restore(CameraPreset mode, int w, int h){
+        if(!valid || mode!=capturedMode || w!=capturedW || h!=capturedH) return false;
+
+        glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT | GL_PIXEL_MODE_BIT);
+        glMatrixMode(GL_PROJECTION); glPushMatrix(); glLoadIdentity(); glOrtho(0, w, 0, h, -1, 1);
+        glMatrixMode(GL_MODELVIEW); glPushMatrix(); glLoadIdentity();
+        glDisable(GL_LIGHTING);
+        glDisable(GL_BLEND);
+
+        // Colour: one textured quad
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, colorTex);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+        float u = (float)w / texW, v = (float)h / texH;
+        drawCallCount++;
+        glBegin(GL_QUADS);
+        glTexCoord2f(0, 0); glVertex2f(0, 0);
+        glTexCoord2f(u, 0); glVertex2f((float)w, 0);
+        glTexCoord2f(u, v); glVertex2f((float)w, (float)h);
+        glTexCoord2f(0, v); glVertex2f(0, (float)h);
+        glEnd();
+        glDisable(GL_TEXTURE_2D);
+
+        // Depth: written as pixels with colour writes off (depth writes need the test enabled)
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glDepthMask(GL_TRUE);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glRasterPos2i(0, 0);
+        drawCallCount++;
+        glDrawPixels(w, h, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, depth.data());
+
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION); glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopAttrib();
+        return true;
+    }
+
+    // Grabs whatever has been drawn so far as the static layer for this view
+    void capture(CameraPreset mode, int w, int h){
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        if(w > maxSize || h > maxSize){ valid = false; return; } // leave this view uncached
+
+        if(!colorTex) glGenTextures(1, &colorTex);
+        glBindTexture(GL_TEXTURE_2D, colorTex);
+        if(w > texW || h > texH){
+            // power-of-two storage so this works without NPOT texture support
+            texW = 1; while(texW < w) texW <<= 1;
+            texH = 1; while(texH < h) texH <<= 1;
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texW, texH, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         }
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, w, h);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        depth.resize((size_t)w * h);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, w, h, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, depth.data());
+
+        capturedMode = mode; capturedW = w; capturedH = h;
+        valid = true;
+    }
+
+private:
+    bool valid = false;
+    CameraPreset capturedMode = CAM_FOLLOW;
+    int capturedW = 0, capturedH = 0;
+    GLuint colorTex = 0;
+    int texW = 0, texH = 0;
+    std::vector<GLuint> depth;
+};
+
+static StaticLayerCache staticLayer;
+
+// --------------------------- Telemetry ---------------------------
+// With --telemetry the game publishes a fixed-size record per sim tick and per displayed
+// frame into a ring in POSIX shared memory, for external monitors such as
+// tools/telemetry_reader. The main thread is the only producer, so publishing is plain
+// stores: each slot's sequence is odd while it is written and 2*(index+1) once complete,
+// which lets a reader tell a finished record from one it was lapped on or caught half
+// written. Nothing on the publish path allocates or enters the kernel (steady_clock is read
+// through the vDSO). tools/telemetry_reader.cpp mirrors this layout; bump TELEMETRY_VERSION
+// whenever it changes.
+static const uint32_t TELEMETRY_MAGIC = 0x4D4C4554u; // "TELM"
+static const uint32_t TELEMETRY_VERSION = 2;
+static const uint32_t TELEMETRY_CAPACITY = 4096;     // records, power of two
+static const char* TELEMETRY_DEFAULT_NAME = "/p01_telemetry";
+
+enum TelemetryKind { TELEMETRY_TICK = 1, TELEMETRY_FRAME = 2 };
+
+struct TelemetryHeader {
+    uint32_t magic, version, recordSize, capacity;
+    uint64_t sessionId;                 // changes every time the game creates the ring
+    std::atomic<uint64_t> writeIndex;   // records published so far
+    uint8_t reserved[32];
+};
+
+struct TelemetryRecord {
+    std::atomic<uint64_t> seq;
+    uint64_t timeNs;        // since the ring was created
+    uint32_t kind;          // TelemetryKind
+    uint32_t frame;         // frames displayed so far
+    float ms;               // tick: stepGame() time; frame: interval since the previous swap
+    float cpuMs;            // tick: idle() work after the pacing wait; frame: time inside display()
+    uint32_t drawCalls;     // frame only
+    uint32_t obstacles, collectiblesLeft, skyOracles, particles, chunks;
+    uint32_t occlusionTested, occlusionCulled; // frame only: bounds tested against the occlusion buffer, and hidden
+};
+
+static_assert(sizeof(TelemetryHeader) == 64 && sizeof(TelemetryRecord) == 64, "telemetry layout is shared with tools/telemetry_reader.cpp");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "telemetry sequences must be lock-free to live in shared memory");
+
+class TelemetryRing {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    ~TelemetryRing(){ close(); }
+
+    bool open(const char* shmName){
+#if TELEMETRY_SHM
+        size_t bytes = sizeof(TelemetryHeader) + TELEMETRY_CAPACITY * sizeof(TelemetryRecord);
+        int fd = shm_open(shmName, O_CREAT | O_RDWR, 0644);
+        if(fd < 0){ std::fprintf(stderr, "[telemetry] shm_open(%s) failed\n", shmName); return false; }
+        void* mem = MAP_FAILED;
+        if(ftruncate(fd, (off_t)bytes) == 0) mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(mem == MAP_FAILED){ std::fprintf(stderr, "[telemetry] could not map %zu bytes for %s\n", bytes, shmName); shm_unlink(shmName); return false; }
+        std::memset(mem, 0, bytes);
+        header = static_cast<TelemetryHeader*>(mem);
+        records = reinterpret_cast<TelemetryRecord*>(header + 1);
+        start = Clock::now();
+        header->magic = TELEMETRY_MAGIC;
+        header->version = TELEMETRY_VERSION;
+        header->recordSize = sizeof(TelemetryRecord);
+        header->capacity = TELEMETRY_CAPACITY;
+        header->sessionId = (uint64_t)start.time_since_epoch().count();
+        header->writeIndex.store(0, std::memory_order_release);
+        mappedBytes = bytes;
+        std::snprintf(name, sizeof(name), "%s", shmName);
+        std::printf("[telemetry] publishing to shared memory %s\n", name);
+        return true;
+#else
+        std::fprintf(stderr, "[telemetry] shared-memory telemetry needs POSIX shm (ignored: %s)\n", shmName);
+        return false;
+#endif
+    }
+
+    void close(){
+#if TELEMETRY_SHM
+        if(!header) return;
+        munmap(header, mappedBytes);
+        shm_unlink(name);
+        header = nullptr;
+        records = nullptr;
+#endif
+    }
+
+    bool active() const { return header != nullptr; }
+
+    // Fills in the sequence and timestamp; the caller provides everything else
+    void publish(const TelemetryRecord& r){
+        if(!header) return;
+        uint64_t idx = next++;
+        TelemetryRecord& slot = records[idx & (TELEMETRY_CAPACITY - 1)];
+        slot.seq.store(2*idx + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timeNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        slot.kind = r.kind; slot.frame = r.frame;
+        slot.ms = r.ms; slot.cpuMs = r.cpuMs;
+        slot.drawCalls = r.drawCalls;
+        slot.obstacles = r.obstacles; slot.collectiblesLeft = r.collectiblesLeft; slot.skyOracles = r.skyOracles;
+        slot.particles = r.particles; slot.chunks = r.chunks;
+        slot.occlusionTested = r.occlusionTested; slot.occlusionCulled = r.occlusionCulled;
+        slot.seq.store(2*idx + 2, std::memory_order_release);
+        header->writeIndex.store(idx + 1, std::memory_order_release);
+    }
+
+private:
+    TelemetryHeader* header = nullptr;
+    TelemetryRecord* records = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t next = 0;
+    Clock::time_point start;
+    char name[64] = {0};
+};
+
+static TelemetryRing telemetry;
+static uint32_t framesDisplayed = 0;
+
+static void publishTelemetry(TelemetryKind kind, float ms, float cpuMs){
+    if(!telemetry.active()) return;
+    TelemetryRecord r;
+    r.kind = kind;
+    r.frame = framesDisplayed;
+    r.ms = ms; r.cpuMs = cpuMs;
+    r.drawCalls = kind == TELEMETRY_FRAME ? drawCallCount : 0;
+    r.obstacles = (uint32_t)obstacles.size();
+    r.collectiblesLeft = 0;
+    for(const auto& c : collectibles) if(!c.collected) r.collectiblesLeft++;
+    r.skyOracles = (uint32_t)skyOracles.size();
+    r.particles = (uint32_t)particles.size();
+    r.chunks = (uint32_t)worldStreamer.loadedCount();
+    r.occlusionTested = kind == TELEMETRY_FRAME ? (uint32_t)occlusion.tested : 0;
+    r.occlusionCulled = kind == TELEMETRY_FRAME ? (uint32_t)occlusion.culled : 0;
+    telemetry.publish(r);
+}
+
+static float millisecondsSince(TelemetryRing::Clock::time_point t0){
+    return std::chrono::duration<float, std::milli>(TelemetryRing::Clock::now() - t0).count();
+}
+
+// Called right after the swap of every displayed frame
+static void finishFrameTelemetry(TelemetryRing::Clock::time_point frameStart){
+    static TelemetryRing::Clock::time_point lastSwap;
+    framesDisplayed++;
+    float interval = lastSwap.time_since_epoch().count() ? millisecondsSince(lastSwap) : 0.0f;
+    lastSwap = TelemetryRing::Clock::now();
+    publishTelemetry(TELEMETRY_FRAME, interval, millisecondsSince(frameStart));
+}
+
+// --------------------------- Input latency ---------------------------
+// Every key/special press or release is timestamped on arrival and followed through the
+// pipeline: the first sim tick after it, the draw submission of the frame that shows it,
+// and the return of glutSwapBuffers for that frame (the closest thing to photons GLUT
+// exposes). Latencies from arrival to each stage go into 1 ms histograms per input
+// category. H toggles a HUD line, and a summary is logged every LOG_INTERVAL seconds.
+enum InputCategory { INPUT_JUMP=0, INPUT_MOVE, INPUT_CAMERA, INPUT_OTHER, INPUT_CATEGORY_COUNT };
+enum LatencyStage { LAT_TICK=0, LAT_SUBMIT, LAT_SWAP, LAT_STAGE_COUNT };
+
+static const char* inputCategoryName(InputCategory c){
+    switch(c){
+        case INPUT_JUMP: return "jump";
+        case INPUT_MOVE: return "move";
+        case INPUT_CAMERA: return "camera";
+        default: return "other";
     }
 }
 
-// --------------------------- Rendering ---------------------------
-static void drawEastAsianBackground(){
-    // Draw East Asian landscape in the background (mountains, temples, bamboo)
+struct LatencyHistogram {
+    static const int BUCKETS = 100; // 1 ms each; the last one collects everything slower
+
+    uint32_t counts[BUCKETS];
+    uint32_t total;
+    double maxMs;
+
+    void clear(){ std::memset(counts, 0, sizeof(counts)); total = 0; maxMs = 0.0; }
+
+    void add(double ms){
+        int b = std::min(BUCKETS-1, std::max(0, (int)ms));
+        counts[b]++;
+        total++;
+        maxMs = std::max(maxMs, ms);
+    }
+
+    // Upper edge of the bucket holding the p-th fraction of samples
+    double percentile(double p) const {
+        if(total == 0) return 0.0;
+        uint32_t rank = (uint32_t)std::ceil(p * total), seen = 0;
+        for(int b=0;b<BUCKETS;b++){
+            seen += counts[b];
+            if(seen >= std::max(1u, rank)) return b == BUCKETS-1 ? maxMs : (double)(b + 1);
+        }
+        return maxMs;
+    }
+};
+
+class LatencyTracer {
+public:
+    typedef std::chrono::steady_clock Clock;
+    static const int MAX_PENDING = 64;
+    static constexpr double LOG_INTERVAL = 10.0;
 
-    // Mountain range in the far background - varying heights
-    for(int i = -4; i <= 4; i++){
-        float x = i * 18.0f;
-        float height = 35.0f + (i % 3) * 12.0f;
-        float width = 12.0f + (i % 2) * 5.0f;
+    bool showHud = false;
 
-        // Mountain body - dark gray/brown stone
-        float mountainR = 0.25f + (i % 3) * 0.05f;
-        float mountainG = 0.28f + (i % 2) * 0.04f;
-        float mountainB = 0.22f + (i % 3) * 0.03f;
+    LatencyTracer(){ reset(); }
 
-        // Draw mountain as tapered shape (wider at base)
-        drawSolidBox({{x, height/3, -70.0f}, {width/2, height/3, 8.0f}},
-                     mountainR, mountainG, mountainB);
-        drawSolidBox({{x, height*0.7f, -70.0f}, {width/3, height*0.2f, 7.0f}},
-                     mountainR + 0.1f, mountainG + 0.1f, mountainB + 0.1f);
+    void reset(){
+        for(int c=0;c<INPUT_CATEGORY_COUNT;c++) for(int s=0;s<LAT_STAGE_COUNT;s++) hist[c][s].clear();
+        pendingCount = 0;
+        dropped = 0;
+        samplesSinceLog = 0;
+        lastLog = Clock::now();
+    }
 
-        // Snow caps on peaks
-        drawSolidBox({{x, height - 2.0f, -70.0f}, {width/4, 3.0f, 6.0f}},
-                     0.9f, 0.92f, 0.95f);
+    void onInput(InputCategory category){
+        if(pendingCount == MAX_PENDING){ // a stalled pipeline: forget the oldest event
+            std::memmove(&pending[0], &pending[1], sizeof(PendingEvent)*(MAX_PENDING-1));
+            pendingCount--;
+            dropped++;
+        }
+        PendingEvent& e = pending[pendingCount++];
+        e.category = category;
+        e.arrival = Clock::now();
+        e.stage = 0;
     }
 
-    // Traditional pagoda temples along the sides
-    for(int i = 0; i < 2; i++){
-        float z = -15.0f + i * 25.0f;
+    void onTick(){ advance(LAT_TICK); }
+    void onSubmit(){ advance(LAT_SUBMIT); }
 
-        // Left side temple
-        drawSolidBox({{-65.0f, 8.0f, z}, {6.0f, 8.0f, 6.0f}},
-                     0.35f, 0.25f, 0.2f); // Dark wood base
-        drawPyramid({-65.0f, 16.0f, z}, 14.0f, 6.0f, 0.6f, 0.15f, 0.15f); // Red roof
+    void onSwap(){
+        advance(LAT_SWAP);
+        int kept = 0;
+        for(int i=0;i<pendingCount;i++) if(pending[i].stage <= LAT_SWAP) pending[kept++] = pending[i];
+        pendingCount = kept;
 
-        // Right side temple
-        drawSolidBox({{65.0f, 10.0f, z + 10.0f}, {7.0f, 10.0f, 7.0f}},
-                     0.4f, 0.3f, 0.25f);
-        drawPyramid({65.0f, 20.0f, z + 10.0f}, 16.0f, 7.0f, 0.55f, 0.18f, 0.18f);
+        Clock::time_point now = Clock::now();
+        if(samplesSinceLog > 0 && std::chrono::duration<double>(now - lastLog).count() >= LOG_INTERVAL){
+            log();
+            samplesSinceLog = 0;
+            lastLog = now;
+        }
     }
 
-    // Bamboo forest effect - tall thin boxes in clusters
-    for(int cluster = 0; cluster < 5; cluster++){
-        float baseX = -50.0f + cluster * 25.0f;
-        for(int stalk = 0; stalk < 4; stalk++){
-            float x = baseX + (stalk - 2) * 1.5f;
-            float z = -55.0f + (stalk % 2) * 2.0f;
-            float height = 18.0f + (stalk % 3) * 4.0f;
-            // Bamboo stalks - green
-            drawSolidBox({{x, height/2, z}, {0.3f, height/2, 0.3f}},
-                       0.25f, 0.5f + (stalk % 2) * 0.1f, 0.25f);
+    const LatencyHistogram& histogram(InputCategory c, LatencyStage s) const { return hist[c][s]; }
+
+    void log() const {
+        for(int c=0;c<INPUT_CATEGORY_COUNT;c++){
+            const LatencyHistogram& swap = hist[c][LAT_SWAP];
+            if(swap.total == 0) continue;
+            std::printf("[latency] %-6s n=%u  tick p50 %.0f p95 %.0f | submit p50 %.0f p95 %.0f | swap p50 %.0f p95 %.0f max %.1f ms\n",
+                inputCategoryName((InputCategory)c), swap.total,
+                hist[c][LAT_TICK].percentile(0.5), hist[c][LAT_TICK].percentile(0.95),
+                hist[c][LAT_SUBMIT].percentile(0.5), hist[c][LAT_SUBMIT].percentile(0.95),
+                swap.percentile(0.5), swap.percentile(0.95), swap.maxMs);
         }
+        if(dropped) std::printf("[latency] %u events dropped before reaching the screen\n", dropped);
+        std::fflush(stdout);
     }
-}
 
-static void drawGround(){
-    // Traditional East Asian ground - earth/stone courtyard style
-    drawSolidBox(groundBox, 0.35f, 0.32f, 0.28f); // Earthy brown/tan
+private:
+    struct PendingEvent {
+        InputCategory category;
+        Clock::time_point arrival;
+        int stage; // next stage this event is waiting for
+    };
 
-    // Stone tile pattern - darker squares creating traditional courtyard look
-    glColor3f(0.28f, 0.26f, 0.24f);
-    glBegin(GL_QUADS);
-    for(int i=-35; i<=35; i+=8){
-        for(int j=-35; j<=35; j+=8){
-            // Alternating pattern like traditional stone tiles
-            if((i/8 + j/8) % 2 == 0){
-                glVertex3f((float)i, 0.21f, (float)j);
-                glVertex3f((float)i+7.5f, 0.21f, (float)j);
-                glVertex3f((float)i+7.5f, 0.21f, (float)j+7.5f);
-                glVertex3f((float)i, 0.21f, (float)j+7.5f);
-            }
+    // Stages are passed in order, so an event only reaches submit after its tick
+    void advance(LatencyStage stage){
+        Clock::time_point now = Clock::now();
+        for(int i=0;i<pendingCount;i++){
+            PendingEvent& e = pending[i];
+            if(e.stage != stage) continue;
+            hist[e.category][stage].add(std::chrono::duration<double, std::milli>(now - e.arrival).count());
+            e.stage = stage + 1;
+            if(stage == LAT_SWAP) samplesSinceLog++;
         }
     }
-    glEnd();
 
-    // Gravel/sand paths - lighter colored paths crossing the courtyard
-    glColor3f(0.5f, 0.48f, 0.42f);
-    glBegin(GL_QUADS);
-    // Horizontal path
-    glVertex3f(-40.0f, 0.22f, -2.0f);
-    glVertex3f(40.0f, 0.22f, -2.0f);
-    glVertex3f(40.0f, 0.22f, 2.0f);
-    glVertex3f(-40.0f, 0.22f, 2.0f);
-    // Vertical path
-    glVertex3f(-2.0f, 0.22f, -40.0f);
-    glVertex3f(2.0f, 0.22f, -40.0f);
-    glVertex3f(2.0f, 0.22f, 40.0f);
-    glVertex3f(-2.0f, 0.22f, 40.0f);
-    glEnd();
+    LatencyHistogram hist[INPUT_CATEGORY_COUNT][LAT_STAGE_COUNT];
+    PendingEvent pending[MAX_PENDING];
+    int pendingCount;
+    uint32_t dropped;
+    int samplesSinceLog;
+    Clock::time_point lastLog;
+};
+
+static LatencyTracer latencyTracer;
+
+static InputCategory classifyKey(unsigned char key){
+    if(key==' ') return INPUT_JUMP;
+    if(key && std::strchr("wasdWASD", key)) return INPUT_MOVE;
+    if(key && std::strchr("1234vVijkluoIJKLUO", key)) return INPUT_CAMERA;
+    return INPUT_OTHER;
 }
 
-static void drawWalls(){
-    // Traditional East Asian walls - stone/wood fortress walls
-    for(const auto&w : walls){
-        // Main wall - gray stone
-        drawSolidBox(w, 0.45f, 0.42f, 0.40f);
+static InputCategory classifySpecialKey(int key){
+    return (key==GLUT_KEY_UP || key==GLUT_KEY_DOWN || key==GLUT_KEY_LEFT || key==GLUT_KEY_RIGHT) ? INPUT_MOVE : INPUT_OTHER;
+}
 
-        // Wooden top rail - dark wood beam along top of wall
-        glColor3f(0.25f, 0.18f, 0.12f);
-        glBegin(GL_QUADS);
-        float y = w.center.y + w.half.y + 0.15f;
+// --------------------------- Text rendering ---------------------------
+// GLUT_BITMAP_9_BY_15 glyphs are rasterized once into an alpha atlas. HUD strings are laid
+// out as textured quads into a cached vertex array that is rebuilt only when the values
+// they show change, so the whole text layer costs one glDrawArrays per frame.
+static const int GLYPH_W = 9, GLYPH_H = 15, GLYPH_DESCENT = 4;
+static const int ATLAS_COLS = 16, ATLAS_W = 256, ATLAS_H = 128;
 
-        // Draw wooden beam on top
-        if(std::abs(w.half.x - w.half.z) > 0.5f){ // Long wall (back/side walls)
-            // Top beam
-            glVertex3f(w.center.x - w.half.x, y, w.center.z - w.half.z - 0.3f);
-            glVertex3f(w.center.x + w.half.x, y, w.center.z - w.half.z - 0.3f);
-            glVertex3f(w.center.x + w.half.x, y, w.center.z + w.half.z + 0.3f);
-            glVertex3f(w.center.x - w.half.x, y, w.center.z + w.half.z + 0.3f);
-        }
-        glEnd();
+struct TextVertex {
+    float x, y, u, v;
+    unsigned char r, g, b, a;
+};
 
-        // Stone texture - horizontal lines suggesting stacked stones
-        glColor3f(0.35f, 0.33f, 0.32f);
-        glBegin(GL_LINES);
-        for(float h = w.center.y - w.half.y + 0.8f; h < w.center.y + w.half.y; h += 0.8f){
-            glVertex3f(w.center.x - w.half.x, h, w.center.z - w.half.z);
-            glVertex3f(w.center.x + w.half.x, h, w.center.z - w.half.z);
-            glVertex3f(w.center.x - w.half.x, h, w.center.z + w.half.z);
-            glVertex3f(w.center.x + w.half.x, h, w.center.z + w.half.z);
-        }
-        glEnd();
+static GLuint fontAtlas = 0;
+
+// Draws the glyphs with the fixed-function pipeline into the bound framebuffer (at least the
+// atlas size; the window's must also be uncovered, so prefer rasterizeFontAtlasOffscreen)
+// and reads them back as an alpha image
+static std::vector<unsigned char> rasterizeFontAtlas(){
+    const int rows = (127 - 32 + ATLAS_COLS - 1) / ATLAS_COLS;
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glViewport(0, 0, ATLAS_W, ATLAS_H);
+    glMatrixMode(GL_PROJECTION); glLoadIdentity(); gluOrtho2D(0, ATLAS_W, 0, ATLAS_H);
+    glMatrixMode(GL_MODELVIEW); glLoadIdentity();
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_DEPTH_TEST);
+    glColor3f(1, 1, 1);
+    for(int c=32; c<127; c++){
+        int cell = c - 32;
+        glRasterPos2i((cell % ATLAS_COLS) * GLYPH_W, (cell / ATLAS_COLS) * GLYPH_H + GLYPH_DESCENT);
+        glutBitmapCharacter(GLUT_BITMAP_9_BY_15, c);
     }
+    std::vector<unsigned char> rgba(ATLAS_COLS*GLYPH_W * rows*GLYPH_H * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, ATLAS_COLS*GLYPH_W, rows*GLYPH_H, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glEnable(GL_DEPTH_TEST);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    std::vector<unsigned char> alpha(ATLAS_W*ATLAS_H, 0);
+    for(int y=0; y<rows*GLYPH_H; y++)
+        for(int x=0; x<ATLAS_COLS*GLYPH_W; x++)
+            alpha[y*ATLAS_W + x] = rgba[(y*ATLAS_COLS*GLYPH_W + x)*4];
+    return alpha;
 }
 
-static void drawPlatforms(){
-    for(int i=0;i<4;i++){
-        const Platform&p = platforms[i];
-        glColor3f(p.color[0],p.color[1],p.color[2]);
-        drawSolidBox(p.box, p.color[0],p.color[1],p.color[2]);
-        // Add a decorative rim to make platforms visually distinct
-        glColor3f(0.1f,0.1f,0.1f);
-        AABB rim = p.box; rim.half.x += 0.5f; rim.half.z += 0.5f; rim.half.y = 0.05f; rim.center.y = p.box.center.y + p.box.half.y + rim.half.y;
-        drawSolidBox(rim, 0.1f,0.1f,0.1f);
-    }
+#if USE_GL33
+// The same into a throwaway framebuffer object of the atlas size, so the result does not
+// depend on the window's size or on what covers it; false if the context has no FBOs
+static bool rasterizeFontAtlasOffscreen(std::vector<unsigned char>& alpha){
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    bool supported = (version && std::atoi(version) >= 3) || (extensions && std::strstr(extensions, "GL_ARB_framebuffer_object"));
+    if(!supported) return false;
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    GLuint fbo, color;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, ATLAS_W, ATLAS_H);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if(complete) alpha = rasterizeFontAtlas();
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previous);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color);
+    return complete;
 }
+#endif
 
-static void drawCollectibles(){
-    for(const auto&c : collectibles){ if(!c.collected) drawCollectibleGeom(c); }
+// A core profile has no GL_ALPHA textures, so there the atlas is a red one
+static void uploadFontAtlas(const std::vector<unsigned char>& alpha){
+    glGenTextures(1, &fontAtlas);
+    glBindTexture(GL_TEXTURE_2D, fontAtlas);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if(coreProfile) glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_W, ATLAS_H, 0, GL_RED, GL_UNSIGNED_BYTE, alpha.data());
+    else glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_W, ATLAS_H, 0, GL_ALPHA, GL_UNSIGNED_BYTE, alpha.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
-static void drawFeatures(){
-    for(int i=0;i<4;i++) drawFeatureObj(features[i]);
+static std::vector<unsigned char> coreFontPixels; // --gl33: rasterized before the core context exists
+
+// Needs a current context; call before the frame clears (the back buffer is only drawn
+// into where the context has no FBOs)
+static void buildFontAtlas(){
+    if(coreProfile){ uploadFontAtlas(coreFontPixels); return; }
+#if USE_GL33
+    std::vector<unsigned char> alpha;
+    if(rasterizeFontAtlasOffscreen(alpha)){ uploadFontAtlas(alpha); return; }
+#endif
+    uploadFontAtlas(rasterizeFontAtlas());
 }
 
-static void drawSkyOracles(){
-    static float time = 0.0f;
-    time += 0.016f; // Approximate frame time
-    
-    for(const auto& o : skyOracles){
-        float bob = sinf(time + o.rotation * 0.01f) * 0.6f;
-        Vec3 center = {o.pos.x, o.pos.y + bob, o.pos.z};
-        float pulse = 0.5f + 0.5f*sinf(time * 2.0f);
-        
-        drawGlowingOrb(center, o.radius * 0.5f * (0.8f + 0.2f*pulse), o.color, 0.6f + 0.4f*pulse);
-        drawHaloRing({center.x, center.y - 0.2f, center.z}, o.radius * 0.4f, o.radius, o.color, 0.3f + 0.4f*pulse);
-
-        glPushMatrix();
-        glTranslatef(center.x, center.y, center.z);
-        glRotatef(o.rotation, 0, 1, 0);
-        glColor3f(o.color[0]*0.85f, o.color[1]*0.85f, o.color[2]*0.85f);
-        glBegin(GL_LINE_LOOP);
-        for(int i=0;i<48;i++){
-            float ang = (float)i/48.0f * 2.0f * PI_F;
-            glVertex3f(cosf(ang) * o.radius * 0.85f, 0.0f, sinf(ang) * o.radius * 0.85f);
+class TextLayer {
+public:
+    void clear(){ verts.clear(); }
+
+    // (x,y) is the baseline origin, same as glRasterPos2i for the bitmap font
+    void add(int x, int y, const char* s, float r, float g, float b){
+        unsigned char cr = (unsigned char)(r*255.0f), cg = (unsigned char)(g*255.0f), cb = (unsigned char)(b*255.0f);
+        for(const char* p=s; *p; ++p, x+=GLYPH_W){
+            int c = (unsigned char)*p;
+            if(c<=32 || c>=127) continue;
+            int cell = c - 32;
+            float u0 = (float)((cell % ATLAS_COLS) * GLYPH_W) / ATLAS_W, u1 = u0 + (float)GLYPH_W / ATLAS_W;
+            float v0 = (float)((cell / ATLAS_COLS) * GLYPH_H) / ATLAS_H, v1 = v0 + (float)GLYPH_H / ATLAS_H;
+            float x0 = (float)x, x1 = (float)(x + GLYPH_W);
+            float y0 = (float)(y - GLYPH_DESCENT), y1 = y0 + GLYPH_H;
+            verts.push_back({x0, y0, u0, v0, cr, cg, cb, 255});
+            verts.push_back({x1, y0, u1, v0, cr, cg, cb, 255});
+            verts.push_back({x1, y1, u1, v1, cr, cg, cb, 255});
+            verts.push_back({x0, y1, u0, v1, cr, cg, cb, 255});
         }
-        glEnd();
-        glPopMatrix();
     }
-}
 
-static void drawObstacles(){
-    for(const auto& obs : obstacles){
-        drawSolidBox(obs.box, obs.color[0], obs.color[1], obs.color[2]);
+    // One draw call in window coordinates
+    void draw() const {
+        if(verts.empty() || !fontAtlas) return;
+        if(gfx->drawTextQuads(&verts[0], sizeof(TextVertex), (int)verts.size(), fontAtlas, winW, winH)) return;
+        glMatrixMode(GL_PROJECTION); glPushMatrix(); glLoadIdentity();
+        gluOrtho2D(0, winW, 0, winH);
+        glMatrixMode(GL_MODELVIEW); glPushMatrix(); glLoadIdentity();
+        glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, fontAtlas);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &verts[0].x);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &verts[0].u);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), &verts[0].r);
+        drawCallCount++;
+        glDrawArrays(GL_QUADS, 0, (GLsizei)verts.size());
+        glPopClientAttrib();
+        glPopAttrib();
+        glMatrixMode(GL_MODELVIEW); glPopMatrix();
+        glMatrixMode(GL_PROJECTION); glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
     }
-}
 
-static void drawHUD(){
-    // 2D overlay
-    glMatrixMode(GL_PROJECTION); glPushMatrix(); glLoadIdentity();
-    gluOrtho2D(0, winW, 0, winH);
-    glMatrixMode(GL_MODELVIEW); glPushMatrix(); glLoadIdentity();
-
-    auto drawText = [&](int x,int y,const char* s){
-        glRasterPos2i(x,y);
-        for(const char* p=s; *p; ++p) glutBitmapCharacter(GLUT_BITMAP_9_BY_15, *p);
-    };
-
-    char buf[128];
-    snprintf(buf, sizeof(buf), "Time: %ds", (int)std::max(0.0f, gameTime));
-    glColor3f(1,1,1); drawText(10, winH-20, buf);
-    snprintf(buf, sizeof(buf), "Collected: [%d/%d] [%d/%d] [%d/%d] [%d/%d]",
-        collectedPerPlatform[0], totalCollectiblesPerPlatform,
-        collectedPerPlatform[1], totalCollectiblesPerPlatform,
-        collectedPerPlatform[2], totalCollectiblesPerPlatform,
-        collectedPerPlatform[3], totalCollectiblesPerPlatform);
-    drawText(10, winH-40, buf);
+private:
+    std::vector<TextVertex> verts;
+};
 
-    if(gameState == WON){ 
-        glColor3f(0.2f,1.0f,0.3f); 
-        drawText(winW/2-60, winH-60, "GAME WIN!"); 
+// Everything the HUD text depends on; the layout is rebuilt only when this changes
+struct HudKey {
+    int seconds;
+    int collected[4];
+    GameState state;
+    bool autopilot, multiView;
+    int quality;
+    int w, h;
+    int latencyMs[INPUT_CATEGORY_COUNT][2]; // swap-stage p50/p95, all -1 when the overlay is off
+    bool operator==(const HudKey& o) const {
+        return seconds==o.seconds && std::equal(collected, collected+4, o.collected) &&
+               state==o.state && autopilot==o.autopilot && multiView==o.multiView && quality==o.quality && w==o.w && h==o.h &&
+               std::memcmp(latencyMs, o.latencyMs, sizeof(latencyMs))==0;
     }
+};
+
+static TextLayer hudText;
+static HudKey hudKey;
+static bool hudKeyValid = false;
 
-    if(gameState == LOST){ 
-        glColor3f(1.0f,0.2f,0.2f); 
-        drawText(winW/2-70, winH/2, "GAME OVER"); 
-        drawText(winW/2-90, winH/2-20, "Press ESC to Restart"); 
+static void drawHUD(){
+    HudKey key;
+    key.seconds = (int)std::max(0.0f, gameTime);
+    for(int i=0;i<4;i++) key.collected[i] = collectedPerPlatform[i];
+    key.state = gameState;
+    key.autopilot = navBot.enabled;
+    key.multiView = multiView && gameState != LOST;
+    key.quality = quality.level();
+    key.w = winW; key.h = winH;
+    for(int c=0;c<INPUT_CATEGORY_COUNT;c++){
+        const LatencyHistogram& hist = latencyTracer.histogram((InputCategory)c, LAT_SWAP);
+        key.latencyMs[c][0] = latencyTracer.showHud ? (int)hist.percentile(0.5) : -1;
+        key.latencyMs[c][1] = latencyTracer.showHud ? (int)hist.percentile(0.95) : -1;
     }
 
-    glMatrixMode(GL_MODELVIEW); glPopMatrix();
-    glMatrixMode(GL_PROJECTION); glPopMatrix();
+    if(!hudKeyValid || !(key == hudKey)){
+        hudKey = key; hudKeyValid = true;
+        hudText.clear();
+        char buf[128];
+        if(gameState != LOST){
+            snprintf(buf, sizeof(buf), "Time: %ds", key.seconds);
+            hudText.add(10, winH-20, buf, 1,1,1);
+            snprintf(buf, sizeof(buf), "Collected: [%d/%d] [%d/%d] [%d/%d] [%d/%d]",
+                collectedPerPlatform[0], totalCollectiblesPerPlatform,
+                collectedPerPlatform[1], totalCollectiblesPerPlatform,
+                collectedPerPlatform[2], totalCollectiblesPerPlatform,
+                collectedPerPlatform[3], totalCollectiblesPerPlatform);
+            hudText.add(10, winH-40, buf, 1,1,1);
+            if(navBot.enabled) hudText.add(10, winH-60, "Autopilot", 0.6f,0.9f,1.0f);
+            snprintf(buf, sizeof(buf), "Quality %d: %s%s", key.quality, QUALITY_LEVELS[key.quality].name, quality.adaptive ? "" : " (fixed)");
+            hudText.add(winW-170, key.multiView ? winH-40 : winH-20, buf, key.quality ? 1.0f : 0.7f, key.quality ? 0.8f : 0.9f, key.quality ? 0.5f : 0.7f);
+        }
+
+        if(key.multiView){
+            static const char* labels[4] = { "Follow", "Top", "Side", "Front" };
+            for(int i=0;i<4;i++){
+                int x = (i & 1) ? winW/2 : 0, top = (i & 2) ? winH/2 : winH;
+                hudText.add(x + winW/2 - 70, top - 20, labels[i], 1.0f,1.0f,0.6f);
+            }
+        }
+
+        if(latencyTracer.showHud){
+            snprintf(buf, sizeof(buf), "Input->swap p50/p95 ms: jump %d/%d  move %d/%d  camera %d/%d  other %d/%d",
+                key.latencyMs[INPUT_JUMP][0], key.latencyMs[INPUT_JUMP][1], key.latencyMs[INPUT_MOVE][0], key.latencyMs[INPUT_MOVE][1],
+                key.latencyMs[INPUT_CAMERA][0], key.latencyMs[INPUT_CAMERA][1], key.latencyMs[INPUT_OTHER][0], key.latencyMs[INPUT_OTHER][1]);
+            hudText.add(10, 10, buf, 1.0f,0.9f,0.5f);
+        }
+
+        if(gameState == WON){
+            hudText.add(winW/2-60, winH-60, "GAME WIN!", 0.2f,1.0f,0.3f);
+        }
+
+        if(gameState == LOST){
+            hudText.add(winW/2-70, winH/2, "GAME OVER", 1.0f,0.2f,0.2f);
+            hudText.add(winW/2-90, winH/2-20, "Press ESC to Restart", 1.0f,0.2f,0.2f);
+        }
+    }
+    hudText.draw();
 }
 
 static void drawGameOverScene(){
@@ -1184,25 +6693,23 @@ static void drawGameOverScene(){
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Fixed camera for Game Over scene - looking at center from above and behind
-    glMatrixMode(GL_PROJECTION); glLoadIdentity();
-    gluPerspective(60.0, (double)winW/(double)winH, 0.1, 500.0);
-    glMatrixMode(GL_MODELVIEW); glLoadIdentity();
-    gluLookAt(0, 15, 25,   // eye position
-              0, 5, 0,     // look at center above ground
-              0, 1, 0);    // up vector
+    gfx->perspective(60.0, (double)winW/(double)winH, 0.1, 500.0);
+    gfx->lookAt({0, 15, 25},   // eye position
+                {0, 5, 0},     // look at center above ground
+                {0, 1, 0});    // up vector
 
     glEnable(GL_DEPTH_TEST);
-    glShadeModel(GL_FLAT);
+    if(!coreProfile) glShadeModel(GL_FLAT);
 
     // Draw each flying oracle
     for(int i=0; i<4; i++){
-        glPushMatrix();
+        gfx->pushMatrix();
 
         // Position oracle
-        glTranslatef(flyingOracles[i].pos.x, flyingOracles[i].pos.y, flyingOracles[i].pos.z);
+        gfx->translate(flyingOracles[i].pos.x, flyingOracles[i].pos.y, flyingOracles[i].pos.z);
 
         // Apply simple Y-axis rotation
-        glRotatef(flyingOracles[i].rotation, 0, 1, 0);
+        gfx->rotate(flyingOracles[i].rotation, 0, 1, 0);
 
         float r = flyingOracles[i].color[0];
         float g = flyingOracles[i].color[1];
@@ -1222,7 +6729,7 @@ static void drawGameOverScene(){
                 float bodyCol[3]={std::min(1.0f, r*1.1f), std::min(1.0f, g*0.6f + 0.2f), std::min(1.0f, b*0.5f + 0.15f)};
                 float frameCol[3]={0.45f, 0.2f, 0.12f};
                 float ropeCol[3]={0.95f, 0.9f, 0.8f};
-                drawTaikoDrum(1.1f, 0.9f, bodyCol, frameCol, ropeCol);
+                drawTaikoDrum<1100, 900>(bodyCol, frameCol, ropeCol);
             } break;
             case 3: {
                 float stoneCol[3]={0.65f + 0.2f*r, 0.6f + 0.2f*g, 0.55f + 0.2f*b};
@@ -1231,35 +6738,24 @@ static void drawGameOverScene(){
             } break;
         }
 
-        glPopMatrix();
+        gfx->popMatrix();
     }
 
-    // Draw "GAME OVER" text overlay
-    glMatrixMode(GL_PROJECTION); glPushMatrix(); glLoadIdentity();
-    gluOrtho2D(0, winW, 0, winH);
-    glMatrixMode(GL_MODELVIEW); glPushMatrix(); glLoadIdentity();
-
-    auto drawText = [&](int x,int y,const char* s){
-        glRasterPos2i(x,y);
-        for(const char* p=s; *p; ++p) glutBitmapCharacter(GLUT_BITMAP_9_BY_15, *p);
-    };
-
-    glColor3f(1.0f,0.2f,0.2f);
-    drawText(winW/2-70, winH/2, "GAME OVER");
-    drawText(winW/2-90, winH/2-20, "Press ESC to Restart");
+    particles.draw(quality.current().particleStride);
+    renderQueue.flush();
+    gfx->flush();
 
-    glMatrixMode(GL_MODELVIEW); glPopMatrix();
-    glMatrixMode(GL_PROJECTION); glPopMatrix();
+    // Draw "GAME OVER" text overlay
+    drawHUD();
 }
 
-static void setCamera(){
-    glMatrixMode(GL_PROJECTION); glLoadIdentity();
-    gluPerspective(60.0, (double)winW/(double)winH, 0.1, 500.0);
-    glMatrixMode(GL_MODELVIEW); glLoadIdentity();
+// Loads the projection and look-at for a camera preset
+static void applyCamera(CameraPreset mode, double aspect){
+    gfx->perspective(60.0, aspect, 0.1, 500.0);
 
     Vec3 eye=camPos, target=camTarget, up=camUp;
 
-    if(camMode==CAM_FOLLOW){
+    if(mode==CAM_FOLLOW){
         // Fixed-angle semi top-down follow camera (like isometric/Diablo style)
         // Camera follows player position but maintains fixed viewing angle
         float camHeight = 20.0f;  // height above player
@@ -1277,19 +6773,181 @@ static void setCamera(){
         target.z = playerPos.z;
 
         up = {0, 1, 0};
+
+        // Pull the camera in front of anything solid between it and the player
+        Vec3 head = {playerPos.x, playerPos.y + playerHalf.y, playerPos.z};
+        Vec3 toEye = sub(eye, head);
+        float dist = std::sqrt(toEye.x*toEye.x + toEye.y*toEye.y + toEye.z*toEye.z);
+        Vec3 dir = mul(toEye, 1.0f/dist);
+        CastHit hit;
+        if(originAtHome() && worldBVH.castBox({head, {0.25f, 0.25f, 0.25f}}, dir, dist, WP_MASK_SOLID, &hit)) eye = add(head, mul(dir, std::max(hit.t, 1.0f)));
+    }
+    else if(mode==CAM_TOP){ eye = {0.0f, 80.0f, 0.01f}; target = {0,0,0}; up={0,0,-1}; }
+    else if(mode==CAM_SIDE){ eye = {55.0f, 15.0f, 0.01f}; target = {0,0,0}; up={0,1,0}; } // Moved from 100 to 55 to be between play area and temples
+    else if(mode==CAM_FRONT){ eye = {0.01f, 15.0f, 80.0f}; target = {0,0,0}; up={0,1,0}; }
+
+    gfx->lookAt(eye, target, up);
+}
+
+static void setCamera(){ applyCamera(camMode, (double)winW/(double)winH); }
+
+// --------------------------- Multi-view ---------------------------
+// Surveillance layout: the follow, top, side and front presets in the four quadrants of
+// the window. The scene is walked once per frame into a list of items with world-space
+// bounds; each view takes its frustum from the preset's matrices and draws only the items
+// that touch it and, for features, oracles and collectibles, that its occlusion buffer
+// does not hide. Meshes, baked chunks and evaluated animation are shared by all views, and
+// the static layer cache is bypassed (it holds one full-window view).
+enum SceneItemKind { SCENE_BACKGROUND, SCENE_GROUND, SCENE_WALL, SCENE_PLATFORM, SCENE_OBSTACLE, SCENE_FEATURE,
+                     SCENE_SKY_ORACLE, SCENE_COLLECTIBLE, SCENE_CHUNK, SCENE_PLAYER };
+
+struct SceneItem {
+    AABB bounds;
+    int kind, index;
+};
+
+static void collectSceneItems(ArenaVector<SceneItem>& items){
+    items.attach(frameArena, 128);
+    if(originAtHome()){
+        items.push_back({{{0.0f, 30.0f, -22.0f}, {80.0f, 30.0f, 58.0f}}, SCENE_BACKGROUND, 0});
+        items.push_back({{groundBox.center, {std::max(groundBox.half.x, 40.0f), groundBox.half.y + 0.1f, std::max(groundBox.half.z, 40.0f)}}, SCENE_GROUND, 0});
+        for(size_t i=0;i<walls.size();i++){
+            AABB b = walls[i]; b.half = add(b.half, {0.3f, 0.2f, 0.3f});
+            items.push_back({b, SCENE_WALL, (int)i});
+        }
+        for(int i=0;i<4;i++){
+            AABB b = platforms[i].box; b.half = add(b.half, {0.5f, 0.1f, 0.5f});
+            items.push_back({b, SCENE_PLATFORM, i});
+        }
+        for(size_t i=0;i<obstacles.size();i++) items.push_back({obstacles[i].box, SCENE_OBSTACLE, (int)i});
+        for(int i=0;i<4;i++) items.push_back({featureBounds(i), SCENE_FEATURE, i});
+        for(size_t i=0;i<skyOracles.size();i++) items.push_back({skyOracleBounds(skyOracles[i]), SCENE_SKY_ORACLE, (int)i});
+        for(size_t i=0;i<collectibles.size();i++)
+            if(!collectibles[i].collected) items.push_back({collectibleBounds(collectibles[i]), SCENE_COLLECTIBLE, (int)i});
+    }
+    for(int i=0;i<worldStreamer.loadedCount();i++) items.push_back({worldStreamer.chunkBounds(i), SCENE_CHUNK, i});
+    items.push_back({{add(playerPos, {0.0f, 1.0f, 0.0f}), {1.2f, 1.7f, 1.2f}}, SCENE_PLAYER, 0});
+}
+
+static void drawSceneItem(const SceneItem& item){
+    switch(item.kind){
+        case SCENE_BACKGROUND:  drawEastAsianBackground(); break;
+        case SCENE_GROUND:      drawGround(); break;
+        case SCENE_WALL:        drawWall(walls[item.index]); break;
+        case SCENE_PLATFORM:    drawPlatform(platforms[item.index]); break;
+        case SCENE_OBSTACLE: {
+            const Obstacle& o = obstacles[item.index];
+            drawSolidBox(o.box, o.color[0], o.color[1], o.color[2]);
+        } break;
+        case SCENE_FEATURE:     drawFeatureObj(features[item.index]); break;
+        case SCENE_SKY_ORACLE:  drawSkyOracle(skyOracles[item.index]); break;
+        case SCENE_COLLECTIBLE: drawCollectibleGeom(collectibles[item.index]); break;
+        case SCENE_CHUNK:       worldStreamer.drawChunk(item.index); break;
+        case SCENE_PLAYER:      drawPlayer(); break;
+    }
+}
+
+static const CameraPreset MULTI_VIEW_PRESETS[4] = { CAM_FOLLOW, CAM_TOP, CAM_SIDE, CAM_FRONT };
+
+// Quadrant origin for view i in a frameW x frameH frame: follow top-left, top top-right,
+// side bottom-left, front bottom-right
+static void multiViewRect(int i, int frameW, int frameH, int& x, int& y, int& w, int& h){
+    w = frameW / 2; h = frameH / 2;
+    x = (i & 1) ? w : 0;
+    y = (i & 2) ? 0 : frameH - h;
+}
+
+static int multiViewDrawn = 0, multiViewCulled = 0; // last frame, all views
+
+// Draws the quadrants into the lower-left frameW x frameH pixels (the window, or less when
+// the resolution is scaled down)
+static void drawMultiView(int frameW, int frameH){
+    ArenaVector<SceneItem> items;
+    collectSceneItems(items);
+
+    multiViewDrawn = multiViewCulled = 0;
+    updateLod.clearViews();
+    glEnable(GL_SCISSOR_TEST);
+    for(int v=0;v<4;v++){
+        int x, y, w, h;
+        multiViewRect(v, frameW, frameH, x, y, w, h);
+        if(w <= 0 || h <= 0) continue;
+        glViewport(x, y, w, h);
+        glScissor(x, y, w, h);
+        applyCamera(MULTI_VIEW_PRESETS[v], (double)w/(double)h);
+        Frustum frustum;
+        frustum.fromCurrentMatrices();
+        updateLod.addView(frustum);
+        if(originAtHome()) occlusion.build();
+        for(const SceneItem& item : items){
+            if(!frustum.intersects(item.bounds)){ multiViewCulled++; continue; }
+            bool occludable = item.kind == SCENE_FEATURE || item.kind == SCENE_SKY_ORACLE || item.kind == SCENE_COLLECTIBLE;
+            if(occludable && !occlusion.visible(item.bounds)){ multiViewCulled++; continue; }
+            drawSceneItem(item);
+            multiViewDrawn++;
+        }
+        particles.draw(quality.current().particleStride);
+        renderQueue.flush(); // halos and orbs were captured with this view's modelview
+        gfx->flush();
+    }
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, winW, winH);
+    setCamera();
+}
+
+// The single-view world after the camera is set, drawn at w x h. Fixed presets reuse the
+// captured static layer when useStaticLayer is set; the layer is GL-only, so other backends
+// pass false.
+static void drawScene(bool useStaticLayer, int w, int h){
+    // Draw East Asian environment; the courtyard is only there while the streaming origin is home
+    if(originAtHome()){
+        bool cacheView = useStaticLayer && StaticLayerCache::cacheable(camMode);
+        if(!cacheView || !staticLayer.restore(camMode, w, h)){
+            if(gfx->beginRetained(RETAIN_COURTYARD + quality.level())){
+                drawEastAsianBackground();
+                drawGround();
+                drawWalls();
+                drawPlatforms();
+                drawObstacles(false);
+                gfx->endRetained();
+            }
+            if(cacheView) staticLayer.capture(camMode, w, h);
+        }
+        occlusion.build();
+        drawObstacles(true);
+        drawFeatures();
+        drawSkyOracles();
+        drawCollectibles();
     }
-    else if(camMode==CAM_TOP){ eye = {0.0f, 80.0f, 0.01f}; target = {0,0,0}; up={0,0,-1}; }
-    else if(camMode==CAM_SIDE){ eye = {55.0f, 15.0f, 0.01f}; target = {0,0,0}; up={0,1,0}; } // Moved from 100 to 55 to be between play area and temples
-    else if(camMode==CAM_FRONT){ eye = {0.01f, 15.0f, 80.0f}; target = {0,0,0}; up={0,1,0}; }
+    worldStreamer.draw();
+    drawPlayer();
+    particles.draw(quality.current().particleStride);
+    renderQueue.flush();
+    gfx->flush();
+}
 
-    gluLookAt(eye.x,eye.y,eye.z, target.x,target.y,target.z, up.x,up.y,up.z);
+// After the swap of every displayed frame. The governor gets the cost up to submit: the
+// swap can block for anything up to a refresh interval waiting on vsync, and that wait
+// would read as load on a machine that is keeping up easily
+static void finishFrame(TelemetryRing::Clock::time_point frameStart, float submitMs){
+    finishFrameTelemetry(frameStart);
+    if(quality.onFrame(submitMs)) staticLayer.invalidate(); // its background detail changed
 }
 
 static void display(){
+    TelemetryRing::Clock::time_point frameStart = TelemetryRing::Clock::now();
+    drawCallCount = 0;
+    occlusion.resetStats();
+    if(!fontAtlas) buildFontAtlas(); // first frame, before anything is drawn
+
     if(gameState == LOST){
         // Replace entire scene with Game Over scene showing flying oracles
         drawGameOverScene();
+        float submitMs = millisecondsSince(frameStart);
+        latencyTracer.onSubmit();
         glutSwapBuffers();
+        latencyTracer.onSwap();
+        finishFrame(frameStart, submitMs);
         return;
     }
 
@@ -1298,25 +6956,130 @@ static void display(){
     glClearColor(0.65f, 0.7f, 0.75f, 1); // Soft blue-gray for misty sky
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    setCamera();
-
     glEnable(GL_DEPTH_TEST);
-    glShadeModel(GL_FLAT);
+    if(!coreProfile) glShadeModel(GL_FLAT);
 
-    // Draw East Asian environment
-    drawEastAsianBackground();
-    drawGround();
-    drawWalls();
-    drawPlatforms();
-    drawObstacles();
-    drawFeatures();
-    drawSkyOracles();
-    drawCollectibles();
-    drawPlayer();
+    // Below full scale the world goes into the lower-left corner and is stretched over the window
+    int frameW, frameH;
+    ResolutionScaler::scaledSize(coreProfile ? 1.0f : quality.current().renderScale, winW, winH, frameW, frameH);
 
+    if(multiView){
+        drawMultiView(frameW, frameH);
+    } else {
+        glViewport(0, 0, frameW, frameH);
+        setCamera();
+        Frustum view;
+        view.fromCurrentMatrices();
+        updateLod.clearViews();
+        updateLod.addView(view);
+        drawScene(!coreProfile, frameW, frameH); // the static layer cache copies pixels with fixed-function calls
+    }
+    if(frameW != winW || frameH != winH) resolutionScaler.upsample(frameW, frameH, winW, winH);
     drawHUD();
 
+    float submitMs = millisecondsSince(frameStart);
+    latencyTracer.onSubmit();
     glutSwapBuffers();
+    latencyTracer.onSwap();
+    finishFrame(frameStart, submitMs);
+}
+
+// --------------------------- Frame pacing ---------------------------
+// idle() waits for the next tick deadline instead of spinning: it sleeps until shortly
+// before the deadline and spins the rest, with the spin window tracking how much the OS
+// oversleeps. In low-power mode a redraw is only posted when something the player
+// controls or reads changed; ambient motion (oracles, moving obstacles) is redrawn at a
+// reduced rate and a fully static scene is not redrawn at all.
+struct VisibleState {
+    Vec3 playerPos, camPos, camTarget;
+    float playerYawDeg;
+    CameraPreset camMode;
+    bool multiView;
+    GameState state;
+    int hudSeconds, collectedTotal;
+    bool autopilot;
+
+    bool operator==(const VisibleState& o) const {
+        return std::memcmp(&playerPos, &o.playerPos, sizeof(Vec3))==0 &&
+               std::memcmp(&camPos, &o.camPos, sizeof(Vec3))==0 &&
+               std::memcmp(&camTarget, &o.camTarget, sizeof(Vec3))==0 &&
+               playerYawDeg==o.playerYawDeg && camMode==o.camMode && multiView==o.multiView && state==o.state &&
+               hudSeconds==o.hudSeconds && collectedTotal==o.collectedTotal && autopilot==o.autopilot;
+    }
+};
+
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    float targetHz = 60.0f;   // 0 = uncapped
+    float ambientHz = 15.0f;  // low-power redraw rate when only ambient animation moves
+    bool lowPower = false;
+
+    // Blocks until the next tick is due
+    void waitForNextTick(){
+        if(targetHz <= 0.0f) return;
+        const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetHz));
+        Clock::time_point now = Clock::now();
+        if(nextTick.time_since_epoch().count()==0 || now - nextTick > period) nextTick = now; // first tick or fell behind: don't burst
+        sleepUntil(nextTick);
+        nextTick += period;
+    }
+
+    bool shouldRedraw(const VisibleState& visible, bool ambientMotion){
+        Clock::time_point now = Clock::now();
+        bool changed = forceRedraw || !(visible == lastDrawn);
+        bool ambientDue = ambientMotion && (now - lastRedraw) >= std::chrono::duration<double>(1.0 / std::max(1.0f, ambientHz));
+        if(lowPower && !changed && !ambientDue) return false;
+        lastDrawn = visible;
+        lastRedraw = now;
+        forceRedraw = false;
+        return true;
+    }
+
+    void invalidate(){ forceRedraw = true; }
+
+private:
+    void sleepUntil(Clock::time_point deadline){
+        Clock::time_point now = Clock::now();
+        Clock::duration spin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::max(0.0005, oversleepEma * 1.5)));
+        if(deadline - now > spin){
+            Clock::time_point wake = deadline - spin;
+            std::this_thread::sleep_until(wake);
+            double over = std::chrono::duration<double>(Clock::now() - wake).count();
+            oversleepEma += (std::max(0.0, over) - oversleepEma) * 0.1;
+        }
+        while(Clock::now() < deadline) std::this_thread::yield();
+    }
+
+    Clock::time_point nextTick, lastRedraw;
+    VisibleState lastDrawn;
+    double oversleepEma = 0.001;
+    bool forceRedraw = true;
+};
+
+static FramePacer framePacer;
+
+static VisibleState captureVisibleState(){
+    VisibleState v;
+    v.playerPos = playerPos; v.camPos = camPos; v.camTarget = camTarget;
+    v.playerYawDeg = playerYawDeg;
+    v.camMode = camMode;
+    v.multiView = multiView;
+    v.state = gameState;
+    v.hudSeconds = (int)std::max(0.0f, gameTime);
+    v.collectedTotal = collectedPerPlatform[0] + collectedPerPlatform[1] + collectedPerPlatform[2] + collectedPerPlatform[3];
+    v.autopilot = navBot.enabled;
+    return v;
+}
+
+// Whether anything moves on screen without input: live particles, the sky oracles that
+// bob and spin throughout play, and on the game over screen the oracles until they rest
+static bool hasAmbientMotion(){
+    if(particles.size()) return true;
+    if(gameState != LOST) return true;
+    for(int i=0;i<4;i++) if(flyingOracles[i].spin != 0.0f) return true;
+    return false;
 }
 
 // --------------------------- Input & update ---------------------------
@@ -1344,81 +7107,454 @@ static void updatePlayerMovement(float dt){
     if(keyDown['a'] || specialDown[GLUT_KEY_LEFT]) move.x -= 1;
     if(keyDown['d'] || specialDown[GLUT_KEY_RIGHT]) move.x += 1;
 
-    float len = std::sqrt(move.x*move.x + move.z*move.z);
-    if(len>0.0001f){
-        move = mul(move, 1.0f/len);
-        tryMovePlayer(mul(move, playerSpeed*dt));
-        // face movement direction
-        playerYawDeg = std::atan2f(move.x, -move.z) * 180.0f / 3.14159265f; // z- forward
-    }
-
-    // Vertical movement (jumping and gravity)
-    playerOnGround = isPlayerOnSurface();
-
-    // Apply gravity
-    if(!playerOnGround){
-        playerVelY += GRAVITY * dt;
-    } else {
-        // On ground, reset vertical velocity
-        if(playerVelY < 0.0f) playerVelY = 0.0f;
+    if(navBot.enabled && originAtHome()){
+        bool wantJump = false;
+        move = updateNavBot(dt, wantJump);
+        if(wantJump && playerOnGround){ playerVelY = JUMP_VELOCITY; playerOnGround = false; }
     }
 
-    // Update vertical position
-    float nextY = playerPos.y + playerVelY * dt;
-
-    // Check if new position would collide
-    AABB testBox = { playerPos, playerHalf };
-    testBox.center.y = nextY;
+    PlayerBody body = { playerPos, playerVelY, playerYawDeg, playerOnGround };
+    stepPlayerBody(body, move, dt, LiveLevel());
+    playerPos = body.pos;
+    playerVelY = body.velY;
+    playerYawDeg = body.yawDeg;
+    playerOnGround = body.onGround;
+}
 
-    // Only update Y if no collision or moving down to ground
-    if(!collidesWithWorld(testBox) || nextY < playerPos.y){
-        playerPos.y = nextY;
+// One simulation tick; shared by idle() and the headless diagnostics
+static void stepGame(float dt){
+    gameTimers.advance(dt, gameEvents); // may end the round (EVT_TIME_UP)
+    if(gameState == PLAYING) gameTime = std::max(0.0f, countdownRemaining());
+    updateLod.scheduleAnimation();
 
-        // Clamp to ground level (minimum Y position)
-        if(playerPos.y < 1.0f){
-            playerPos.y = 1.0f;
-            playerVelY = 0.0f;
-            playerOnGround = true;
-        }
+    if(gameState == LOST){
+        // Update flying oracles animation
+        updateLod.clearViews(); // the game over scene shows none of the scheduled entities
+        updateFlyingOracles(dt);
     } else {
-        // Hit ceiling or obstacle
-        if(playerVelY > 0.0f) playerVelY = 0.0f;
+        // Normal game updates
+        updateCameraFreeMove(dt);
+        updatePlayerMovement(dt);
+        if(originAtHome()) updateCollectibles(); // the courtyard is out of reach otherwise
+        updateFeatures(dt);
+        updateObstacles(dt);
     }
+
+    updateAnimation(dt);
+    particles.update(dt, groundTopY(), originAtHome() ? &supportMap.particleFloors() : nullptr);
+    updateLod.endTick();
 }
 
 static void idle(){
+    framePacer.waitForNextTick();
+    TelemetryRing::Clock::time_point tickStart = TelemetryRing::Clock::now();
+
     int t = glutGet(GLUT_ELAPSED_TIME);
     if(prevTicks==0) prevTicks=t;
     float dt = (t - prevTicks) / 1000.0f;
     prevTicks = t;
 
-    if(gameState == PLAYING){
-        gameTime -= dt;
-        if(gameTime<=0.0f){
-            gameTime=0.0f;
-            gameState = LOST;
-            playOnce(audioLose);
-            initFlyingOracles();
+    frameArena.reset();
+    SimSnapshot snap;
+    if(keyDown['z'] || keyDown['Z']){
+        // Hold Z to run the recorded history backwards one tick per tick
+        if(history.stepBack(snap)) restoreSnapshot(snap);
+    } else {
+        stepGame(dt);
+        if(rewindEnabled){
+            captureSnapshot(snap);
+            history.record(snap);
         }
     }
+    float stepMs = millisecondsSince(tickStart);
+    latencyTracer.onTick();
+    worldStreamer.update(playerPos);
+    float tickMs = millisecondsSince(tickStart);
+    publishTelemetry(TELEMETRY_TICK, stepMs, tickMs);
+    quality.onTick(tickMs);
+
+    if(framePacer.shouldRedraw(captureVisibleState(), hasAmbientMotion())) glutPostRedisplay();
+}
 
-    if(gameState == LOST){
-        // Update flying oracles animation
-        updateFlyingOracles(dt);
-    } else {
-        // Normal game updates
-        updateCameraFreeMove(dt);
-        updatePlayerMovement(dt);
-        updateCollectibles();
-        updateFeatures(dt);
-        updateObstacles(dt);
-        updateSkyOracles(dt);
+// --particle-bench [count] [ticks]: kernel throughput without a window
+static int runParticleBenchmark(int argc, char** argv){
+    int n = argc>2 ? std::max(1, atoi(argv[2])) : 120000;
+    int ticks = argc>3 ? std::max(1, atoi(argv[3])) : 300;
+    resetGame();
+    const float col[3] = {1.0f, 0.6f, 0.2f};
+    particles.emitBurst({0.0f, 5.0f, 0.0f}, col, n, 14.0f, 1e6f); // effectively immortal for the run
+    auto t0 = std::chrono::steady_clock::now();
+    for(int t=0;t<ticks;t++) particles.update(1.0f/60.0f, groundTopY(), &supportMap.particleFloors());
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("[particles] %zu particles x %d ticks on %d threads: %.3f ms/tick (%.1f M particle-updates/s)\n",
+        particles.size(), ticks, workerPool().threadCount(), 1000.0*s/ticks, particles.size()*(double)ticks/s/1e6);
+    return 0;
+}
+
+// --alloc-check: steady-state ticks and restarts must not touch the heap
+static int runAllocCheck(){
+#if !ALLOC_CHECK
+    std::printf("[alloc] heap counting is compiled out; rebuild with -DALLOC_CHECK=1\n");
+    std::printf("[alloc] FAIL\n");
+    return 1;
+#else
+    resetGame();
+    startSnapshots();
+    const float dt = 1.0f / 60.0f;
+    keyDown['w'] = keyDown['d'] = true; // keep the player moving through collisions
+    for(int i=0;i<120;i++){ frameArena.reset(); stepGame(dt); } // warm-up
+
+    size_t before = heapAllocCount.load();
+    SimSnapshot snap;
+    for(int i=0;i<600;i++){
+        frameArena.reset(); stepGame(dt);
+        if(rewindEnabled){ captureSnapshot(snap); history.record(snap); }
+    }
+    size_t tickAllocs = heapAllocCount.load() - before;
+
+    const void* levelBase = levelArena.base();
+    size_t levelBlocks = levelArena.blockCount();
+    before = heapAllocCount.load();
+    for(int i=0;i<10;i++) resetGame();
+    size_t restartAllocs = heapAllocCount.load() - before;
+    bool reused = levelArena.base()==levelBase && levelArena.blockCount()==levelBlocks;
+
+    std::printf("[alloc] 600 ticks: %zu heap allocations; 10 restarts: %zu heap allocations, level arena %s (%zu bytes used, peak %zu)\n",
+        tickAllocs, restartAllocs, reused ? "reused" : "reallocated", levelArena.used(), levelArena.peak());
+    bool ok = tickAllocs==0 && restartAllocs==0 && reused;
+    std::printf("[alloc] %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+#endif
+}
+
+// --rewind-check: rewinding must reproduce every recorded tick bit for bit, and replaying
+// from a rewound tick must reach the same states again. A snapshot differing from its
+// keyframe in every other byte (the costliest delta) must round-trip too.
+static int runRewindCheck(){
+    const float dt = 1.0f / 60.0f;
+    const int ticks = 3000;
+    resetGame();
+    startSnapshots();
+    if(!rewindEnabled){ std::printf("[rewind] FAIL\n"); return 1; }
+    keyDown['w'] = keyDown['d'] = true;
+
+    std::vector<SimSnapshot> truth(ticks + 1);
+    truth[0] = initialSnapshot;
+    for(int t=1;t<=ticks;t++){
+        if(t == 1500) keyDown['d'] = false, keyDown['a'] = true;
+        frameArena.reset(); stepGame(dt);
+        captureSnapshot(truth[t]);
+        history.record(truth[t]);
+    }
+    size_t held = (size_t)history.size(), bytes = history.bytes();
+
+    int rewound = 0, rewindMismatches = 0;
+    SimSnapshot snap;
+    while(rewound < 300 && history.stepBack(snap)){
+        rewound++;
+        if(std::memcmp(&snap, &truth[ticks - rewound], sizeof(SimSnapshot))) rewindMismatches++;
+    }
+    restoreSnapshot(snap);
+    int replayMismatches = 0;
+    keyDown['d'] = false; keyDown['a'] = true;
+    for(int t=ticks-rewound+1;t<=ticks;t++){
+        frameArena.reset(); stepGame(dt);
+        captureSnapshot(snap);
+        if(std::memcmp(&snap, &truth[t], sizeof(SimSnapshot))) replayMismatches++;
+    }
+
+    SimSnapshot alternating = truth[ticks], next = truth[ticks], back[2];
+    uint8_t* flip = reinterpret_cast<uint8_t*>(&alternating);
+    for(size_t i=1;i<sizeof(SimSnapshot);i+=2) flip[i] ^= 0xFF;
+    reinterpret_cast<uint8_t*>(&next)[0] ^= 1;
+    history.clear();
+    history.record(truth[ticks]); history.record(alternating); history.record(next);
+    bool worstCaseOk = history.stepBack(back[0]) && history.stepBack(back[1]) &&
+        std::memcmp(&back[0], &alternating, sizeof(SimSnapshot))==0 && std::memcmp(&back[1], &truth[ticks], sizeof(SimSnapshot))==0;
+
+    restartGame();
+    captureSnapshot(snap);
+    bool restartOk = std::memcmp(&snap, &initialSnapshot, sizeof(SimSnapshot))==0;
+
+    std::printf("[rewind] %d ticks recorded; ring holds the last %zu (%.1f s) in %zu bytes, %.0f bytes/tick vs %zu raw\n",
+        ticks, held, held/60.0, bytes, (double)bytes/held, sizeof(SimSnapshot));
+    std::printf("[rewind] %d ticks rewound: %d mismatches; replay: %d mismatches; alternating-byte delta %s; restart %s\n",
+        rewound, rewindMismatches, replayMismatches, worstCaseOk ? "round-trips" : "CORRUPTED", restartOk ? "matches initial state" : "DIFFERS");
+    bool ok = rewound==300 && !rewindMismatches && !replayMismatches && worstCaseOk && restartOk;
+    std::printf("[rewind] %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// --math-check [points]: every f4 math kernel must match its scalar reference bit for bit,
+// and the batch point transform must match the single-point one; the f4 and scalar point
+// transform times are reported, not judged, since they swing with the machine's load
+static int runMathCheck(int argc, char** argv){
+    int n = argc>2 ? std::max(1, atoi(argv[2])) : 200000;
+    uint32_t rng = 0x2545F491u;
+    auto rnd = [&](float lo, float hi){ rng ^= rng<<13; rng ^= rng>>17; rng ^= rng<<5; return lo + (hi-lo)*((rng>>8) * (1.0f/16777216.0f)); };
+    auto randomMat = [&](){ Mat4 m; for(int i=0;i<16;i++) m.m[i] = rnd(-4.0f, 4.0f); return m; };
+
+    int exactMismatches = 0;
+    for(int t=0;t<2000;t++){
+        Mat4 a = randomMat(), b = randomMat();
+        Mat4 p = mat4Mul(a, b), q = mat4MulScalar(a, b);
+        if(std::memcmp(p.m, q.m, sizeof(p.m))) exactMismatches++;
+        Vec3 v = {rnd(-50.0f, 50.0f), rnd(-50.0f, 50.0f), rnd(-50.0f, 50.0f)};
+        Vec4 s = mat4Transform(a, v), r = mat4TransformScalar(a, v);
+        if(std::memcmp(&s, &r, sizeof(Vec4))) exactMismatches++;
+        Vec4 u = makeVec4(v, rnd(-2.0f, 2.0f)), w = {rnd(-9.0f, 9.0f), rnd(-9.0f, 9.0f), rnd(-9.0f, 9.0f), rnd(-9.0f, 9.0f)};
+        Vec4 sum = add(u, w), diff = sub(u, w), scaled = mul(u, 0.37f);
+        if(sum.x != u.x + w.x || sum.y != u.y + w.y || sum.z != u.z + w.z || sum.w != u.w + w.w) exactMismatches++;
+        if(diff.x != u.x - w.x || diff.y != u.y - w.y || diff.z != u.z - w.z || diff.w != u.w - w.w) exactMismatches++;
+        if(scaled.x != u.x * 0.37f || scaled.y != u.y * 0.37f || scaled.z != u.z * 0.37f || scaled.w != u.w * 0.37f) exactMismatches++;
+    }
+
+    const Mat4 m = mat4Mul(mat4Translation(3.0f, -1.0f, 7.5f), mat4Mul(mat4Rotation(33.0f, 0.2f, 1.0f, -0.4f), mat4Scaling(1.5f, 0.75f, 2.0f)));
+    std::vector<Vec3> pts(n);
+    for(auto& p : pts) p = {rnd(-100.0f, 100.0f), rnd(-10.0f, 40.0f), rnd(-100.0f, 100.0f)};
+    std::vector<Vec4> batchOut(n), singleOut(n); // std::allocator honours alignof(Vec4)'s 16 on x86-64 and AArch64
+    transformPoints(m, &pts[0].x, sizeof(Vec3), n, batchOut.data());
+    for(int i=0;i<n;i++) singleOut[i] = mat4Transform(m, pts[i]);
+    if(std::memcmp(batchOut.data(), singleOut.data(), n * sizeof(Vec4))) exactMismatches++;
+
+    // Batches that stay in cache, both paths warm and interleaved, best of several runs
+    const int batch = std::min(n, 1024);
+    double simdBest = 1e30, scalarBest = 1e30;
+    for(int rep=0;rep<7;rep++){
+        auto t0 = std::chrono::steady_clock::now();
+        for(int b=0;b+batch<=n;b+=batch) for(int i=0;i<batch;i++) singleOut[i] = mat4Transform(m, pts[b+i]);
+        auto t1 = std::chrono::steady_clock::now();
+        for(int b=0;b+batch<=n;b+=batch) for(int i=0;i<batch;i++) batchOut[i] = mat4TransformScalar(m, pts[b+i]);
+        auto t2 = std::chrono::steady_clock::now();
+        simdBest = std::min(simdBest, std::chrono::duration<double, std::nano>(t1 - t0).count());
+        scalarBest = std::min(scalarBest, std::chrono::duration<double, std::nano>(t2 - t1).count());
+    }
+
+    const int timed = n / batch * batch;
+    const double simdNs = simdBest / timed, scalarNs = scalarBest / timed;
+    std::printf("[math] %d points: f4 transform %.2f ns/point, scalar %.2f ns/point (%.2fx)\n", timed, simdNs, scalarNs, scalarNs / std::max(1e-9, simdNs));
+    std::printf("[math] f4 vs scalar mismatches %d\n", exactMismatches);
+    bool ok = !exactMismatches;
+    std::printf("[math] %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// --stream-bench [distance]: fly a straight line across the streamed world at 5x run speed and 4x real
+// time and report loader cost, main-thread update cost, memory and holes under the player
+static int runStreamBenchmark(int argc, char** argv){
+    float distance = argc > 2 ? (float)atof(argv[2]) : 3000.0f;
+    const float dt = 1.0f / 60.0f, speed = 60.0f;
+    resetGame();
+    worldStreamer.start();
+    const Vec3 dir = {0.6f, 0.0f, 0.8f};
+    float maxLocal = 0.0f;
+    int ticks = 0, holes = 0, blocked = 0;
+    for(float walked=0.0f; walked<distance; walked+=speed*dt, ticks++){
+        playerPos = add(playerPos, mul(dir, speed*dt));
+        worldStreamer.update(playerPos);
+        int pcx = chunkCoordOf(originChunkX, playerPos.x), pcz = chunkCoordOf(originChunkZ, playerPos.z);
+        if(!worldStreamer.isLoaded(pcx, pcz)) holes++;
+        if(collidesWithWorld({playerPos, playerHalf})) blocked++;
+        maxLocal = std::max(maxLocal, std::max(std::fabs(playerPos.x), std::fabs(playerPos.z)));
+        std::this_thread::sleep_for(std::chrono::microseconds(4167));
+    }
+    WorldStreamer::Stats st = worldStreamer.statistics();
+    std::printf("[stream] %d ticks over %.0f units, origin now chunk (%d,%d) after %d rebases, max local coordinate %.1f\n",
+        ticks, distance, originChunkX, originChunkZ, st.rebases, maxLocal);
+    std::printf("[stream] loader: %d chunks built, %.3f ms avg, %.3f ms max; %d installed, %d evicted, %d discarded\n",
+        st.built, st.built ? st.buildMsTotal / st.built : 0.0, st.buildMsMax, st.installed, st.evicted, st.discarded);
+    std::printf("[stream] main thread update: %.1f us avg, %.1f us max; memory %zu KB loaded (%d chunks), peak %zu KB of %zu KB budget\n",
+        st.updates ? st.updateUsTotal / st.updates : 0.0, st.updateUsMax, worldStreamer.bytes() >> 10, worldStreamer.loadedCount(),
+        st.peakBytes >> 10, worldStreamer.budgetBytes >> 10);
+    std::printf("[stream] ticks with the player's chunk missing: %d, ticks overlapping a prop: %d\n", holes, blocked);
+    return 0;
+}
+
+// Raster benchmark scene: every platform animating, a fresh pickup burst in flight
+static void setupRasterScene(){
+    resetGame();
+    for(int i=0;i<4;i++){ features[i].allCollected = true; features[i].animEnabled = true; }
+    for(int i=0;i<90;i++){ frameArena.reset(); stepGame(1.0f/60.0f); }
+    particles.emitBurst(collectibles.empty() ? playerPos : collectibles[0].box.center, features[0].baseColor, 4000, 8.0f, 1.5f);
+    for(int i=0;i<20;i++){ frameArena.reset(); stepGame(1.0f/60.0f); }
+}
+
+static const float RASTER_SKY[3] = {0.65f, 0.7f, 0.75f};
+
+// Renders the scene through the software rasterizer; returns ms per frame
+static double renderSceneSoftware(SoftwareRasterizer& raster, int w, int h, int frames){
+    RenderBackend* saved = gfx;
+    gfx = &raster;
+    double ms = 0.0;
+    for(int f=0;f<frames;f++){
+        TelemetryRing::Clock::time_point t0 = TelemetryRing::Clock::now();
+        raster.beginFrame(w, h, RASTER_SKY[0], RASTER_SKY[1], RASTER_SKY[2]);
+        applyCamera(camMode, (double)w/(double)h);
+        drawScene(false, w, h);
+        raster.finishFrame();
+        ms += millisecondsSince(t0);
+    }
+    gfx = saved;
+    return ms / frames;
+}
+
+// Renders the same scene with GL into the current context (w x h) and reads it back,
+// bottom row first; returns ms per frame including glFinish
+static double renderSceneGL(int w, int h, int frames, std::vector<uint32_t>& out){
+    glViewport(0, 0, w, h);
+    glEnable(GL_DEPTH_TEST);
+    glShadeModel(GL_FLAT);
+    double ms = 0.0;
+    for(int f=0;f<frames;f++){
+        TelemetryRing::Clock::time_point t0 = TelemetryRing::Clock::now();
+        glClearColor(RASTER_SKY[0], RASTER_SKY[1], RASTER_SKY[2], 1);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        applyCamera(camMode, (double)w/(double)h);
+        drawScene(false, w, h);
+        glFinish();
+        ms += millisecondsSince(t0);
+    }
+    out.resize((size_t)w * h);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, out.data());
+    return ms / frames;
+}
+
+// Edge rules and colour rounding differ from the GL driver's, so a few percent of edge pixels
+// may disagree; a larger share means the software path draws something GL does not
+static const double RASTER_MAX_MISMATCH = 2.0; // percent of pixels
+
+// Share of pixels whose colour differs from the reference by more than tolerance in any channel
+static double rasterMismatch(const SoftwareRasterizer& raster, const std::vector<uint32_t>& reference, int tolerance){
+    int w = raster.width(), h = raster.height(), bad = 0;
+    for(int y=0;y<h;y++) for(int x=0;x<w;x++){
+        uint32_t a = raster.pixels()[(size_t)y*raster.stride() + x], b = reference[(size_t)y*w + x];
+        for(int c=0;c<24;c+=8)
+            if(std::abs((int)((a>>c)&0xFF) - (int)((b>>c)&0xFF)) > tolerance){ bad++; break; }
+    }
+    return 100.0 * bad / ((double)w * h);
+}
+
+static bool writeRasterPPM(const SoftwareRasterizer& raster, const char* path){
+    FILE* f = std::fopen(path, "wb");
+    if(!f) return false;
+    std::fprintf(f, "P6 %d %d 255\n", raster.width(), raster.height());
+    std::vector<unsigned char> row((size_t)raster.width() * 3);
+    for(int y=raster.height()-1;y>=0;y--){
+        const uint32_t* src = raster.pixels() + (size_t)y*raster.stride();
+        for(int x=0;x<raster.width();x++){ row[x*3] = src[x] & 0xFF; row[x*3+1] = (src[x]>>8) & 0xFF; row[x*3+2] = (src[x]>>16) & 0xFF; }
+        std::fwrite(row.data(), 1, row.size(), f);
+    }
+    return std::fclose(f) == 0;
+}
+
+static int runRasterBenchmark(int argc, char** argv){
+    int frames = argc > 2 ? std::max(1, atoi(argv[2])) : 30;
+    const char* outPath = argc > 3 ? argv[3] : nullptr;
+    const int w = 1280, h = 720;
+    setupRasterScene();
+
+    SoftwareRasterizer raster;
+    renderSceneSoftware(raster, w, h, 1); // sizes the buffers and warms the pool
+    std::vector<uint32_t> first(raster.pixels(), raster.pixels() + (size_t)raster.stride() * h);
+    double softMs = renderSceneSoftware(raster, w, h, frames);
+    // Tiles are binned and shaded on the pool: any race shows up as frames that differ
+    bool stable = std::equal(first.begin(), first.end(), raster.pixels());
+    std::printf("[raster] software: %dx%d, %zu triangles in %dx%d-pixel tiles on %d threads: %.2f ms/frame%s\n",
+        w, h, raster.triangleCount(), SoftwareRasterizer::TILE, SoftwareRasterizer::TILE, workerPool().threadCount(), softMs,
+        stable ? "" : "; FRAMES DIFFER");
+    if(outPath) std::printf("[raster] wrote %s%s\n", outPath, writeRasterPPM(raster, outPath) ? "" : " (failed)");
+
+    if(!std::getenv("DISPLAY")){
+        std::printf("[raster] no DISPLAY: skipping the GL comparison\n");
+        std::printf("[raster] %s\n", stable ? "PASS" : "FAIL");
+        return stable ? 0 : 1;
     }
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_SINGLE | GLUT_RGBA | GLUT_DEPTH);
+    glutInitWindowSize(w, h);
+    glutCreateWindow("raster-bench");
+    std::vector<uint32_t> reference;
+    renderSceneGL(w, h, 1, reference);
+    double glMs = renderSceneGL(w, h, frames, reference);
+    double mismatch = rasterMismatch(raster, reference, 8);
+    std::printf("[raster] GL (%s): %.2f ms/frame; software/GL %.2fx; %.2f%% of pixels differ by more than 8/255 (limit %.1f%%)\n",
+        (const char*)glGetString(GL_RENDERER), glMs, glMs > 0.0 ? softMs / glMs : 0.0, mismatch, RASTER_MAX_MISMATCH);
+    bool ok = stable && mismatch <= RASTER_MAX_MISMATCH;
+    std::printf("[raster] %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
 
-    glutPostRedisplay();
+// Software renders of the scene from the fixed presets and a walk of follow-camera spots,
+// with and without occlusion culling: the images must match, and the share of features,
+// oracles and collectibles skipped and the CPU cost of the buffer are reported
+static int runOcclusionBenchmark(int argc, char** argv){
+    int frames = argc > 2 ? std::max(1, atoi(argv[2])) : 20;
+    const int w = 1280, h = 720;
+    setupRasterScene();
+    const Vec3 followSpots[] = { {0.0f, 1.0f, 0.0f}, {-30.0f, 1.0f, -30.0f}, {10.0f, 1.0f, -30.0f}, {30.0f, 1.0f, -32.0f},
+                                 {-30.0f, 1.0f, 30.0f}, {30.0f, 1.0f, 30.0f}, {14.0f, 1.0f, -20.0f}, {-36.0f, 1.0f, 0.0f} };
+    struct View { CameraPreset mode; const char* name; int spot; };
+    std::vector<View> views;
+    for(int i=0;i<(int)(sizeof(followSpots)/sizeof(followSpots[0]));i++) views.push_back({CAM_FOLLOW, "follow", i});
+    views.push_back({CAM_SIDE, "side", -1});
+    views.push_back({CAM_FRONT, "front", -1});
+    views.push_back({CAM_TOP, "top", -1});
+
+    SoftwareRasterizer raster;
+    Vec3 savedPos = playerPos;
+    CameraPreset savedMode = camMode;
+    long tested = 0, culled = 0;
+    int mismatched = 0;
+    double onMs = 0.0, offMs = 0.0, bufferUs = 0.0;
+    std::vector<uint32_t> reference;
+    for(const View& v : views){
+        camMode = v.mode;
+        if(v.spot >= 0) playerPos = followSpots[v.spot];
+        occlusion.enabled = false;
+        renderSceneSoftware(raster, w, h, 1);
+        offMs += renderSceneSoftware(raster, w, h, frames);
+        reference.assign(raster.pixels(), raster.pixels() + (size_t)raster.stride() * h);
+        occlusion.enabled = true;
+        occlusion.resetStats();
+        onMs += renderSceneSoftware(raster, w, h, frames);
+        bool same = std::equal(reference.begin(), reference.end(), raster.pixels());
+        mismatched += same ? 0 : 1;
+
+        // Buffer cost alone: rebuild and test every candidate with this view's matrices
+        int viewTested = occlusion.tested / frames, viewCulled = occlusion.culled / frames, viewOccluders = occlusion.occluders / frames;
+        RenderBackend* saved = gfx;
+        gfx = &raster;
+        applyCamera(camMode, (double)w/(double)h);
+        TelemetryRing::Clock::time_point t0 = TelemetryRing::Clock::now();
+        const int reps = 200;
+        for(int r=0;r<reps;r++){
+            occlusion.build();
+            for(int i=0;i<4;i++) occlusion.visible(featureBounds(i));
+            for(const auto& o : skyOracles) occlusion.visible(skyOracleBounds(o));
+            for(const auto& c : collectibles) if(!c.collected) occlusion.visible(collectibleBounds(c));
+        }
+        double us = millisecondsSince(t0) * 1000.0 / reps;
+        gfx = saved;
+        bufferUs += us;
+        tested += viewTested; culled += viewCulled;
+        std::printf("[occlusion] %-6s", v.name);
+        if(v.spot >= 0) std::printf(" at (%5.1f, %5.1f)", playerPos.x, playerPos.z); else std::printf("               ");
+        std::printf(": %2d occluders, %2d/%2d culled, buffer %6.1f us%s\n", viewOccluders, viewCulled, viewTested, us,
+            same ? "" : "  IMAGE DIFFERS");
+    }
+    playerPos = savedPos;
+    camMode = savedMode;
+    occlusion.resetStats();
+    std::printf("[occlusion] %dx%d buffer: %.1f%% of %ld tested objects culled over %zu views; %.1f us per view for the buffer;"
+        " software frame %.2f -> %.2f ms\n", OcclusionBuffer::W, OcclusionBuffer::H, tested ? 100.0 * culled / tested : 0.0, tested,
+        views.size(), bufferUs / views.size(), offMs / views.size(), onMs / views.size());
+    std::printf("[occlusion] %s\n", mismatched ? "FAIL: culling changed the image" : "PASS: images identical with and without culling");
+    return mismatched ? 1 : 0;
 }
 
 static void keyboard(unsigned char key, int x, int y){
+    if(!keyDown[key]) latencyTracer.onInput(classifyKey(key)); // auto-repeat is not a new event
     keyDown[key] = true;
 
     if(key=='1') camMode = CAM_FOLLOW;  // Semi top-down follow camera
@@ -1433,7 +7569,11 @@ static void keyboard(unsigned char key, int x, int y){
         else if(camMode==CAM_FRONT) camMode=CAM_FREE;
         else camMode=CAM_FOLLOW;
     }
-    if(key==27) resetGame(); // ESC key to reset game
+    if(key==27) restartGame(); // ESC key to reset game
+    if(key=='p' || key=='P') navBot.enabled = !navBot.enabled; // bot autopilot
+    if(key=='f' || key=='F') framePacer.lowPower = !framePacer.lowPower;
+    if(key=='h' || key=='H'){ latencyTracer.showHud = !latencyTracer.showHud; framePacer.invalidate(); }
+    if(key=='m' || key=='M'){ multiView = !multiView; framePacer.invalidate(); }
 
     // Jump with spacebar (allowed during PLAYING and after win)
     if((key==' ') && playerOnGround && (gameState == PLAYING || gameState == WON)){
@@ -1449,29 +7589,82 @@ static void keyboard(unsigned char key, int x, int y){
     if((key=='y' || key=='Y') && features[3].allCollected) features[3].animEnabled = !features[3].animEnabled;
 }
 
-static void keyboardUp(unsigned char key, int x, int y){ keyDown[key] = false; }
+static void keyboardUp(unsigned char key, int x, int y){ latencyTracer.onInput(classifyKey(key)); keyDown[key] = false; }
 
-static void special(int key, int x, int y){ specialDown[key] = true; }
-static void specialUp(int key, int x, int y){ specialDown[key] = false; }
+static void special(int key, int x, int y){
+    if(!specialDown[key]) latencyTracer.onInput(classifySpecialKey(key));
+    specialDown[key] = true;
+}
+static void specialUp(int key, int x, int y){ latencyTracer.onInput(classifySpecialKey(key)); specialDown[key] = false; }
 
-static void reshape(int w, int h){ winW=w; winH=h>0?h:1; glViewport(0,0,winW,winH); }
+static void reshape(int w, int h){ winW=w; winH=h>0?h:1; glViewport(0,0,winW,winH); framePacer.invalidate(); staticLayer.invalidate(); }
 
 // --------------------------- Init ---------------------------
 static void initGL(){
     glEnable(GL_DEPTH_TEST);
 }
 
+#if USE_GL33
+// --gl33: the HUD glyphs come from GLUT's bitmap font, which only the fixed-function
+// pipeline can draw, so they are rasterized in a throwaway legacy window first
+static bool createCoreProfileWindow(const char* title){
+    int scratch = glutCreateWindow(title);
+    if(!rasterizeFontAtlasOffscreen(coreFontPixels)){ glutDestroyWindow(scratch); return false; }
+    glutDestroyWindow(scratch);
+
+    glutInitContextVersion(3, 3);
+    glutInitContextProfile(GLUT_CORE_PROFILE);
+    glutCreateWindow(title);
+    if(!coreBackend.init()) return false;
+    gfx = &coreBackend;
+    coreProfile = true;
+    return true;
+}
+#endif
+
 int main(int argc, char** argv){
+    subscribeGameEvents();
+    if(argc>1 && std::strcmp(argv[1], "--env-bench")==0) return runEnvBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--nav-bench")==0) return runNavBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--alloc-check")==0) return runAllocCheck();
+    if(argc>1 && std::strcmp(argv[1], "--particle-bench")==0) return runParticleBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--bvh-bench")==0) return runBvhBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--rewind-check")==0) return runRewindCheck();
+    if(argc>1 && std::strcmp(argv[1], "--stream-bench")==0) return runStreamBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--timer-bench")==0) return runTimerBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--raster-bench")==0) return runRasterBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--occlusion-bench")==0) return runOcclusionBenchmark(argc, argv);
+    if(argc>1 && std::strcmp(argv[1], "--math-check")==0) return runMathCheck(argc, argv);
+    bool gl33 = false;
+    for(int i=1;i<argc;i++){
+        if(std::strcmp(argv[i], "--fps")==0 && i+1<argc) framePacer.targetHz = (float)atof(argv[++i]);
+        else if(std::strcmp(argv[i], "--low-power")==0) framePacer.lowPower = true;
+        else if(std::strcmp(argv[i], "--telemetry")==0) telemetry.open(i+1<argc && argv[i+1][0]=='/' ? argv[++i] : TELEMETRY_DEFAULT_NAME);
+        else if(std::strcmp(argv[i], "--stream-budget")==0 && i+1<argc) worldStreamer.budgetBytes = (size_t)(atof(argv[++i]) * 1048576.0);
+        else if(std::strcmp(argv[i], "--gl33")==0) gl33 = true;
+        else if(std::strcmp(argv[i], "--quality")==0 && i+1<argc) quality.pin(atoi(argv[++i]));
+        else if(std::strcmp(argv[i], "--occlusion")==0) occlusion.enabled = true;
+    }
+    if(framePacer.targetHz > 0.0f) quality.targetHz = framePacer.targetHz;
+
     std::memset(keyDown, 0, sizeof(keyDown));
     std::memset(specialDown, 0, sizeof(specialDown));
 
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
     glutInitWindowSize(winW, winH);
-    glutCreateWindow("3D Platformer - Ancient East Asian Warriors");
+    const char* title = "3D Platformer - Ancient East Asian Warriors";
+#if USE_GL33
+    if(gl33 && !createCoreProfileWindow(title)){ std::fprintf(stderr, "[gl33] could not set up the core profile renderer\n"); return 1; }
+#else
+    if(gl33) std::fprintf(stderr, "[gl33] not available in this build; using the fixed-function renderer\n");
+#endif
+    if(!coreProfile) glutCreateWindow(title);
 
     initGL();
     resetGame();
+    worldStreamer.start();
+    startSnapshots();
     initAudioSystem();
     atexit(shutdownAudioSystem);
 
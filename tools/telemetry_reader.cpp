@@ -0,0 +1,254 @@
+// telemetry_reader.cpp
+// Live monitor for the game's shared-memory telemetry ring (start the game with --telemetry).
+// Tails the ring without ever blocking the game, aggregates the records of each interval and
+// prints one line per interval: frame rate and frame-time spread, display() and sim tick
+// cost, draw calls, occlusion culling rate and entity counts. Records it was lapped on or caught half written are
+// counted, not shown. If the game exits or restarts, the reader waits for and re-attaches
+// to the new ring.
+// Usage:
+//  telemetry_reader [/name] [--interval ms]   (default /p01_telemetry, 1000 ms)
+// Build:
+//  g++ -std=c++11 -O2 -o telemetry_reader tools/telemetry_reader.cpp -lpthread   (add -lrt on older glibc)
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Mirror of the layout in P01_13001687.cpp (Telemetry section); the header's version and
+// record size are checked on attach
+static const uint32_t TELEMETRY_MAGIC = 0x4D4C4554u; // "TELM"
+static const uint32_t TELEMETRY_VERSION = 2;
+
+enum TelemetryKind { TELEMETRY_TICK = 1, TELEMETRY_FRAME = 2 };
+
+struct TelemetryHeader {
+    uint32_t magic, version, recordSize, capacity;
+    uint64_t sessionId;
+    std::atomic<uint64_t> writeIndex;
+    uint8_t reserved[32];
+};
+
+struct TelemetryRecord {
+    std::atomic<uint64_t> seq;
+    uint64_t timeNs;
+    uint32_t kind;
+    uint32_t frame;
+    float ms;
+    float cpuMs;
+    uint32_t drawCalls;
+    uint32_t obstacles, collectiblesLeft, skyOracles, particles, chunks;
+    uint32_t occlusionTested, occlusionCulled;
+};
+
+static_assert(sizeof(TelemetryHeader) == 64 && sizeof(TelemetryRecord) == 64, "layout must match the game");
+
+// Plain copy of a record's payload
+struct Sample {
+    uint64_t timeNs;
+    uint32_t kind, frame;
+    float ms, cpuMs;
+    uint32_t drawCalls, obstacles, collectiblesLeft, skyOracles, particles, chunks;
+    uint32_t occlusionTested, occlusionCulled;
+};
+
+class RingView {
+public:
+    ~RingView(){ detach(); }
+
+    bool attach(const char* name){
+        int fd = shm_open(name, O_RDONLY, 0);
+        if(fd < 0) return false;
+        struct stat st;
+        void* mem = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(TelemetryHeader))
+            mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(mem == MAP_FAILED) return false;
+        const TelemetryHeader* h = static_cast<const TelemetryHeader*>(mem);
+        size_t need = sizeof(TelemetryHeader) + (size_t)h->capacity * sizeof(TelemetryRecord);
+        if(h->magic != TELEMETRY_MAGIC || h->version != TELEMETRY_VERSION || h->recordSize != sizeof(TelemetryRecord) ||
+           h->capacity == 0 || (h->capacity & (h->capacity - 1)) != 0 || need > (size_t)st.st_size){
+            std::fprintf(stderr, "[reader] %s: unexpected layout (magic %08x, version %u, record %u bytes)\n",
+                name, h->magic, h->version, h->recordSize);
+            munmap(mem, (size_t)st.st_size);
+            return false;
+        }
+        header = h;
+        records = reinterpret_cast<const TelemetryRecord*>(h + 1);
+        mappedBytes = (size_t)st.st_size;
+        session = h->sessionId;
+        cursor = h->writeIndex.load(std::memory_order_acquire); // tail: start from now
+        return true;
+    }
+
+    void detach(){
+        if(header) munmap(const_cast<TelemetryHeader*>(header), mappedBytes);
+        header = nullptr;
+    }
+
+    bool attached() const { return header != nullptr; }
+    // The name no longer refers to the ring we mapped: the game exited, or restarted and created a new one
+    bool replaced(const char* name) const {
+        int fd = shm_open(name, O_RDONLY, 0);
+        if(fd < 0) return true;
+        void* mem = mmap(nullptr, sizeof(TelemetryHeader), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(mem == MAP_FAILED) return true;
+        bool differs = static_cast<const TelemetryHeader*>(mem)->sessionId != session;
+        munmap(mem, sizeof(TelemetryHeader));
+        return differs;
+    }
+
+    // Reads every complete record published since the last call
+    template<class Fn>
+    void poll(Fn fn, uint64_t& lapped, uint64_t& torn){
+        uint64_t written = header->writeIndex.load(std::memory_order_acquire);
+        uint64_t capacity = header->capacity;
+        if(written < cursor) cursor = written;
+        if(written - cursor > capacity){ lapped += written - cursor - capacity; cursor = written - capacity; }
+        for(; cursor < written; cursor++){
+            const TelemetryRecord& r = records[cursor & (capacity - 1)];
+            uint64_t expect = 2*cursor + 2;
+            uint64_t s1 = r.seq.load(std::memory_order_acquire);
+            if(s1 != expect){
+                if(s1 > expect){ lapped++; continue; } // overwritten by a newer lap
+                break;                                  // not finished yet
+            }
+            Sample s = { r.timeNs, r.kind, r.frame, r.ms, r.cpuMs, r.drawCalls,
+                         r.obstacles, r.collectiblesLeft, r.skyOracles, r.particles, r.chunks,
+                         r.occlusionTested, r.occlusionCulled };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(r.seq.load(std::memory_order_relaxed) != s1){ torn++; continue; }
+            fn(s);
+        }
+    }
+
+private:
+    const TelemetryHeader* header = nullptr;
+    const TelemetryRecord* records = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t session = 0;
+    uint64_t cursor = 0;
+};
+
+struct IntervalStats {
+    std::vector<float> frameMs;
+    double displayMsSum = 0.0, tickMsSum = 0.0, idleMsSum = 0.0;
+    float displayMsMax = 0.0f, tickMsMax = 0.0f;
+    uint64_t drawCallSum = 0;
+    uint32_t drawCallMax = 0;
+    uint64_t occlusionTested = 0, occlusionCulled = 0;
+    int frames = 0, ticks = 0;
+    Sample last;
+    bool haveLast = false;
+
+    void add(const Sample& s){
+        if(s.kind == TELEMETRY_FRAME){
+            frames++;
+            if(s.ms > 0.0f) frameMs.push_back(s.ms);
+            displayMsSum += s.cpuMs;
+            displayMsMax = std::max(displayMsMax, s.cpuMs);
+            drawCallSum += s.drawCalls;
+            drawCallMax = std::max(drawCallMax, s.drawCalls);
+            occlusionTested += s.occlusionTested;
+            occlusionCulled += s.occlusionCulled;
+        } else if(s.kind == TELEMETRY_TICK){
+            ticks++;
+            tickMsSum += s.ms;
+            idleMsSum += s.cpuMs;
+            tickMsMax = std::max(tickMsMax, s.ms);
+        }
+        last = s;
+        haveLast = true;
+    }
+
+    void clear(){
+        frameMs.clear();
+        displayMsSum = tickMsSum = idleMsSum = 0.0;
+        displayMsMax = tickMsMax = 0.0f;
+        drawCallSum = 0; drawCallMax = 0;
+        occlusionTested = occlusionCulled = 0;
+        frames = ticks = 0;
+    }
+};
+
+static float percentile(std::vector<float>& v, double p){
+    if(v.empty()) return 0.0f;
+    size_t k = std::min(v.size() - 1, (size_t)(p * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+int main(int argc, char** argv){
+    const char* name = "/p01_telemetry";
+    int intervalMs = 1000;
+    for(int i=1;i<argc;i++){
+        if(std::strcmp(argv[i], "--interval")==0 && i+1<argc) intervalMs = std::max(50, std::atoi(argv[++i]));
+        else if(argv[i][0] == '/') name = argv[i];
+        else { std::fprintf(stderr, "usage: %s [/name] [--interval ms]\n", argv[0]); return 1; }
+    }
+
+    RingView ring;
+    IntervalStats stats;
+    uint64_t lapped = 0, torn = 0;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point intervalStart = Clock::now();
+    bool waiting = false;
+
+    for(;;){
+        if(!ring.attached()){
+            ring.detach();
+            if(!ring.attach(name)){
+                if(!waiting) std::fprintf(stderr, "[reader] waiting for %s (start the game with --telemetry)\n", name);
+                waiting = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                continue;
+            }
+            std::printf("[reader] attached to %s\n", name);
+            waiting = false;
+            stats.clear();
+            intervalStart = Clock::now();
+        }
+
+        ring.poll([&](const Sample& s){ stats.add(s); }, lapped, torn);
+
+        double elapsed = std::chrono::duration<double>(Clock::now() - intervalStart).count();
+        if(elapsed * 1000.0 >= intervalMs){
+            float p50 = percentile(stats.frameMs, 0.5), p99 = percentile(stats.frameMs, 0.99);
+            float worst = stats.frameMs.empty() ? 0.0f : *std::max_element(stats.frameMs.begin(), stats.frameMs.end());
+            std::printf("fps %5.1f | frame p50 %5.2f p99 %5.2f max %6.2f ms | display %5.2f/%5.2f ms | tick %5.2f/%5.2f ms, idle %5.2f ms (%d) | draws %4.0f/%4u",
+                stats.frames / elapsed, p50, p99, worst,
+                stats.frames ? stats.displayMsSum / stats.frames : 0.0, stats.displayMsMax,
+                stats.ticks ? stats.tickMsSum / stats.ticks : 0.0, stats.tickMsMax,
+                stats.ticks ? stats.idleMsSum / stats.ticks : 0.0, stats.ticks,
+                stats.frames ? (double)stats.drawCallSum / stats.frames : 0.0, stats.drawCallMax);
+            if(stats.occlusionTested)
+                std::printf(" | occluded %4.1f%% of %llu", 100.0 * stats.occlusionCulled / stats.occlusionTested,
+                    (unsigned long long)stats.occlusionTested);
+            if(stats.haveLast)
+                std::printf(" | obstacles %u collectibles %u oracles %u particles %u chunks %u",
+                    stats.last.obstacles, stats.last.collectiblesLeft, stats.last.skyOracles, stats.last.particles, stats.last.chunks);
+            if(lapped || torn) std::printf(" | lost %llu torn %llu", (unsigned long long)lapped, (unsigned long long)torn);
+            std::printf("\n");
+            std::fflush(stdout);
+            stats.clear();
+            intervalStart = Clock::now();
+            if(ring.replaced(name)){
+                std::printf("[reader] %s was replaced or removed; re-attaching\n", name);
+                ring.detach();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}